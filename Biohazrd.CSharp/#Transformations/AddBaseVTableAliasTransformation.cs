@@ -13,7 +13,7 @@ namespace Biohazrd.CSharp
             {
                 // We expect the base field to be at 0
                 if (declaration.NonVirtualBaseField.Offset != 0)
-                { return declaration.WithWarning("Record has VTable without a VTable field and a base which is not at offset 0."); }
+                { return declaration.WithWarning(context, "Record has VTable without a VTable field and a base which is not at offset 0."); }
 
                 return declaration with { VTableField = new TranslatedVTableField(declaration.NonVirtualBaseField) };
             }
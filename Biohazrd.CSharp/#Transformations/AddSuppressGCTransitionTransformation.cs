@@ -0,0 +1,30 @@
+﻿using Biohazrd.CSharp.Metadata;
+using Biohazrd.Transformation;
+using System;
+
+namespace Biohazrd.CSharp
+{
+    /// <summary>Adds <see cref="SuppressGCTransitionFunction"/> to functions selected by a predicate.</summary>
+    /// <remarks>
+    /// Suppressing the GC transition is only safe for trivial functions, so this transformation is opt-in on a function-by-function basis.
+    /// <see cref="CSharpTranslationVerifier"/> will warn about selected functions which are likely to be unsafe to call without a GC transition.
+    /// </remarks>
+    public sealed class AddSuppressGCTransitionTransformation : TransformationBase
+    {
+        private readonly Func<TransformationContext, TranslatedFunction, bool> Predicate;
+
+        public AddSuppressGCTransitionTransformation(Func<TransformationContext, TranslatedFunction, bool> predicate)
+            => Predicate = predicate;
+
+        protected override TransformationResult TransformFunction(TransformationContext context, TranslatedFunction declaration)
+        {
+            if (declaration.Metadata.Has<SuppressGCTransitionFunction>() || !Predicate(context, declaration))
+            { return declaration; }
+
+            return declaration with
+            {
+                Metadata = declaration.Metadata.Add<SuppressGCTransitionFunction>()
+            };
+        }
+    }
+}
@@ -8,6 +8,11 @@ namespace Biohazrd.CSharp
 {
     public sealed class CSharpBuiltinTypeTransformation : TypeTransformationBase
     {
+        // Builtin types are always mapped the same way regardless of where they're used
+        protected override bool MemoizeTypeTransformations => true;
+        protected override bool IsTransformTypeContextFree(TypeReference type)
+            => true;
+
         protected override TypeTransformationResult TransformClangTypeReference(TypeTransformationContext context, ClangTypeReference type)
         {
             ClangType clangType = type.ClangType;
@@ -1,6 +1,8 @@
 ﻿using Biohazrd.CSharp.Metadata;
 using Biohazrd.Expressions;
 using Biohazrd.Transformation;
+using System;
+using System.Collections.Immutable;
 using System.Linq;
 
 namespace Biohazrd.CSharp
@@ -18,15 +20,11 @@ namespace Biohazrd.CSharp
             // If this declaration is at the root, ensure we're using an access level that's valid at this scope
             if (context.ParentDeclaration is null && !declaration.Accessibility.IsAllowedInNamespaceScope())
             {
-                declaration = declaration with
-                {
-                    Diagnostics = declaration.Diagnostics.Add
-                    (
-                        Severity.Warning,
-                        $"Declaration translated as {declaration.Accessibility.ToCSharpKeyword()}, but it will be translated into a file/namespace scope. Accessibility forced to internal."
-                    ),
-                    Accessibility = AccessModifier.Internal
-                };
+                declaration = (declaration with { Accessibility = AccessModifier.Internal }).WithWarning
+                (
+                    context,
+                    $"Declaration translated as {declaration.Accessibility.ToCSharpKeyword()}, but it will be translated into a file/namespace scope. Accessibility forced to internal."
+                );
             }
 
             // Currently everything is translated as structs and static classes, neither of which support protected.
@@ -35,15 +33,11 @@ namespace Biohazrd.CSharp
                 case AccessModifier.Protected:
                 case AccessModifier.ProtectedAndInternal:
                 case AccessModifier.ProtectedOrInternal:
-                    declaration = declaration with
-                    {
-                        Diagnostics = declaration.Diagnostics.Add
-                        (
-                            Severity.Warning,
-                            $"Declaration translated as {declaration.Accessibility.ToCSharpKeyword()}, but protected isn't supported yet. Accessibility forced to internal."
-                        ),
-                        Accessibility = AccessModifier.Internal
-                    };
+                    declaration = (declaration with { Accessibility = AccessModifier.Internal }).WithWarning
+                    (
+                        context,
+                        $"Declaration translated as {declaration.Accessibility.ToCSharpKeyword()}, but protected isn't supported yet. Accessibility forced to internal."
+                    );
                     break;
             }
 
@@ -59,15 +53,11 @@ namespace Biohazrd.CSharp
             // If the type is not supported, we force it to be translated as loose constants and add a warning to it.
             if (!declaration.TranslateAsLooseConstants && declaration.UnderlyingType is not CSharpBuiltinTypeReference { Type: { IsValidUnderlyingEnumType: true } })
             {
-                declaration = declaration with
-                {
-                    TranslateAsLooseConstants = true,
-                    Diagnostics = declaration.Diagnostics.Add
-                    (
-                        Severity.Warning,
-                        $"Enum declaration had an underlying type of '{declaration.UnderlyingType}', which is not supported by C#."
-                    )
-                };
+                declaration = (declaration with { TranslateAsLooseConstants = true }).WithWarning
+                (
+                    context,
+                    $"Enum declaration had an underlying type of '{declaration.UnderlyingType}', which is not supported by C#."
+                );
             }
 
             return base.TransformEnum(context, declaration);
@@ -76,7 +66,7 @@ namespace Biohazrd.CSharp
         protected override TransformationResult TransformEnumConstant(TransformationContext context, TranslatedEnumConstant declaration)
         {
             if (context.ParentDeclaration is not TranslatedEnum)
-            { declaration = declaration.WithError($"Enum constants are not valid outside of a enum context."); }
+            { declaration = declaration.WithError(context, $"Enum constants are not valid outside of a enum context."); }
 
             return base.TransformEnumConstant(context, declaration);
         }
@@ -86,29 +76,141 @@ namespace Biohazrd.CSharp
             //TODO: Verify return type is compatible
             //TODO: We might want to check if they can be resolved in an extra pass due to BrokenDeclarationExtractor.
             if (!context.IsValidFieldOrMethodContext())
-            { declaration = declaration.WithError("Loose functions are not supported in C#."); }
+            { declaration = declaration.WithError(context, "Loose functions are not supported in C#."); }
+
+            if (declaration.IsVirtual && !declaration.IsDevirtualized && declaration.Metadata.Has<SetLastErrorFunction>())
+            { declaration = declaration.WithWarning(context, "SetLastError is not supported on virtual methods and will be ignored."); }
 
-            if (declaration.IsVirtual && declaration.Metadata.Has<SetLastErrorFunction>())
-            { declaration = declaration.WithWarning("SetLastError is not supported on virtual methods and will be ignored."); }
+            if (declaration.Metadata.Has<SuppressGCTransitionFunction>())
+            { declaration = VerifySuppressGCTransition(context, declaration); }
+
+            if (declaration.Metadata.Has<BatchableFunction>())
+            { declaration = VerifyBatchableFunction(context, declaration); }
 
             return base.TransformFunction(context, declaration);
         }
 
+        private TranslatedFunction VerifyBatchableFunction(TransformationContext context, TranslatedFunction declaration)
+        {
+            if (!BatchedCallShims.CanBatch(declaration, out string? reason))
+            { return declaration.WithWarning(context, $"{reason} No batched overload will be generated."); }
+
+            // Pointers are all batched as IntPtr, so overloads which only differ by pointer types would get batched overloads with the same signature
+            // We skip all of the conflicting overloads rather than picking one arbitrarily.
+            ImmutableArray<TypeReference> signature = BatchedCallShims.GetBatchedSignature(declaration);
+            foreach (TranslatedDeclaration sibling in context.Parent)
+            {
+                if (sibling is not TranslatedFunction overload || overload.Id == declaration.Id || overload.Name != declaration.Name)
+                { continue; }
+
+                if (!overload.Metadata.Has<BatchableFunction>() || !BatchedCallShims.CanBatch(overload, out _))
+                { continue; }
+
+                if (BatchedCallShims.GetBatchedSignature(overload).SequenceEqual(signature))
+                {
+                    declaration = declaration with { Metadata = declaration.Metadata.Remove<BatchableFunction>() };
+                    return declaration.WithWarning(context, $"The batched overload would have the same signature as the one for another overload of {declaration.Name}. No batched overload will be generated.");
+                }
+            }
+
+            return declaration;
+        }
+
+        /// <summary>Words which suggest a function might block, which is not allowed when the GC transition is suppressed.</summary>
+        private static readonly string[] PotentiallyBlockingNameWords = { "Wait", "Sleep", "Lock", "Join", "Flush", "Sync", "Synchronize", "Yield", "Acquire" };
+
+        private static bool IsWordBoundary(string name, int i)
+        {
+            char previous = name[i - 1];
+            char current = name[i];
+
+            if (!Char.IsLetterOrDigit(previous) || !Char.IsLetterOrDigit(current))
+            { return true; }
+
+            // camelCase/PascalCase (IE: `getValue` is `get` `Value`)
+            if (Char.IsLower(previous) && Char.IsUpper(current))
+            { return true; }
+
+            if (Char.IsDigit(previous) != Char.IsDigit(current))
+            { return true; }
+
+            // The last capital of an acronym starts the next word (IE: `HTTPWait` is `HTTP` `Wait`)
+            if (Char.IsUpper(previous) && Char.IsUpper(current) && i + 1 < name.Length && Char.IsLower(name[i + 1]))
+            { return true; }
+
+            return false;
+        }
+
+        /// <summary>Determines whether <paramref name="name"/> contains <paramref name="word"/> as a whole word, where words are delimited by underscores and camelCase/PascalCase boundaries.</summary>
+        private static bool ContainsWord(string name, string word)
+        {
+            int wordStart = 0;
+            for (int i = 1; i <= name.Length; i++)
+            {
+                if (i < name.Length && !IsWordBoundary(name, i))
+                { continue; }
+
+                if (name.AsSpan(wordStart, i - wordStart).Equals(word, StringComparison.OrdinalIgnoreCase))
+                { return true; }
+
+                wordStart = i;
+            }
+
+            return false;
+        }
+
+        private static TranslatedFunction VerifySuppressGCTransition(TransformationContext context, TranslatedFunction declaration)
+        {
+            if (declaration.IsVirtual && !declaration.IsDevirtualized)
+            { return declaration.WithWarning(context, "SuppressGCTransition is not supported on virtual methods and will be ignored."); }
+
+            // Functions which take callbacks might call back into managed code, which will crash the runtime without a GC transition
+            foreach (TranslatedParameter parameter in declaration.Parameters)
+            {
+                TypeReference parameterType = parameter.Type;
+                while (parameterType is PointerTypeReference pointerType)
+                { parameterType = pointerType.Inner; }
+
+                if (parameterType is FunctionPointerTypeReference)
+                {
+                    declaration = declaration.WithWarning
+                    (
+                        context,
+                        $"SuppressGCTransition is applied to a function which takes a callback ('{parameter.Name}'). If the callback is a managed function, calling it will corrupt the runtime."
+                    );
+                    break;
+                }
+            }
+
+            // We have no way to know for sure if a function blocks, but we can warn about ones which sound like they might
+            // (Only whole words are considered so that names like `GetClock` or `IsSynced` aren't flagged.)
+            foreach (string word in PotentiallyBlockingNameWords)
+            {
+                if (ContainsWord(declaration.Name, word))
+                {
+                    declaration = declaration.WithWarning
+                    (
+                        context,
+                        "SuppressGCTransition is applied to a function which looks like it might block. Blocking without a GC transition can stall the garbage collector for the entire process."
+                    );
+                    break;
+                }
+            }
+
+            return declaration;
+        }
+
         protected override TransformationResult TransformParameter(TransformationContext context, TranslatedParameter declaration)
         {
             //TODO: Verify type is compatible
             if (context.ParentDeclaration is not TranslatedFunction)
-            { declaration = declaration.WithError("Function parameters are not valid outside of a function context."); }
+            { declaration = declaration.WithError(context, "Function parameters are not valid outside of a function context."); }
 
             // Verify default parameter value is compatible
             switch (declaration.DefaultValue)
             {
                 case StringConstant:
-                    return declaration with
-                    {
-                        DefaultValue = null,
-                        Diagnostics = declaration.Diagnostics.Add(Severity.Warning, "String constants are not supported as default parameter values.")
-                    };
+                    return (declaration with { DefaultValue = null }).WithWarning(context, "String constants are not supported as default parameter values.");
                 case UnsupportedConstantExpression:
                     // No diagnostic here, it was already emitted during the initial translation
                     return declaration with
@@ -138,11 +240,7 @@ namespace Biohazrd.CSharp
 
                     if (declaration.DefaultValue is not null && !TypeCanHaveDefaultInCSharp(context, declaration.Type))
                     {
-                        return declaration with
-                        {
-                            DefaultValue = null,
-                            Diagnostics = declaration.Diagnostics.Add(Severity.Warning, $"Default parameter values are not supported for this parameter's type.")
-                        };
+                        return (declaration with { DefaultValue = null }).WithWarning(context, $"Default parameter values are not supported for this parameter's type.");
                     }
 
                     // Default parameter value is allowed
@@ -154,12 +252,12 @@ namespace Biohazrd.CSharp
         protected override TransformationResult TransformRecord(TransformationContext context, TranslatedRecord declaration)
         {
             if (declaration.UnsupportedMembers.Count > 0)
-            { declaration = declaration.WithWarning("Records with unsupported members may not be translated correctly."); }
+            { declaration = declaration.WithWarning(context, "Records with unsupported members may not be translated correctly."); }
 
             if (declaration.VTable is null && declaration.VTableField is not null)
-            { declaration = declaration.WithError("Records should not have a VTable field without a VTable."); }
+            { declaration = declaration.WithError(context, "Records should not have a VTable field without a VTable."); }
             else if (declaration.VTable is not null && declaration.VTableField is null)
-            { declaration = declaration.WithError("Records should not have a VTable without a VTable field."); }
+            { declaration = declaration.WithError(context, "Records should not have a VTable without a VTable field."); }
 
             return base.TransformRecord(context, declaration);
         }
@@ -178,14 +276,14 @@ namespace Biohazrd.CSharp
                     break;
             }
 
-            return declaration.WithError($"Bit fields must by typed by an integral C# built-in type or an enum with an integral underlying type. {declaration.Type} is neither.");
+            return declaration.WithError(context, $"Bit fields must by typed by an integral C# built-in type or an enum with an integral underlying type. {declaration.Type} is neither.");
         }
 
         protected override TransformationResult TransformStaticField(TransformationContext context, TranslatedStaticField declaration)
         {
             //TODO: Verify type is compatible
             if (!context.IsValidFieldOrMethodContext())
-            { declaration = declaration.WithError("Loose fields are not supported in C#."); }
+            { declaration = declaration.WithError(context, "Loose fields are not supported in C#."); }
 
             return base.TransformStaticField(context, declaration);
         }
@@ -199,8 +297,8 @@ namespace Biohazrd.CSharp
 
         protected override TransformationResult TransformUnsupportedDeclaration(TransformationContext context, TranslatedUnsupportedDeclaration declaration)
         {
-            if (!declaration.Diagnostics.All(d => d.IsError))
-            { declaration = declaration.WithError($"Declarations not supported by Biohazrd cannot be translated to C#."); }
+            if (!context.GetDiagnostics(declaration).All(d => d.IsError))
+            { declaration = declaration.WithError(context, $"Declarations not supported by Biohazrd cannot be translated to C#."); }
 
             return base.TransformUnsupportedDeclaration(context, declaration);
         }
@@ -208,13 +306,13 @@ namespace Biohazrd.CSharp
         protected override TransformationResult TransformVTable(TransformationContext context, TranslatedVTable declaration)
         {
             if (context.ParentDeclaration is not TranslatedRecord recordParent)
-            { declaration = declaration.WithError("VTables must be the child of a record."); }
+            { declaration = declaration.WithError(context, "VTables must be the child of a record."); }
             else if (!ReferenceEquals(recordParent.VTable, declaration))
             {
                 if (recordParent.VTable is null)
-                { declaration = declaration.WithError("VTables must be associated with the record as VTables."); }
+                { declaration = declaration.WithError(context, "VTables must be associated with the record as VTables."); }
                 else
-                { declaration = declaration.WithError("Multiple VTables are not yet supported."); }
+                { declaration = declaration.WithError(context, "Multiple VTables are not yet supported."); }
             }
 
             return base.TransformVTable(context, declaration);
@@ -223,7 +321,7 @@ namespace Biohazrd.CSharp
         protected override TransformationResult TransformField(TransformationContext context, TranslatedField declaration)
         {
             if (!context.IsValidFieldOrMethodContext())
-            { declaration = declaration.WithError("Loose fields are not supported in C#."); }
+            { declaration = declaration.WithError(context, "Loose fields are not supported in C#."); }
 
             // Fields in C++ can have the same name as their enclosing type, but this isn't allowed in C# (it results in CS0542)
             // When we encounter such fields, we rename them to avoid the error.
@@ -235,10 +333,7 @@ namespace Biohazrd.CSharp
                 { newName += "_"; }
                 while (context.Parent.Any(d => d.Name == newName));
 
-                declaration = declaration with
-                {
-                    Diagnostics = declaration.Diagnostics.Add(Severity.Warning, $"Field has the same name as its enclosing type, renamed to '{newName}' to avoid conflict.")
-                };
+                declaration = declaration.WithWarning(context, $"Field has the same name as its enclosing type, renamed to '{newName}' to avoid conflict.");
             }
 
             return base.TransformField(context, declaration);
@@ -250,9 +345,9 @@ namespace Biohazrd.CSharp
             if (context.ParentDeclaration is TranslatedRecord recordParent)
             {
                 if (recordParent.NonVirtualBaseField is null)
-                { declaration = declaration.WithError("Base fields must be associated with the record as the non-virtual base field."); }
+                { declaration = declaration.WithError(context, "Base fields must be associated with the record as the non-virtual base field."); }
                 else if (!ReferenceEquals(recordParent.NonVirtualBaseField, declaration))
-                { declaration = declaration.WithError("Multiple bases are not yet supported."); }
+                { declaration = declaration.WithError(context, "Multiple bases are not yet supported."); }
             }
 
             return base.TransformBaseField(context, declaration);
@@ -262,7 +357,7 @@ namespace Biohazrd.CSharp
             //TODO: Verify type is compatible
             => base.TransformNormalField(context, declaration);
         protected override TransformationResult TransformUnimplementedField(TransformationContext context, TranslatedUnimplementedField declaration)
-            => base.TransformUnimplementedField(context, declaration.WithWarning($"{declaration.Kind} fields are not yet supported."));
+            => base.TransformUnimplementedField(context, declaration.WithWarning(context, $"{declaration.Kind} fields are not yet supported."));
         protected override TransformationResult TransformVTableField(TransformationContext context, TranslatedVTableField declaration)
             => base.TransformVTableField(context, declaration);
     }
@@ -44,15 +44,12 @@ namespace Biohazrd.CSharp
 
                 if (parameter.DefaultValue is not null)
                 {
-                    newParameters[i] = parameter with
-                    {
-                        DefaultValue = null,
-                        Diagnostics = newParameters[i].Diagnostics.Add
-                        (
-                            Severity.Warning,
-                            $"Dropped default parameter value '{parameter.DefaultValue}' because parameter comes before non-defaulted parameter '{lastNonDefaultParameter.Name}'."
-                        )
-                    };
+                    newParameters[i] = context.AddDiagnostic
+                    (
+                        parameter with { DefaultValue = null },
+                        Severity.Warning,
+                        $"Dropped default parameter value '{parameter.DefaultValue}' because parameter comes before non-defaulted parameter '{lastNonDefaultParameter.Name}'."
+                    );
                 }
 
                 i++;
@@ -35,16 +35,17 @@ namespace Biohazrd.CSharp
 
         protected override TranslatedLibrary PostTransformLibrary(TranslatedLibrary library)
         {
-            library = library with
-            {
-                Declarations = library.Declarations.AddRange(NewConstantArrayTypes.OrderBy(t => t.Name))
-            };
+            library = library.Edit(edit => edit.AddRange(NewConstantArrayTypes.OrderBy(t => t.Name)));
 
             ConstantArrayTypesCreated = NewConstantArrayTypes.Count;
+            return base.PostTransformLibrary(library);
+        }
+
+        protected override void ResetTransformationState()
+        {
             ConstantArrayTypes.Clear();
             NewConstantArrayTypes.Clear();
-
-            return base.PostTransformLibrary(library);
+            base.ResetTransformationState();
         }
 
         private ConstantArrayTypeDeclaration GetOrCreateConstantArrayTypeDeclaration(ConstantArrayType constantArrayType)
@@ -81,6 +82,10 @@ namespace Biohazrd.CSharp
             return result;
         }
 
+        // Unlike the base transformation, constant arrays are always reduced to the same declaration regardless of context
+        protected override bool IsTransformTypeContextFree(TypeReference type)
+            => type is ClangTypeReference { ClangType: ConstantArrayType } || base.IsTransformTypeContextFree(type);
+
         protected override TypeTransformationResult TransformClangTypeReference(TypeTransformationContext context, ClangTypeReference type)
         {
             switch (type.ClangType)
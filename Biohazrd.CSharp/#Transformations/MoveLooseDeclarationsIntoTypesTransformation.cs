@@ -4,41 +4,80 @@ using System.Collections.Generic;
 using System.Collections.Immutable;
 using System.Diagnostics;
 using System.IO;
+using System.Linq;
 using System.Runtime.CompilerServices;
 
 namespace Biohazrd.CSharp
 {
     public sealed class MoveLooseDeclarationsIntoTypesTransformation : TransformationBase
     {
-        // containingTypeName => declarations
-        private readonly Dictionary<string, List<TranslatedDeclaration>> LooseDeclarationsLookup = new();
-        private readonly HashSet<TranslatedDeclaration> AllLooseDeclarations = new(ReferenceEqualityComparer.Instance);
+        // The plan for the library currently being transformed, this is created by PreTransformLibrary and is never modified during the transformation.
+        private LooseDeclarationsPlan? Plan;
         private readonly RemoveLooseDeclarationsTransformation RemovePass;
 
         private readonly Func<VisitorContext, TranslatedDeclaration, string?>? TypeNameProvider;
 
-        protected override bool SupportsConcurrency => false;
-
         public MoveLooseDeclarationsIntoTypesTransformation()
             => RemovePass = new RemoveLooseDeclarationsTransformation(this);
 
+        /// <remarks>The type name provider may be invoked concurrently from multiple threads.</remarks>
         public MoveLooseDeclarationsIntoTypesTransformation(Func<VisitorContext, TranslatedDeclaration, string?> typeNameProvider)
             : this()
             => TypeNameProvider = typeNameProvider;
 
+        private sealed class LooseDeclarationsPlan
+        {
+            /// <summary>All loose declarations which should be removed from their original location.</summary>
+            public ImmutableHashSet<TranslatedDeclaration> AllLooseDeclarations { get; }
+
+            /// <summary>Existing records which will receive loose declarations.</summary>
+            public ImmutableDictionary<TranslatedRecord, ImmutableList<TranslatedDeclaration>> RecordAdditions { get; }
+
+            /// <summary>Loose declarations which need a synthesized type to contain them, in the order they were first encountered.</summary>
+            public ImmutableArray<(string TypeName, ImmutableList<TranslatedDeclaration> Declarations)> SynthesizedTypes { get; }
+
+            /// <summary>Loose declarations (as they were before being moved) which had to be renamed to avoid colliding with their containing type.</summary>
+            public ImmutableArray<TranslatedDeclaration> RenamedDeclarations { get; }
+
+            public LooseDeclarationsPlan
+            (
+                ImmutableHashSet<TranslatedDeclaration> allLooseDeclarations,
+                ImmutableDictionary<TranslatedRecord, ImmutableList<TranslatedDeclaration>> recordAdditions,
+                ImmutableArray<(string TypeName, ImmutableList<TranslatedDeclaration> Declarations)> synthesizedTypes,
+                ImmutableArray<TranslatedDeclaration> renamedDeclarations
+            )
+            {
+                AllLooseDeclarations = allLooseDeclarations;
+                RecordAdditions = recordAdditions;
+                SynthesizedTypes = synthesizedTypes;
+                RenamedDeclarations = renamedDeclarations;
+            }
+        }
 
         [MethodImpl(MethodImplOptions.AggressiveInlining)]
         private static bool DeclarationCouldBeLoose(TranslatedDeclaration declaration)
             // Functions and fields must be nested under a type in C#, so they can be loose
             => declaration is TranslatedFunction or TranslatedStaticField or TranslatedField;
 
+        private string GetLooseDeclarationsTypeName(VisitorContext context, TranslatedDeclaration declaration)
+        {
+            string? looseDeclarationsTypeName = TypeNameProvider?.Invoke(context, declaration);
+
+            if (String.IsNullOrEmpty(looseDeclarationsTypeName))
+            { looseDeclarationsTypeName = Path.GetFileNameWithoutExtension(declaration.File.FilePath); }
+
+            if (String.IsNullOrEmpty(looseDeclarationsTypeName))
+            { looseDeclarationsTypeName = "LooseDeclarations"; }
+
+            return looseDeclarationsTypeName;
+        }
+
         protected override TranslatedLibrary PreTransformLibrary(TranslatedLibrary library)
         {
-            // Ensure our lookup is empty
-            Debug.Assert(LooseDeclarationsLookup.Count == 0, "The state of this transformaiton should be empty at this point.");
-            LooseDeclarationsLookup.Clear();
+            Debug.Assert(Plan is null, "The state of this transformaiton should be empty at this point.");
 
             // Enumerate all loose declarations
+            List<(VisitorContext Context, TranslatedDeclaration Declaration)> looseDeclarations = new();
             foreach ((VisitorContext context, TranslatedDeclaration declaration) in library.EnumerateRecursivelyWithContext())
             {
                 // Skip declarations which can't be loose
@@ -49,70 +88,130 @@ namespace Biohazrd.CSharp
                 if (context.IsValidFieldOrMethodContext())
                 { continue; }
 
-                // Determine the name for the containing type
-                string? looseDeclarationsTypeName = TypeNameProvider?.Invoke(context, declaration);
+                looseDeclarations.Add((context, declaration));
+            }
+
+            // Determine the name for the containing type of each loose declaration
+            // This is done in parallel since the type name provider may be arbitrarily expensive, the results are kept in the order the declarations were enumerated.
+            string[] looseDeclarationsTypeNames = looseDeclarations.AsParallel().AsOrdered()
+                .Select(d => GetLooseDeclarationsTypeName(d.Context, d.Declaration))
+                .ToArray();
 
-                if (String.IsNullOrEmpty(looseDeclarationsTypeName))
-                { looseDeclarationsTypeName = Path.GetFileNameWithoutExtension(declaration.File.FilePath); }
+            // Group the loose declarations by their containing type name
+            // containingTypeName => declarations
+            Dictionary<string, ImmutableList<TranslatedDeclaration>.Builder> looseDeclarationsLookup = new();
+            List<string> looseDeclarationsTypeNameOrder = new();
+            ImmutableHashSet<TranslatedDeclaration>.Builder allLooseDeclarations = ImmutableHashSet.CreateBuilder<TranslatedDeclaration>(ReferenceEqualityComparer.Instance);
+            ImmutableArray<TranslatedDeclaration>.Builder renamedDeclarations = ImmutableArray.CreateBuilder<TranslatedDeclaration>();
 
-                if (String.IsNullOrEmpty(looseDeclarationsTypeName))
-                { looseDeclarationsTypeName = "LooseDeclarations"; }
+            for (int i = 0; i < looseDeclarations.Count; i++)
+            {
+                TranslatedDeclaration declaration = looseDeclarations[i].Declaration;
+                string looseDeclarationsTypeName = looseDeclarationsTypeNames[i];
 
                 // Add the loose declaration to the lookup
-                List<TranslatedDeclaration>? declarationsForName;
-                if (!LooseDeclarationsLookup.TryGetValue(looseDeclarationsTypeName, out declarationsForName))
+                ImmutableList<TranslatedDeclaration>.Builder? declarationsForName;
+                if (!looseDeclarationsLookup.TryGetValue(looseDeclarationsTypeName, out declarationsForName))
                 {
-                    declarationsForName = new List<TranslatedDeclaration>();
-                    LooseDeclarationsLookup.Add(looseDeclarationsTypeName, declarationsForName);
+                    declarationsForName = ImmutableList.CreateBuilder<TranslatedDeclaration>();
+                    looseDeclarationsLookup.Add(looseDeclarationsTypeName, declarationsForName);
+                    looseDeclarationsTypeNameOrder.Add(looseDeclarationsTypeName);
                 }
 
                 // If the declaration has the same name as the type it will be contained in, rename it since that's not allowed
                 // (We normally rely on C++ not allowing this either, but that doesn't work in this context since we're synthesizing types.)
+                // The warning for the rename is added in PostTransformLibrary once the declaration is in its new home.
                 TranslatedDeclaration declarationToAdd = declaration;
                 if (declaration.Name == looseDeclarationsTypeName)
                 {
-                    declarationToAdd = declaration with
-                    {
-                        Name = $"{declaration.Name}__",
-                        Diagnostics = declaration.Diagnostics.Add(Severity.Warning, $"{declaration} automatically renamed to avoid collision with containing type.")
-                    };
+                    declarationToAdd = declaration with { Name = $"{declaration.Name}__" };
+                    renamedDeclarations.Add(declaration);
                 }
 
                 declarationsForName.Add(declarationToAdd);
-                AllLooseDeclarations.Add(declaration); // This is intentionally declaration, since this set is used to remove the old declarations.
+                allLooseDeclarations.Add(declaration); // This is intentionally declaration, since this set is used to remove the old declarations.
             }
 
             // Remove pass runs first so that removal and associating declarations with existing types don't interact
             // (If we do them in the same pass, the declarations will be removed immediately after adding them.)
-            return RemovePass.Transform(library);
+            Plan = new LooseDeclarationsPlan
+            (
+                allLooseDeclarations.ToImmutable(),
+                ImmutableDictionary<TranslatedRecord, ImmutableList<TranslatedDeclaration>>.Empty,
+                ImmutableArray<(string, ImmutableList<TranslatedDeclaration>)>.Empty,
+                renamedDeclarations.ToImmutable()
+            );
+            library = RemovePass.Transform(library);
+
+            // Determine which existing records will receive loose declarations
+            // The first record with a matching name (in the order they will be transformed) receives them.
+            ImmutableDictionary<TranslatedRecord, ImmutableList<TranslatedDeclaration>>.Builder recordAdditions = ImmutableDictionary.CreateBuilder<TranslatedRecord, ImmutableList<TranslatedDeclaration>>(ReferenceEqualityComparer.Instance);
+
+            if (looseDeclarationsLookup.Count > 0)
+            {
+                foreach (TranslatedDeclaration declaration in library.EnumerateRecursively())
+                {
+                    if (declaration is TranslatedRecord record && looseDeclarationsLookup.Remove(record.Name, out ImmutableList<TranslatedDeclaration>.Builder? declarationsForRecord))
+                    {
+                        recordAdditions.Add(record, declarationsForRecord.ToImmutable());
+
+                        if (looseDeclarationsLookup.Count == 0)
+                        { break; }
+                    }
+                }
+            }
+
+            // Any remaining loose declarations will go into synthesized types
+            ImmutableArray<(string TypeName, ImmutableList<TranslatedDeclaration> Declarations)>.Builder synthesizedTypes = ImmutableArray.CreateBuilder<(string, ImmutableList<TranslatedDeclaration>)>(looseDeclarationsLookup.Count);
+            foreach (string typeName in looseDeclarationsTypeNameOrder)
+            {
+                if (looseDeclarationsLookup.TryGetValue(typeName, out ImmutableList<TranslatedDeclaration>.Builder? declarations))
+                { synthesizedTypes.Add((typeName, declarations.ToImmutable())); }
+            }
+
+            Plan = new LooseDeclarationsPlan(Plan.AllLooseDeclarations, recordAdditions.ToImmutable(), synthesizedTypes.MoveToImmutable(), Plan.RenamedDeclarations);
+            return library;
         }
 
         protected override TranslatedLibrary PostTransformLibrary(TranslatedLibrary library)
         {
+            Debug.Assert(Plan is not null, "There should be a plan at this point.");
+
             // Synthesize types to contain any remaining declarations
-            if (LooseDeclarationsLookup.Count > 0)
+            if (Plan.SynthesizedTypes.Length > 0)
             {
-                ImmutableList<TranslatedDeclaration>.Builder synthesizedDeclarations = ImmutableList.CreateBuilder<TranslatedDeclaration>();
-                foreach ((string typeName, List<TranslatedDeclaration> declarations) in LooseDeclarationsLookup)
+                LooseDeclarationsPlan plan = Plan;
+                library = library.Edit(edit =>
                 {
-                    synthesizedDeclarations.Add(new SynthesizedLooseDeclarationsTypeDeclaration(declarations[0].File)
+                    foreach ((string typeName, ImmutableList<TranslatedDeclaration> declarations) in plan.SynthesizedTypes)
                     {
-                        Name = typeName,
-                        Members = declarations.ToImmutableList()
-                    });
-                }
+                        edit.Add(new SynthesizedLooseDeclarationsTypeDeclaration(declarations[0].File)
+                        {
+                            Name = typeName,
+                            Members = declarations
+                        });
+                    }
+                });
+            }
 
-                // Add the synthesized types to the library
-                library = library with
-                { Declarations = library.Declarations.AddRange(synthesizedDeclarations) };
+            // Warn about any declarations which were renamed
+            // This goes through the edit builder so the warnings are recorded the same way as those from any other transformation. (IE: In the diagnostic log if the library has one.)
+            if (Plan.RenamedDeclarations.Length > 0)
+            {
+                LooseDeclarationsPlan plan = Plan;
+                library = library.Edit(edit =>
+                {
+                    foreach (TranslatedDeclaration declaration in plan.RenamedDeclarations)
+                    { edit.AddDiagnostic(declaration, Severity.Warning, $"{declaration} automatically renamed to avoid collision with containing type."); }
+                });
             }
 
-            // Wipe out the state and return the modified library
-            LooseDeclarationsLookup.Clear();
-            AllLooseDeclarations.Clear();
             return library;
         }
 
+        protected override void ResetTransformationState()
+            => Plan = null;
+
         private sealed class RemoveLooseDeclarationsTransformation : TransformationBase
         {
             private readonly MoveLooseDeclarationsIntoTypesTransformation ParentTransformation;
@@ -122,8 +221,10 @@ namespace Biohazrd.CSharp
 
             protected override TransformationResult TransformDeclaration(TransformationContext context, TranslatedDeclaration declaration)
             {
+                Debug.Assert(ParentTransformation.Plan is not null, "The remove pass should only run while there's a plan.");
+
                 // If this declaration was one of the enumerated loose declarations we remove it
-                if (DeclarationCouldBeLoose(declaration) && ParentTransformation.AllLooseDeclarations.Remove(declaration))
+                if (DeclarationCouldBeLoose(declaration) && ParentTransformation.Plan.AllLooseDeclarations.Contains(declaration))
                 { return null; }
                 else
                 { return declaration; }
@@ -132,8 +233,10 @@ namespace Biohazrd.CSharp
 
         protected override TransformationResult TransformRecord(TransformationContext context, TranslatedRecord declaration)
         {
-            // If this record matches one of the container names for any loose declarations, add them to this record
-            if (LooseDeclarationsLookup.Remove(declaration.Name, out List<TranslatedDeclaration>? looseDeclarations))
+            Debug.Assert(Plan is not null, "There should be a plan at this point.");
+
+            // If this record was chosen to contain any loose declarations, add them to this record
+            if (Plan.RecordAdditions.TryGetValue(declaration, out ImmutableList<TranslatedDeclaration>? looseDeclarations))
             {
                 declaration = declaration with { Members = declaration.Members.AddRange(looseDeclarations) };
             }
@@ -6,57 +6,64 @@ namespace Biohazrd.CSharp
 {
     public sealed class WrapNonBlittableTypesWhereNecessaryTransformation : CSharpTypeTransformationBase
     {
-        private NativeBooleanDeclaration? NativeBoolean = null;
-        private TranslatedTypeReference? NativeBooleanReference = null;
-        private bool NativeBooleanIsNew = false;
-        private bool NativeBooleanWasUsed = false;
-        private NativeCharDeclaration? NativeChar = null;
-        private TranslatedTypeReference? NativeCharRefertence = null;
-        private bool NativeCharIsNew = false;
-        private bool NativeCharwasUsed = false;
+        // The native declarations for the library currently being transformed, this is determined by PreTransformLibrary and is never modified during the transformation.
+        private NativeDeclarationsPlan? Plan = null;
+
+        // These flags are only ever set to true during the transformation, so they don't need any synchronization beyond being volatile.
+        private volatile bool NativeBooleanWasUsed = false;
+        private volatile bool NativeCharWasUsed = false;
+
+        /// <summary>If true, <c>bool</c> and <c>char</c> are wrapped everywhere outside of pointers rather than only where they appear in function pointers.</summary>
+        /// <remarks>
+        /// This makes every function signature and record in the library blittable, which is required when generating with <see cref="CSharpGenerationOptions.DisableRuntimeMarshalling"/>
+        /// in order to guarantee the runtime never needs to generate a marshaling stub.
+        /// </remarks>
+        public bool WrapAllNonBlittableTypes { get; init; }
+
+        private sealed class NativeDeclarationsPlan
+        {
+            public NativeBooleanDeclaration NativeBoolean { get; }
+            public TranslatedTypeReference NativeBooleanReference { get; }
+            public bool NativeBooleanIsNew { get; }
+            public NativeCharDeclaration NativeChar { get; }
+            public TranslatedTypeReference NativeCharReference { get; }
+            public bool NativeCharIsNew { get; }
+
+            public NativeDeclarationsPlan(NativeBooleanDeclaration? existingNativeBoolean, NativeCharDeclaration? existingNativeChar)
+            {
+                // Create new declarations if needed
+                NativeBooleanIsNew = existingNativeBoolean is null;
+                NativeBoolean = existingNativeBoolean ?? new NativeBooleanDeclaration();
+                NativeBooleanReference = TranslatedTypeReference.Create(NativeBoolean);
+
+                NativeCharIsNew = existingNativeChar is null;
+                NativeChar = existingNativeChar ?? new NativeCharDeclaration();
+                NativeCharReference = TranslatedTypeReference.Create(NativeChar);
+            }
+        }
 
         protected override TranslatedLibrary PreTransformLibrary(TranslatedLibrary library)
         {
-            Debug.Assert(NativeBoolean is null, "The native declarations should be available at this point.");
-            Debug.Assert(NativeChar is null, "The native declarations should be available at this point.");
-            Debug.Assert(NativeBooleanReference is null, "The native declaration references should be available at this point.");
-            Debug.Assert(NativeCharRefertence is null, "The native declaration references should be available at this point.");
-            NativeBoolean = null;
-            NativeChar = null;
-            NativeBooleanIsNew = false;
-            NativeCharIsNew = false;
+            Debug.Assert(Plan is null, "The native declarations from the previous library should have been cleared at this point.");
             NativeBooleanWasUsed = false;
-            NativeCharwasUsed = false;
+            NativeCharWasUsed = false;
 
             // Find any existing declarations
+            NativeBooleanDeclaration? existingNativeBoolean = null;
+            NativeCharDeclaration? existingNativeChar = null;
             foreach (TranslatedDeclaration declaration in library.EnumerateRecursively())
             {
-                if (NativeBoolean is null && declaration is NativeBooleanDeclaration nativeBoolean)
-                { NativeBoolean = nativeBoolean; }
+                if (existingNativeBoolean is null && declaration is NativeBooleanDeclaration nativeBoolean)
+                { existingNativeBoolean = nativeBoolean; }
 
-                if (NativeChar is null && declaration is NativeCharDeclaration nativeChar)
-                { NativeChar = nativeChar; }
+                if (existingNativeChar is null && declaration is NativeCharDeclaration nativeChar)
+                { existingNativeChar = nativeChar; }
 
-                if (NativeBoolean is not null && NativeChar is not null)
+                if (existingNativeBoolean is not null && existingNativeChar is not null)
                 { break; }
             }
 
-            // Create new declarations if needed
-            if (NativeBoolean is null)
-            {
-                NativeBoolean = new NativeBooleanDeclaration();
-                NativeBooleanIsNew = true;
-            }
-
-            if (NativeChar is null)
-            {
-                NativeChar = new NativeCharDeclaration();
-                NativeCharIsNew = true;
-            }
-
-            NativeBooleanReference = TranslatedTypeReference.Create(NativeBoolean);
-            NativeCharRefertence = TranslatedTypeReference.Create(NativeChar);
-
+            Plan = new NativeDeclarationsPlan(existingNativeBoolean, existingNativeChar);
             return library;
         }
 
@@ -67,20 +74,21 @@ namespace Biohazrd.CSharp
             { return type; }
 
             // If the parent type reference isn't a function pointer, Blittablebool/BlittableChar should not be necessary
-            if (!context.Parents.Any(t => t is FunctionPointerTypeReference))
+            // (Unless we've been asked to make everything blittable.)
+            if (!WrapAllNonBlittableTypes && !context.Parents.Any(t => t is FunctionPointerTypeReference))
             { return type; }
 
+            Debug.Assert(Plan is not null, "The native declarations should be available at this point.");
+
             if (type.Type == CSharpBuiltinType.Bool)
             {
                 NativeBooleanWasUsed = true;
-                Debug.Assert(NativeBooleanReference is not null);
-                return NativeBooleanReference;
+                return Plan.NativeBooleanReference;
             }
             else if (type.Type == CSharpBuiltinType.Char)
             {
-                NativeCharwasUsed = true;
-                Debug.Assert(NativeCharRefertence is not null);
-                return NativeCharRefertence;
+                NativeCharWasUsed = true;
+                return Plan.NativeCharReference;
             }
             else
             { return type; }
@@ -88,28 +96,22 @@ namespace Biohazrd.CSharp
 
         protected override TranslatedLibrary PostTransformLibrary(TranslatedLibrary library)
         {
-            Debug.Assert(NativeBoolean is not null, "We should have native declarations at this point.");
-            Debug.Assert(NativeChar is not null, "We should have native declarations at this point.");
+            Debug.Assert(Plan is not null, "We should have native declarations at this point.");
 
-            if (NativeBooleanIsNew && NativeBooleanWasUsed)
+            NativeDeclarationsPlan plan = Plan;
+            library = library.Edit(edit =>
             {
-                library = library with
-                {
-                    Declarations = library.Declarations.Add(NativeBoolean)
-                };
-            }
+                if (plan.NativeBooleanIsNew && NativeBooleanWasUsed)
+                { edit.Add(plan.NativeBoolean); }
 
-            if (NativeCharIsNew && NativeCharwasUsed)
-            {
-                library = library with
-                {
-                    Declarations = library.Declarations.Add(NativeChar)
-                };
-            }
+                if (plan.NativeCharIsNew && NativeCharWasUsed)
+                { edit.Add(plan.NativeChar); }
+            });
 
-            NativeBoolean = null;
-            NativeChar = null;
             return library;
         }
+
+        protected override void ResetTransformationState()
+            => Plan = null;
     }
 }
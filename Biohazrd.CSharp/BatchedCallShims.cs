@@ -0,0 +1,116 @@
+﻿using Biohazrd.CSharp.Metadata;
+using ClangSharp;
+using ClangSharp.Interop;
+using System.Collections.Immutable;
+using System.Diagnostics.CodeAnalysis;
+using System.Text;
+
+namespace Biohazrd.CSharp
+{
+    /// <summary>Shared logic for the native shims and managed overloads generated for <see cref="BatchableFunction"/>.</summary>
+    /// <remarks>The shim is emitted by several independent generators, so they all need to agree on which functions get one and what it's named.</remarks>
+    internal static class BatchedCallShims
+    {
+        /// <summary>Determines if a batched call shim should be emitted for the given function.</summary>
+        public static bool ShouldEmit(TranslatedFunction function)
+            => function.Metadata.Has<BatchableFunction>() && CanBatch(function, out _);
+
+        /// <remarks>
+        /// This is called from output generators and transformations which run in parallel, so it only uses the Biohazrd declaration and the raw Clang cursors.
+        /// (ClangSharp's object model is populated lazily and is not thread-safe.)
+        /// </remarks>
+        public static bool CanBatch(TranslatedFunction function, [NotNullWhen(false)] out string? reason)
+        {
+            if (function.Declaration is not FunctionDecl functionDeclaration)
+            {
+                reason = "Only functions which come from Clang can be batched.";
+                return false;
+            }
+
+            if (functionDeclaration is CXXConstructorDecl or CXXDestructorDecl)
+            {
+                reason = "Constructors and destructors cannot be batched.";
+                return false;
+            }
+
+            // The shim needs to be able to call the function
+            if (functionDeclaration.Handle.CXXAccessSpecifier is CX_CXXAccessSpecifier.CX_CXXPrivate or CX_CXXAccessSpecifier.CX_CXXProtected)
+            {
+                reason = "Non-public methods cannot be batched.";
+                return false;
+            }
+
+            if (function.ReturnByReference || functionDeclaration.Handle.ResultType.CanonicalType.kind is CXTypeKind.CXType_LValueReference or CXTypeKind.CXType_RValueReference)
+            {
+                reason = "Functions which return by reference cannot be batched.";
+                return false;
+            }
+
+            for (int i = 0; i < functionDeclaration.Handle.NumArguments; i++)
+            {
+                CXCursor parameter = functionDeclaration.Handle.GetArgument((uint)i);
+                if (parameter.Type.CanonicalType.kind == CXTypeKind.CXType_RValueReference)
+                {
+                    reason = $"Parameter '{parameter.Spelling}' is an rvalue reference, which cannot be batched.";
+                    return false;
+                }
+            }
+
+            // There must be at least one span to determine how many calls to make
+            if (!function.IsInstanceMethod && function.Parameters.Length == 0 && function.ReturnType is VoidTypeReference)
+            {
+                reason = "Functions without parameters or a return value cannot be batched.";
+                return false;
+            }
+
+            reason = null;
+            return true;
+        }
+
+        /// <summary>Gets the element types of the spans taken by the batched overload of the given function, in order.</summary>
+        /// <remarks>
+        /// Pointers are batched as <c>IntPtr</c> regardless of what they point to, so they are all represented by <see cref="VoidTypeReference.PointerInstance"/>.
+        /// As such, two overloads with the same name and batched signature will produce batched overloads which conflict.
+        /// </remarks>
+        public static ImmutableArray<TypeReference> GetBatchedSignature(TranslatedFunction function)
+        {
+            static TypeReference GetElementType(TypeReference type)
+                => type is PointerTypeReference or FunctionPointerTypeReference ? VoidTypeReference.PointerInstance : type;
+
+            ImmutableArray<TypeReference>.Builder builder = ImmutableArray.CreateBuilder<TypeReference>();
+
+            if (function.IsInstanceMethod)
+            { builder.Add(VoidTypeReference.PointerInstance); }
+
+            foreach (TranslatedParameter parameter in function.Parameters)
+            { builder.Add(GetElementType(parameter.Type)); }
+
+            if (function.ReturnType is not VoidTypeReference)
+            { builder.Add(GetElementType(function.ReturnType)); }
+
+            return builder.ToImmutable();
+        }
+
+        /// <summary>Gets the name of the exported batched call shim for the given function.</summary>
+        /// <remarks>
+        /// The name is derived from the mangled name of the function so that it's unique and stable, with any characters which aren't valid in a C identifier escaped.
+        /// The managed import for the shim uses the same name so that it's unique among overloads too.
+        /// </remarks>
+        public static string GetShimName(TranslatedFunction function)
+        {
+            StringBuilder builder = new("__batch_");
+
+            foreach (char c in function.MangledName)
+            {
+                if (c == '_')
+                { builder.Append("__"); }
+                else if (c is (>= 'a' and <= 'z') or (>= 'A' and <= 'Z') or (>= '0' and <= '9'))
+                { builder.Append(c); }
+                else
+                { builder.Append($"_{(int)c:X2}"); }
+            }
+
+            return builder.ToString();
+        }
+    }
+}
@@ -36,18 +36,13 @@ namespace Biohazrd.CSharp
             => context.Parent.IsValidFieldOrMethodParent();
 
         // On the fence about this being built-in, so it's an extension method for now
-        internal static TDeclaration WithError<TDeclaration>(this TDeclaration declaration, string errorMessage)
+        // (These go through the context so that the diagnostics can be recorded in the library's diagnostic log when it has one.)
+        internal static TDeclaration WithError<TDeclaration>(this TDeclaration declaration, TransformationContext context, string errorMessage)
             where TDeclaration : TranslatedDeclaration
-            => declaration with
-            {
-                Diagnostics = declaration.Diagnostics.Add(Severity.Error, errorMessage)
-            };
+            => context.AddDiagnostic(declaration, Severity.Error, errorMessage);
 
-        internal static TDeclaration WithWarning<TDeclaration>(this TDeclaration declaration, string warningMessage)
+        internal static TDeclaration WithWarning<TDeclaration>(this TDeclaration declaration, TransformationContext context, string warningMessage)
             where TDeclaration : TranslatedDeclaration
-            => declaration with
-            {
-                Diagnostics = declaration.Diagnostics.Add(Severity.Warning, warningMessage)
-            };
+            => context.AddDiagnostic(declaration, Severity.Warning, warningMessage);
     }
 }
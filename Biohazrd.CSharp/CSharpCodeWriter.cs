@@ -330,7 +330,11 @@ namespace Biohazrd.CSharp
         protected override void WriteBetweenHeaderAndCode(StreamWriter writer)
         {
             foreach (string usingNamespace in UsingNamespaces)
-            { writer.WriteLine($"using {usingNamespace};"); }
+            {
+                writer.Write("using ");
+                writer.Write(usingNamespace);
+                writer.WriteLine(';');
+            }
 
             if (UsingNamespaces.Count > 0)
             { writer.WriteLine(); }
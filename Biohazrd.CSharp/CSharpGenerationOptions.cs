@@ -9,6 +9,51 @@ namespace Biohazrd.CSharp
 
         public bool HideTrampolinesFromDebugger { get; init; } = true;
 
+        /// <summary>Controls how non-virtual native functions are imported.</summary>
+        /// <remarks>
+        /// The function pointer table modes avoid the startup and JIT cost of the runtime generating and resolving a marshalling stub for every <c>[DllImport]</c>.
+        /// Functions which use <see cref="Metadata.SetLastErrorFunction"/> are always imported using <c>[DllImport]</c>.
+        /// Static fields are always resolved through the same per-library import tables, which are lazy unless <see cref="NativeFunctionImportMode.EagerFunctionPointerTable"/> is used.
+        /// </remarks>
+        public NativeFunctionImportMode FunctionImportMode { get; init; } = NativeFunctionImportMode.DllImport;
+
+        /// <summary>If true, libraries translated to more than one file will have their files generated in parallel.</summary>
+        /// <remarks>
+        /// Generation is always serial when <see cref="DumpClangInfo"/> is enabled since Clang's object model is not thread-safe.
+        ///
+        /// The generated files are identical either way, but custom declarations (<see cref="Infrastructure.ICustomCSharpTranslatedDeclaration"/>) must be safe to emit from multiple threads.
+        /// </remarks>
+        public bool ParallelGeneration { get; init; } = true;
+
+        /// <summary>If true, the generated library is marked with <c>[assembly: DisableRuntimeMarshalling]</c>.</summary>
+        /// <remarks>
+        /// Marshaling hints such as <c>CharSet.Unicode</c> and <c>MarshalAs(UnmanagedType.I1)</c> are only emitted under <c>#if !NET7_0_OR_GREATER</c> in this mode
+        /// since the runtime does not honor them when runtime marshaling is disabled.
+        /// You should run <see cref="WrapNonBlittableTypesWhereNecessaryTransformation"/> with <see cref="WrapNonBlittableTypesWhereNecessaryTransformation.WrapAllNonBlittableTypes"/>
+        /// enabled so that every signature is blittable without relying on the runtime's interpretation of <c>bool</c> and <c>char</c>.
+        ///
+        /// <c>DisableRuntimeMarshallingAttribute</c> is only available in .NET 7 and later, so the attribute is only applied when the consuming project targets one of those runtimes.
+        /// On older runtimes the marshaler still runs, so the hints are kept to preserve the native ABI.
+        /// </remarks>
+        public bool DisableRuntimeMarshalling { get; init; }
+
+        /// <summary>If true, the generated library is marked with <c>[module: SkipLocalsInit]</c>.</summary>
+        /// <remarks>
+        /// The attribute is only applied when the consuming project targets .NET 5 or later since it isn't available on older runtimes.
+        /// Leave this disabled if the consuming project already applies the attribute, since it can only be applied to a module once.
+        /// </remarks>
+        public bool SkipLocalsInit { get; init; }
+
+        /// <summary>If true, records will be emitted with <c>LayoutKind.Sequential</c> when it is known to reproduce their native layout exactly.</summary>
+        /// <remarks>
+        /// The JIT can promote sequential structs to registers but not explicit ones, so this can improve the performance of small value types such as vectors.
+        ///
+        /// Each record emitted with sequential layout gets a method which verifies its layout at runtime. All of them are called by <c>SequentialLayoutSelfCheck.Verify</c>,
+        /// which you should call from your tests or during startup in debug builds. (Nested records are verified by their containing record's method.)
+        /// Records whose method can't be reached from <c>SequentialLayoutSelfCheck.Verify</c> always use explicit layout.
+        /// </remarks>
+        public bool UseSequentialLayoutWhenPossible { get; init; }
+
         public CSharpGenerationOptions()
         {
 #if DEBUG
@@ -0,0 +1,145 @@
+﻿using System.Collections.Generic;
+using static Biohazrd.CSharp.CSharpCodeWriter;
+
+namespace Biohazrd.CSharp
+{
+    partial class CSharpLibraryGenerator
+    {
+        private void EmitBatchedCallOverload(VisitorContext context, TranslatedFunction declaration)
+        {
+            VisitorContext parameterContext = context.Add(declaration);
+            bool hasReturnValue = declaration.ReturnType is not VoidTypeReference;
+            string importName = BatchedCallShims.GetShimName(declaration);
+
+            // Pick names for the extra spans which don't conflict with the parameters
+            HashSet<string> usedNames = new();
+            foreach (TranslatedParameter parameter in declaration.Parameters)
+            { usedNames.Add(parameter.Name); }
+
+            string GetUniqueName(string name)
+            {
+                while (!usedNames.Add(name))
+                { name = $"_{name}"; }
+
+                return name;
+            }
+
+            string instancesName = GetUniqueName("instances");
+            string resultsName = GetUniqueName("results");
+            string countName = GetUniqueName("count");
+
+            // Pointers can't be used as generic type arguments, so they're batched as IntPtr instead
+            void WriteElementType(VisitorContext context, TranslatedDeclaration declaration, TypeReference type)
+            {
+                if (type is PointerTypeReference or FunctionPointerTypeReference)
+                { Writer.Write("IntPtr"); }
+                else
+                { WriteType(context, declaration, type); }
+            }
+
+            // Emit the import for the native shim
+            Writer.Using("System"); // IntPtr, ReadOnlySpan<T>, Span<T>, ArgumentException
+            Writer.Using("System.Runtime.InteropServices");
+            Writer.EnsureSeparation();
+            Writer.WriteLine($"[DllImport(\"{SanitizeStringLiteral(declaration.DllFileName)}\", CallingConvention = CallingConvention.Cdecl, EntryPoint = \"{importName}\", ExactSpelling = true)]");
+            // (The import uses the same names as the overload so that they can't conflict with the parameters either.)
+            Writer.Write($"private static extern void {importName}(nuint {SanitizeIdentifier(countName)}");
+
+            if (declaration.IsInstanceMethod)
+            { Writer.Write($", IntPtr* {SanitizeIdentifier(instancesName)}"); }
+
+            foreach (TranslatedParameter parameter in declaration.Parameters)
+            {
+                Writer.Write(", ");
+                WriteElementType(parameterContext, parameter, parameter.Type);
+                Writer.Write("* ");
+                Writer.WriteIdentifier(parameter.Name);
+            }
+
+            if (hasReturnValue)
+            {
+                Writer.Write(", ");
+                WriteElementType(context, declaration, declaration.ReturnType);
+                Writer.Write($"* {SanitizeIdentifier(resultsName)}");
+            }
+
+            Writer.WriteLine(");");
+
+            // Emit the batched overload
+            List<string> spanNames = new();
+            Writer.EnsureSeparation();
+            Writer.WriteLine($"/// <summary>Calls <see cref=\"{SanitizeIdentifier(declaration.Name)}\"/> once for each element of the given spans using a single native call.</summary>");
+            Writer.Write($"{declaration.Accessibility.ToCSharpKeyword()} static unsafe void {SanitizeIdentifier(declaration.Name)}(");
+
+            if (declaration.IsInstanceMethod)
+            {
+                Writer.Write($"ReadOnlySpan<IntPtr> {SanitizeIdentifier(instancesName)}");
+                spanNames.Add(instancesName);
+            }
+
+            foreach (TranslatedParameter parameter in declaration.Parameters)
+            {
+                if (spanNames.Count > 0)
+                { Writer.Write(", "); }
+
+                Writer.Write("ReadOnlySpan<");
+                WriteElementType(parameterContext, parameter, parameter.Type);
+                Writer.Write("> ");
+                Writer.WriteIdentifier(parameter.Name);
+                spanNames.Add(parameter.Name);
+            }
+
+            if (hasReturnValue)
+            {
+                if (spanNames.Count > 0)
+                { Writer.Write(", "); }
+
+                Writer.Write("Span<");
+                WriteElementType(context, declaration, declaration.ReturnType);
+                Writer.Write($"> {SanitizeIdentifier(resultsName)}");
+                spanNames.Add(resultsName);
+            }
+
+            Writer.WriteLine(')');
+            using (Writer.Block())
+            {
+                Writer.WriteLine($"int {SanitizeIdentifier(countName)} = {SanitizeIdentifier(spanNames[0])}.Length;");
+
+                for (int i = 1; i < spanNames.Count; i++)
+                {
+                    string spanName = SanitizeIdentifier(spanNames[i]);
+                    Writer.WriteLine();
+                    Writer.WriteLine($"if ({spanName}.Length != {SanitizeIdentifier(countName)})");
+                    Writer.WriteLine($"{{ throw new ArgumentException(\"All spans must have the same length.\", nameof({spanName})); }}");
+                }
+
+                Writer.WriteLine();
+
+                // Pin all of the spans
+                void WriteFixed(VisitorContext context, TranslatedDeclaration declaration, TypeReference type, string spanName)
+                {
+                    Writer.Write("fixed (");
+                    WriteElementType(context, declaration, type);
+                    Writer.WriteLine($"* __{spanName} = {SanitizeIdentifier(spanName)})");
+                }
+
+                if (declaration.IsInstanceMethod)
+                { Writer.WriteLine($"fixed (IntPtr* __{instancesName} = {SanitizeIdentifier(instancesName)})"); }
+
+                foreach (TranslatedParameter parameter in declaration.Parameters)
+                { WriteFixed(parameterContext, parameter, parameter.Type, parameter.Name); }
+
+                if (hasReturnValue)
+                { WriteFixed(context, declaration, declaration.ReturnType, resultsName); }
+
+                // Call the shim
+                Writer.Write($"{{ {importName}((nuint){SanitizeIdentifier(countName)}");
+
+                foreach (string spanName in spanNames)
+                { Writer.Write($", __{spanName}"); }
+
+                Writer.WriteLine("); }");
+            }
+        }
+    }
+}
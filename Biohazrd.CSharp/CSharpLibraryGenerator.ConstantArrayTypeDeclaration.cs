@@ -4,8 +4,7 @@ namespace Biohazrd.CSharp
 {
     partial class CSharpLibraryGenerator
     {
-        private bool HasWrittenAnyConstantArrayTypeDeclarations = false;
-        private const string ConstantArrayEnumeratorName = "ConstantArrayEnumerator";
+        private bool HasWrittenConstantArrayOfPointersEnumerator = false;
         private const string ConstantArrayOfPointersEnumeratorName = "ConstantArrayOfPointersEnumerator";
 
         protected override void VisitConstantArrayType(VisitorContext context, ConstantArrayTypeDeclaration declaration)
@@ -13,15 +12,21 @@ namespace Biohazrd.CSharp
             const string element0Name = "Element0";
             const string element0PointerName = "Element0Pointer";
 
-            // If this is the first constant array type we've written out, write out the enumerator helpers
-            if (!HasWrittenAnyConstantArrayTypeDeclarations)
+            // Pointers cannot be used as generic type arguments, so arrays of pointers can't use spans or Unsafe and need their own enumerator
+            bool isArrayOfPointers = declaration.Type is PointerTypeReference;
+
+            // If this is the first constant array of pointers we've written out, write out the enumerator helper
+            if (isArrayOfPointers && !HasWrittenConstantArrayOfPointersEnumerator)
             {
-                HasWrittenAnyConstantArrayTypeDeclarations = true;
-                WriteOutConstantArrayEnumerators();
+                HasWrittenConstantArrayOfPointersEnumerator = true;
+                WriteOutConstantArrayOfPointersEnumerator();
             }
 
-            Writer.Using("System"); // IndexOutOfRangeException, IntPtr
-            Writer.Using("System.Runtime.InteropServices"); // StructLayoutAttribute, FieldOffsetAttribute
+            Writer.Using("System"); // IndexOutOfRangeException, IntPtr, Span<T>, ReadOnlySpan<T>, MemoryExtensions
+            Writer.Using("System.Runtime.InteropServices"); // StructLayoutAttribute, FieldOffsetAttribute, MemoryMarshal
+
+            if (!isArrayOfPointers)
+            { Writer.Using("System.Runtime.CompilerServices"); } // Unsafe
 
             Writer.EnsureSeparation();
             Writer.WriteLine($"[StructLayout(LayoutKind.Explicit, Size = {declaration.SizeBytes})]");
@@ -36,17 +41,26 @@ namespace Biohazrd.CSharp
 
                 // Write out the 0th element pointer getter
                 // (This assumes that these unmanaged constant arrays are never stored on the managed heap.)
+                // Unsafe.AsPointer lets the JIT fold the address computation into the access rather than pinning on every access, but it can't be used with pointers.
                 Writer.EnsureSeparation();
-                Writer.WriteLine($"private {elementType}* {element0PointerName}");
-                using (Writer.Block())
+                if (isArrayOfPointers)
                 {
-                    Writer.WriteLine("get");
+                    Writer.WriteLine($"private {elementType}* {element0PointerName}");
                     using (Writer.Block())
                     {
-                        Writer.WriteLine($"fixed ({elementType}* p{element0Name} = &{element0Name})");
-                        Writer.WriteLine($"{{ return p{element0Name}; }}");
+                        Writer.WriteLine("get");
+                        using (Writer.Block())
+                        {
+                            Writer.WriteLine($"fixed ({elementType}* p{element0Name} = &{element0Name})");
+                            Writer.WriteLine($"{{ return p{element0Name}; }}");
+                        }
                     }
                 }
+                else
+                {
+                    Writer.WriteLine($"private {elementType}* {element0PointerName}");
+                    Writer.WriteLineIndented($"=> ({elementType}*)Unsafe.AsPointer(ref {element0Name});");
+                }
 
                 // Write out the indexer
                 Writer.EnsureSeparation();
@@ -72,87 +86,82 @@ namespace Biohazrd.CSharp
                 Writer.WriteLine($"public override string ToString()");
                 Writer.WriteLineIndented($"=> $\"{{typeof({elementType})}}[{elementCount}]\";");
 
-                // Write out ToArray
-                Writer.EnsureSeparation();
-                Writer.WriteLine($"public {elementType}[] ToArray()");
-                using (Writer.Block())
+                if (isArrayOfPointers)
                 {
-                    Writer.WriteLine($"{elementType}[] result = new {elementType}[{elementCount}];");
-                    Writer.WriteLine();
-                    Writer.WriteLine($"for (int i = 0; i < {elementCount}; i++)");
-                    Writer.WriteLine("{ result[i] = this[i]; }");
-                    Writer.WriteLine();
-                    Writer.WriteLine("return result;");
-                }
+                    // Write out ToArray
+                    Writer.EnsureSeparation();
+                    Writer.WriteLine($"public {elementType}[] ToArray()");
+                    using (Writer.Block())
+                    {
+                        Writer.WriteLine($"{elementType}[] result = new {elementType}[{elementCount}];");
+                        Writer.WriteLine();
+                        Writer.WriteLine($"for (int i = 0; i < {elementCount}; i++)");
+                        Writer.WriteLine("{ result[i] = this[i]; }");
+                        Writer.WriteLine();
+                        Writer.WriteLine("return result;");
+                    }
 
-                // Write out AsSpan
-                // (Can't do this when the element type is a pointer because you can't use pointers as generic type arguments.)
-                if (declaration.Type is not PointerTypeReference)
+                    // Write out GetEnumerator
+                    // (Can't do this when the element type is a double pointer)
+                    if (declaration.Type is PointerTypeReference { Inner: not PointerTypeReference } pointerElementType)
+                    {
+                        string enumeratorType = $"{ConstantArrayOfPointersEnumeratorName}<{GetTypeAsString(context, declaration, pointerElementType.Inner)}>";
+                        Writer.EnsureSeparation();
+                        Writer.WriteLine($"public {enumeratorType} GetEnumerator()");
+                        Writer.WriteLineIndented($"=> new {enumeratorType}({element0PointerName}, {elementCount});");
+                    }
+                }
+                else
                 {
+                    // Write out the span accessors
+                    // The span is created from a reference derived from a pointer so that the span is not considered to be scoped to `this` under any version of C#'s ref safety rules.
+                    // (As with Element0Pointer, this is fine because these arrays never live on the managed heap.)
+                    // Since the length is a constant, the JIT can elide the bounds checks on spans which don't escape, allowing loops over them to be unrolled or vectorized.
                     Writer.EnsureSeparation();
                     Writer.WriteLine($"public Span<{elementType}> AsSpan()");
-                    Writer.WriteLineIndented($"=> new Span<{elementType}>({element0PointerName}, {elementCount});");
-                }
+                    Writer.WriteLineIndented($"=> MemoryMarshal.CreateSpan(ref Unsafe.AsRef<{elementType}>({element0PointerName}), {elementCount});");
 
-                // Write out GetEnumerator
-                // (Can't do this when the element type is a double pointer)
-                if (declaration.Type is not PointerTypeReference { Inner: PointerTypeReference })
-                {
-                    string enumeratorType;
-                    if (declaration.Type is PointerTypeReference pointerElementType)
-                    { enumeratorType = $"{ConstantArrayOfPointersEnumeratorName}<{GetTypeAsString(context, declaration, pointerElementType.Inner)}>"; }
-                    else
-                    { enumeratorType = $"{ConstantArrayEnumeratorName}<{elementType}>"; }
+                    Writer.EnsureSeparation();
+                    Writer.WriteLine($"public ReadOnlySpan<{elementType}> AsReadOnlySpan()");
+                    Writer.WriteLineIndented($"=> MemoryMarshal.CreateReadOnlySpan(ref Unsafe.AsRef<{elementType}>({element0PointerName}), {elementCount});");
+
+                    // Write out CopyTo and ToArray
+                    // (These use the span helpers so that they are a single vectorized memmove.)
+                    Writer.EnsureSeparation();
+                    Writer.WriteLine($"public void CopyTo(Span<{elementType}> destination)");
+                    Writer.WriteLineIndented("=> AsReadOnlySpan().CopyTo(destination);");
 
                     Writer.EnsureSeparation();
-                    Writer.WriteLine($"public {enumeratorType} GetEnumerator()");
-                    Writer.WriteLineIndented($"=> new {enumeratorType}({element0PointerName}, {elementCount});");
+                    Writer.WriteLine($"public bool TryCopyTo(Span<{elementType}> destination)");
+                    Writer.WriteLineIndented("=> AsReadOnlySpan().TryCopyTo(destination);");
+
+                    Writer.EnsureSeparation();
+                    Writer.WriteLine($"public {elementType}[] ToArray()");
+                    Writer.WriteLineIndented("=> AsReadOnlySpan().ToArray();");
+
+                    // Write out SequenceEqual
+                    // (MemoryExtensions.SequenceEqual requires IEquatable<T>, which only the builtin types are guaranteed to implement.)
+                    if (declaration.Type is CSharpBuiltinTypeReference)
+                    {
+                        Writer.EnsureSeparation();
+                        Writer.WriteLine($"public bool SequenceEqual(ReadOnlySpan<{elementType}> other)");
+                        Writer.WriteLineIndented("=> AsReadOnlySpan().SequenceEqual(other);");
+                    }
+
+                    // Write out GetEnumerator
+                    Writer.EnsureSeparation();
+                    Writer.WriteLine($"public Span<{elementType}>.Enumerator GetEnumerator()");
+                    Writer.WriteLineIndented("=> AsSpan().GetEnumerator();");
                 }
             }
         }
 
-        private void WriteOutConstantArrayEnumerators()
+        private void WriteOutConstantArrayOfPointersEnumerator()
         {
             const string element0Name = "Element0";
             const string countName = "Count";
             const string indexName = "Index";
 
-            Writer.EnsureSeparation();
-            Writer.WriteLine($"public unsafe ref struct {ConstantArrayEnumeratorName}<T>");
-            Writer.WriteLineIndented($"where T : unmanaged");
-            using (Writer.Block())
-            {
-                Writer.WriteLine($"private readonly T* {element0Name};");
-                Writer.WriteLine($"private readonly int {countName};");
-                Writer.WriteLine($"private int {indexName};");
-                Writer.WriteLine();
-                Writer.WriteLine($"public T Current => (uint){indexName} < {countName} ? {element0Name}[{indexName}] : default;");
-
-                Writer.EnsureSeparation();
-                Writer.WriteLine($"internal {ConstantArrayEnumeratorName}(T* element0, int count)");
-                using (Writer.Block())
-                {
-                    Writer.WriteLine($"{element0Name} = element0;");
-                    Writer.WriteLine($"{countName} = count;");
-                    Writer.WriteLine($"{indexName} = -1;");
-                }
-
-                Writer.EnsureSeparation();
-                Writer.WriteLine("public bool MoveNext()");
-                using (Writer.Block())
-                {
-                    Writer.WriteLine($"int index = {indexName} + 1;");
-                    Writer.WriteLine($"if (index < {countName})");
-                    using (Writer.Block())
-                    {
-                        Writer.WriteLine($"{indexName} = index;");
-                        Writer.WriteLine("return true;");
-                    }
-                    Writer.WriteLine();
-                    Writer.WriteLine("return false;");
-                }
-            }
-
             Writer.EnsureSeparation();
             Writer.WriteLine($"public unsafe ref struct {ConstantArrayOfPointersEnumeratorName}<T>");
             Writer.WriteLineIndented($"where T : unmanaged");
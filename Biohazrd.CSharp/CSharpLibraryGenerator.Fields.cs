@@ -6,18 +6,21 @@ namespace Biohazrd.CSharp
 {
     partial class CSharpLibraryGenerator
     {
-        private void StartField(TranslatedField field)
+        private void StartField(VisitorContext context, TranslatedField field)
         {
             Writer.Using("System.Runtime.InteropServices");
 
             Writer.EnsureSeparation();
-            Writer.Write($"[FieldOffset({field.Offset})] ");
+
+            // Fields of sequential records are positioned by the runtime
+            if (context.ParentDeclaration is not TranslatedRecord record || GetSequentialLayout(context.MakePrevious(), record) is null)
+            { Writer.Write($"[FieldOffset({field.Offset})] "); }
 
             // Apply MarshalAs to boolean fields
             // This might not strictly be necessary since our struct has an explicit layout, but we do it anyway for the sake of sanity.
             // (The marshaler definitely still runs on bools in explicit layouts, but it's not immediately clear if it is trying to interpret the memory as a 4-byte or 1-byte bool.)
             if (field is TranslatedNormalField { Type: CSharpBuiltinTypeReference cSharpType } && cSharpType.Type == CSharpBuiltinType.Bool)
-            { Writer.Write($"[MarshalAs(UnmanagedType.I1)] "); }
+            { WriteMarshallingHint("[MarshalAs(UnmanagedType.I1)] "); }
 
             Writer.Write($"{field.Accessibility.ToCSharpKeyword()} ");
         }
@@ -34,7 +37,7 @@ namespace Biohazrd.CSharp
 
         protected override void VisitBaseField(VisitorContext context, TranslatedBaseField declaration)
         {
-            StartField(declaration);
+            StartField(context, declaration);
             WriteType(context, declaration, declaration.Type);
             Writer.Write(' ');
             Writer.WriteIdentifier(declaration.Name);
@@ -43,7 +46,7 @@ namespace Biohazrd.CSharp
 
         protected override void VisitNormalField(VisitorContext context, TranslatedNormalField declaration)
         {
-            StartField(declaration);
+            StartField(context, declaration);
             WriteType(context, declaration, declaration.Type);
             Writer.Write(' ');
             Writer.WriteIdentifier(declaration.Name);
@@ -52,19 +55,42 @@ namespace Biohazrd.CSharp
 
         protected override void VisitStaticField(VisitorContext context, TranslatedStaticField declaration)
         {
-            Writer.Using("System.Runtime.InteropServices"); // For NativeLibrary
+            if (ImportTables is null || !ImportTables.TryGetSlot(declaration, out NativeImportSlot slot))
+            {
+                Fatal(context, declaration, "The static field was not assigned a slot in the native import tables.");
+                return;
+            }
+
+            Writer.Using("System.Runtime.CompilerServices"); // MethodImplAttribute
             Writer.EnsureSeparation();
 
-            Writer.Write($"{declaration.Accessibility.ToCSharpKeyword()} static readonly ");
-            WriteTypeAsReference(context, declaration, declaration.Type);
+            // Static fields are exposed as ref-returning properties over a slot in their library's import table
+            // This way the library is only loaded once and the containing type doesn't need a static constructor
+            string table = $"global::{slot.ClassName}";
+            Writer.Write($"{declaration.Accessibility.ToCSharpKeyword()} static unsafe ref ");
+            WriteType(context, declaration, declaration.Type);
             Writer.Write(' ');
             Writer.WriteIdentifier(declaration.Name);
-            Writer.Write(" = (");
-            WriteTypeAsReference(context, declaration, declaration.Type);
-            //TODO: This leaks handles to the native library.
-            Writer.WriteLine($")NativeLibrary.GetExport(NativeLibrary.Load(\"{SanitizeStringLiteral(declaration.DllFileName)}\"), \"{SanitizeStringLiteral(declaration.MangledName)}\");");
+            Writer.WriteLine();
+            using (Writer.Block())
+            {
+                Writer.WriteLine("[MethodImpl(MethodImplOptions.AggressiveInlining)]");
+                Writer.WriteLine("get");
+                using (Writer.Block())
+                {
+                    Writer.WriteLine($"void* {StaticFieldAddressLocalName} = {table}.Table.{slot.SlotName};");
+                    Writer.WriteLine($"if ({StaticFieldAddressLocalName} is null)");
+                    Writer.WriteLine($"{{ {StaticFieldAddressLocalName} = {table}.Resolve(ref {table}.Table.{slot.SlotName}, \"{SanitizeStringLiteral(declaration.MangledName)}\"); }}");
+                    Writer.WriteLine();
+                    Writer.Write("return ref *(");
+                    WriteTypeAsReference(context, declaration, declaration.Type);
+                    Writer.WriteLine($"){StaticFieldAddressLocalName};");
+                }
+            }
         }
 
+        private const string StaticFieldAddressLocalName = "__address";
+
         protected override void VisitBitField(VisitorContext context, TranslatedBitField declaration)
         {
             // Determine the type for the backing field
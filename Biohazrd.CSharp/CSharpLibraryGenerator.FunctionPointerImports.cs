@@ -0,0 +1,341 @@
+﻿using Biohazrd.CSharp.Metadata;
+using Biohazrd.OutputGeneration;
+using System.Collections.Generic;
+using System.IO;
+using System.Runtime.InteropServices;
+using static Biohazrd.CSharp.CSharpCodeWriter;
+
+namespace Biohazrd.CSharp
+{
+    partial class CSharpLibraryGenerator
+    {
+        private NativeImportTables? ImportTables;
+
+        private readonly struct NativeImportSlot
+        {
+            public readonly string ClassName;
+            public readonly string SlotName;
+
+            public NativeImportSlot(string className, string slotName)
+            {
+                ClassName = className;
+                SlotName = slotName;
+            }
+        }
+
+        /// <summary>Assigns every function imported through a function pointer table and every static field to a slot in its library's import table.</summary>
+        /// <remarks>
+        /// This is built once up-front so that every generator agrees on the layout of the tables, and is immutable afterwards so it's safe to share between generators running in parallel.
+        ///
+        /// Each library's import table class owns the single handle used for the library, so static fields and functions share one load of the library.
+        /// </remarks>
+        private sealed class NativeImportTables
+        {
+            public readonly bool IsLazy;
+            private readonly Dictionary<TranslatedDeclaration, NativeImportSlot> Slots = new(ReferenceEqualityComparer.Instance);
+            public readonly List<(string DllFileName, string ClassName, List<(string SlotName, string MangledName)> Entries)> Tables = new();
+
+            /// <param name="includeFunctions">If true, functions which can be imported through function pointers are assigned slots. Static fields are always assigned slots.</param>
+            public NativeImportTables(TranslatedLibrary library, bool includeFunctions, bool isLazy)
+            {
+                IsLazy = isLazy;
+                Dictionary<string, int> tableIndices = new();
+                HashSet<string> classNames = new();
+
+                foreach (TranslatedDeclaration declaration in library.EnumerateRecursively())
+                {
+                    string dllFileName;
+                    string mangledName;
+                    if (declaration is TranslatedFunction function && includeFunctions && CanUseFunctionPointerImport(function))
+                    {
+                        dllFileName = function.DllFileName;
+                        mangledName = function.MangledName;
+                    }
+                    else if (declaration is TranslatedStaticField staticField)
+                    {
+                        dllFileName = staticField.DllFileName;
+                        mangledName = staticField.MangledName;
+                    }
+                    else
+                    { continue; }
+
+                    if (!tableIndices.TryGetValue(dllFileName, out int tableIndex))
+                    {
+                        string className = $"__NativeImports_{SanitizeIdentifier(Path.GetFileNameWithoutExtension(dllFileName))}";
+
+                        // It's unlikely, but multiple library names might sanitize to the same identifier
+                        if (!classNames.Add(className))
+                        {
+                            int i = 1;
+                            while (!classNames.Add($"{className}_{i}"))
+                            { i++; }
+                            className = $"{className}_{i}";
+                        }
+
+                        tableIndex = Tables.Count;
+                        tableIndices.Add(dllFileName, tableIndex);
+                        Tables.Add((dllFileName, className, new List<(string, string)>()));
+                    }
+
+                    (string _, string tableClassName, List<(string SlotName, string MangledName)> entries) = Tables[tableIndex];
+                    string slotName = $"{SanitizeIdentifier(declaration.Name)}_{entries.Count}";
+                    entries.Add((slotName, mangledName));
+                    Slots.Add(declaration, new NativeImportSlot(tableClassName, slotName));
+                }
+            }
+
+            public bool TryGetSlot(TranslatedDeclaration declaration, out NativeImportSlot slot)
+                => Slots.TryGetValue(declaration, out slot);
+        }
+
+        private static bool CanUseFunctionPointerImport(TranslatedFunction function)
+        {
+            // Virtual methods are already called through function pointers
+            if (IsCalledThroughVTable(function))
+            { return false; }
+
+            // There's no way to capture the last error through a function pointer call
+            if (function.Metadata.Has<SetLastErrorFunction>())
+            { return false; }
+
+            return GetFunctionPointerCallingConvention(function.CallingConvention, suppressGCTransition: false) is not null;
+        }
+
+        private static string? GetFunctionPointerCallingConvention(CallingConvention callingConvention, bool suppressGCTransition)
+        {
+            string? callingConventionName = callingConvention switch
+            {
+                CallingConvention.Cdecl => "Cdecl",
+                CallingConvention.StdCall => "Stdcall",
+                CallingConvention.ThisCall => "Thiscall",
+                CallingConvention.FastCall => "Fastcall",
+                _ => null
+            };
+
+            if (callingConventionName is null)
+            { return null; }
+
+            return suppressGCTransition ? $"unmanaged[{callingConventionName}, SuppressGCTransition]" : $"unmanaged[{callingConventionName}]";
+        }
+
+        private static void EmitNativeImportTables(OutputSession session, NativeImportTables tables)
+        {
+            CSharpCodeWriter writer = session.Open<CSharpCodeWriter>("NativeImportTables.cs");
+            writer.Using("System"); // EntryPointNotFoundException, IntPtr
+            writer.Using("System.Runtime.CompilerServices"); // MethodImplAttribute
+            writer.Using("System.Runtime.InteropServices"); // NativeLibrary
+            writer.Using("System.Threading"); // Interlocked
+
+            foreach ((string dllFileName, string className, List<(string SlotName, string MangledName)> entries) in tables.Tables)
+            {
+                string tableTypeName = $"{className}_Table";
+                string dllFileNameLiteral = SanitizeStringLiteral(dllFileName);
+
+                writer.EnsureSeparation();
+                writer.WriteLine($"internal unsafe struct {tableTypeName}");
+                using (writer.Block())
+                {
+                    foreach ((string slotName, string _) in entries)
+                    { writer.WriteLine($"public void* {slotName};"); }
+                }
+
+                writer.EnsureSeparation();
+                writer.WriteLine($"internal static unsafe class {className}");
+                using (writer.Block())
+                {
+                    writer.WriteLine($"private const string LibraryName = \"{dllFileNameLiteral}\";");
+                    writer.WriteLine("private static IntPtr _LibraryHandle;");
+
+                    if (tables.IsLazy)
+                    { writer.WriteLine($"public static {tableTypeName} Table;"); }
+                    else
+                    { writer.WriteLine($"public static {tableTypeName} Table = CreateTable();"); }
+
+                    writer.EnsureSeparation();
+                    writer.WriteLine("private static IntPtr LibraryHandle");
+                    using (writer.Block())
+                    {
+                        writer.WriteLine("get");
+                        using (writer.Block())
+                        {
+                            writer.WriteLine("IntPtr handle = _LibraryHandle;");
+                            writer.WriteLine("if (handle != IntPtr.Zero)");
+                            writer.WriteLine("{ return handle; }");
+                            writer.WriteLine();
+                            writer.WriteLine($"handle = NativeLibrary.Load(LibraryName, typeof({className}).Assembly, null);");
+                            writer.WriteLine("IntPtr existingHandle = Interlocked.CompareExchange(ref _LibraryHandle, handle, IntPtr.Zero);");
+                            writer.WriteLine();
+                            writer.WriteLine("// Another thread loaded the library first, release our extra reference");
+                            writer.WriteLine("if (existingHandle != IntPtr.Zero)");
+                            using (writer.Block())
+                            {
+                                writer.WriteLine("NativeLibrary.Free(handle);");
+                                writer.WriteLine("return existingHandle;");
+                            }
+                            writer.WriteLine();
+                            writer.WriteLine("return handle;");
+                        }
+                    }
+
+                    if (!tables.IsLazy)
+                    {
+                        writer.EnsureSeparation();
+                        writer.WriteLine($"private static {tableTypeName} CreateTable()");
+                        using (writer.Block())
+                        {
+                            writer.WriteLine("IntPtr handle = LibraryHandle;");
+                            writer.WriteLine($"{tableTypeName} table = default;");
+
+                            foreach ((string slotName, string mangledName) in entries)
+                            { writer.WriteLine($"table.{slotName} = TryGetExport(handle, \"{SanitizeStringLiteral(mangledName)}\");"); }
+
+                            writer.WriteLine("return table;");
+                        }
+                    }
+
+                    writer.EnsureSeparation();
+                    writer.WriteLine("private static void* TryGetExport(IntPtr handle, string name)");
+                    writer.WriteLineIndented("=> NativeLibrary.TryGetExport(handle, name, out IntPtr address) ? (void*)address : null;");
+
+                    writer.EnsureSeparation();
+                    writer.WriteLine("/// <summary>Resolves a table entry which has not been resolved yet.</summary>");
+                    writer.WriteLine("[MethodImpl(MethodImplOptions.NoInlining)]");
+                    writer.WriteLine("public static void* Resolve(ref void* slot, string name)");
+                    using (writer.Block())
+                    {
+                        writer.WriteLine("void* address = TryGetExport(LibraryHandle, name);");
+                        writer.WriteLine();
+                        writer.WriteLine("if (address is null)");
+                        writer.WriteLine("{ throw new EntryPointNotFoundException($\"Unable to find an entry point named '{name}' in '{LibraryName}'.\"); }");
+                        writer.WriteLine();
+                        writer.WriteLine("slot = address;");
+                        writer.WriteLine("return address;");
+                    }
+                }
+            }
+
+            writer.Finish();
+        }
+
+        private void EmitFunctionPointerImport(VisitorContext context, EmitFunctionContext emitContext, TranslatedFunction declaration, NativeImportSlot slot)
+        {
+            Writer.EnsureSeparation();
+
+            // Hide from Intellisense if applicable
+            // (Don't do this if the function is accessed via trampoline.)
+            if (!declaration.IsInstanceMethod)
+            { EmitEditorBrowsableAttribute(declaration); }
+
+            // The import is only a thin wrapper around the function pointer call, so we always want it inlined
+            Writer.Using("System.Runtime.CompilerServices");
+            Writer.WriteLine("[MethodImpl(MethodImplOptions.AggressiveInlining)]");
+
+            // Write out the function signature
+            // This matches the DllImport so trampolines don't need to care which import mode is in use.
+            AccessModifier accessibility = declaration.IsInstanceMethod ? AccessModifier.Private : declaration.Accessibility;
+            Writer.Write($"{accessibility.ToCSharpKeyword()} static unsafe ");
+
+            if (declaration.ReturnByReference)
+            { WriteTypeAsReference(context, declaration, declaration.ReturnType); }
+            else
+            { WriteType(context, declaration, declaration.ReturnType); }
+
+            Writer.Write($" {SanitizeIdentifier(emitContext.DllImportName)}(");
+            EmitFunctionParameterList(context, emitContext, declaration, EmitParameterListMode.FunctionPointerImportParameters);
+            Writer.WriteLine(')');
+
+            using (Writer.Block())
+            {
+                string table = $"global::{slot.ClassName}";
+                Writer.WriteLine($"void* {FunctionPointerLocalName} = {table}.Table.{slot.SlotName};");
+                Writer.WriteLine($"if ({FunctionPointerLocalName} is null)");
+                Writer.WriteLine($"{{ {FunctionPointerLocalName} = {table}.Resolve(ref {table}.Table.{slot.SlotName}, \"{SanitizeStringLiteral(declaration.MangledName)}\"); }}");
+                Writer.WriteLine();
+
+                if (declaration.ReturnByReference)
+                {
+                    // The return buffer is an out parameter, so it needs to be pinned to pass it through the function pointer
+                    Writer.WriteLine($"Unsafe.SkipInit(out {SanitizeIdentifier(emitContext.ReturnBufferParameterName)});");
+                    Writer.Write("fixed (");
+                    WriteTypeAsReference(context, declaration, declaration.ReturnType);
+                    Writer.WriteLine($" {ReturnBufferPointerLocalName} = &{SanitizeIdentifier(emitContext.ReturnBufferParameterName)})");
+                    Writer.Write("{ ");
+                    EmitFunctionPointerImportCall(context, emitContext, declaration);
+                    Writer.WriteLine(" }");
+                }
+                else
+                {
+                    EmitFunctionPointerImportCall(context, emitContext, declaration);
+                    Writer.WriteLine();
+                }
+            }
+        }
+
+        private const string FunctionPointerLocalName = "__functionPointer";
+        private const string ReturnBufferPointerLocalName = "__returnBufferPointer";
+
+        private void EmitFunctionPointerImportCall(VisitorContext context, EmitFunctionContext emitContext, TranslatedFunction declaration)
+        {
+            bool returnsBool = !declaration.ReturnByReference && declaration.ReturnType.IsCSharpType(CSharpBuiltinType.Bool);
+            bool returnsChar = !declaration.ReturnByReference && declaration.ReturnType.IsCSharpType(CSharpBuiltinType.Char);
+
+            if (declaration.ReturnByReference || declaration.ReturnType is not VoidTypeReference)
+            { Writer.Write("return "); }
+
+            if (returnsChar)
+            { Writer.Write("(char)"); }
+
+            // Write out the function pointer type
+            // bool and char are passed as their underlying integer types since function pointers don't get the marshalling attributes we'd use on a DllImport
+            bool suppressGCTransition = declaration.Metadata.Has<SuppressGCTransitionFunction>();
+            Writer.Write($"((delegate* {GetFunctionPointerCallingConvention(declaration.CallingConvention, suppressGCTransition)}<");
+
+            if (emitContext.ThisType is not null)
+            {
+                WriteType(context, declaration, emitContext.ThisType);
+                Writer.Write(", ");
+            }
+
+            if (declaration.ReturnByReference)
+            {
+                WriteTypeAsReference(context, declaration, declaration.ReturnType);
+                Writer.Write(", ");
+            }
+
+            VisitorContext parameterContext = context.Add(declaration);
+            foreach (TranslatedParameter parameter in declaration.Parameters)
+            {
+                if (parameter.ImplicitlyPassedByReference)
+                { WriteTypeAsReference(parameterContext, parameter, parameter.Type); }
+                else
+                { WriteFunctionPointerImportType(parameterContext, parameter, parameter.Type); }
+
+                Writer.Write(", ");
+            }
+
+            if (declaration.ReturnByReference)
+            { WriteTypeAsReference(context, declaration, declaration.ReturnType); }
+            else
+            { WriteFunctionPointerImportType(context, declaration, declaration.ReturnType); }
+
+            Writer.Write($">){FunctionPointerLocalName})(");
+            EmitFunctionParameterList(context, emitContext, declaration, EmitParameterListMode.FunctionPointerImportArguments);
+            Writer.Write(')');
+
+            if (returnsBool)
+            { Writer.Write(" != 0"); }
+
+            Writer.Write(';');
+        }
+
+        private void WriteFunctionPointerImportType(VisitorContext context, TranslatedDeclaration declaration, TypeReference type)
+        {
+            if (type.IsCSharpType(CSharpBuiltinType.Bool))
+            { Writer.Write("byte"); }
+            else if (type.IsCSharpType(CSharpBuiltinType.Char))
+            { Writer.Write("ushort"); }
+            else
+            { WriteType(context, declaration, type); }
+        }
+    }
+}
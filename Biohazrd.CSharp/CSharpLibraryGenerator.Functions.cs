@@ -38,15 +38,28 @@ namespace Biohazrd.CSharp
         {
             EmitFunctionContext emitContext = new(context, declaration);
 
-            // Emit the DllImport
-            if (!declaration.IsVirtual)
-            { EmitFunctionDllImport(context, emitContext, declaration); }
+            // Emit the import
+            if (!IsCalledThroughVTable(declaration))
+            {
+                if (ImportTables is not null && ImportTables.TryGetSlot(declaration, out NativeImportSlot slot))
+                { EmitFunctionPointerImport(context, emitContext, declaration, slot); }
+                else
+                { EmitFunctionDllImport(context, emitContext, declaration); }
+            }
 
             // Emit the trampoline
             if (declaration.IsInstanceMethod)
             { EmitFunctionTrampoline(context, emitContext, declaration); }
+
+            // Emit the batched overload
+            if (BatchedCallShims.ShouldEmit(declaration))
+            { EmitBatchedCallOverload(context, declaration); }
         }
 
+        /// <summary>Virtual methods are dispatched through their virtual method table unless their exact implementation is known.</summary>
+        private static bool IsCalledThroughVTable(TranslatedFunction declaration)
+            => declaration.IsVirtual && !declaration.IsDevirtualized;
+
         private static bool FunctionNeedsCharSetParameter(TranslatedFunction declaration)
         {
             if (declaration.ReturnType.IsCSharpType(CSharpBuiltinType.Char))
@@ -78,16 +91,19 @@ namespace Biohazrd.CSharp
             { Writer.Write($", EntryPoint = \"{SanitizeStringLiteral(declaration.MangledName)}\""); }
 
             if (FunctionNeedsCharSetParameter(declaration))
-            { Writer.Write(", CharSet = CharSet.Unicode"); }
+            { WriteMarshallingHint(", CharSet = CharSet.Unicode"); }
 
             if (declaration.Metadata.Has<SetLastErrorFunction>())
             { Writer.Write(", SetLastError = true"); }
 
             Writer.WriteLine(", ExactSpelling = true)]");
 
+            if (declaration.Metadata.Has<SuppressGCTransitionFunction>())
+            { Writer.WriteLine("[SuppressGCTransition]"); }
+
             // Write out MarshalAs for boolean returns
             if (declaration.ReturnType.IsCSharpType(CSharpBuiltinType.Bool))
-            { Writer.WriteLine("[return: MarshalAs(UnmanagedType.I1)]"); }
+            { WriteMarshallingHintLine("[return: MarshalAs(UnmanagedType.I1)]"); }
 
             // Write out the function signature
             // Instance methods are accessed via trampoline, so we translate the DllImport as private.
@@ -118,7 +134,7 @@ namespace Biohazrd.CSharp
             string? methodAccessFailure = null;
             TypeReference? thisTypeCast = null;
 
-            if (!declaration.IsVirtual)
+            if (!IsCalledThroughVTable(declaration))
             { methodAccess = SanitizeIdentifier(emitContext.DllImportName); }
             else
             {
@@ -245,6 +261,8 @@ namespace Biohazrd.CSharp
             DllImportParameters,
             TrampolineParameters,
             TrampolineArguments,
+            FunctionPointerImportParameters,
+            FunctionPointerImportArguments,
         }
 
         private void EmitFunctionParameterList(VisitorContext context, EmitFunctionContext emitContext, TranslatedFunction declaration, EmitParameterListMode mode, TypeReference? thisCastType = null)
@@ -254,11 +272,12 @@ namespace Biohazrd.CSharp
 
             bool first = true;
 
-            bool writeImplicitParameters = mode == EmitParameterListMode.DllImportParameters || mode == EmitParameterListMode.TrampolineArguments;
-            bool writeTypes = mode == EmitParameterListMode.DllImportParameters || mode == EmitParameterListMode.TrampolineParameters;
+            bool writeImplicitParameters = mode != EmitParameterListMode.TrampolineParameters;
+            bool writeTypes = mode is EmitParameterListMode.DllImportParameters or EmitParameterListMode.TrampolineParameters or EmitParameterListMode.FunctionPointerImportParameters;
             bool writeDefautValues = mode switch
             {
                 EmitParameterListMode.DllImportParameters => !declaration.IsInstanceMethod, // We only emit the defaults on the trampoline.
+                EmitParameterListMode.FunctionPointerImportParameters => !declaration.IsInstanceMethod,
                 EmitParameterListMode.TrampolineParameters => true,
                 _ => false
             };
@@ -293,18 +312,25 @@ namespace Biohazrd.CSharp
                     if (!first)
                     { Writer.Write(", "); }
 
-                    if (!declaration.IsVirtual)
-                    { Writer.Write("out "); }
-                    else if (mode == EmitParameterListMode.TrampolineArguments)
-                    { Writer.Write("&"); }
-
-                    if (writeTypes)
+                    // The function pointer import pins the return buffer itself
+                    if (mode == EmitParameterListMode.FunctionPointerImportArguments)
+                    { Writer.Write(ReturnBufferPointerLocalName); }
+                    else
                     {
-                        WriteType(context, declaration, declaration.ReturnType);
-                        Writer.Write(' ');
+                        if (!IsCalledThroughVTable(declaration))
+                        { Writer.Write("out "); }
+                        else if (mode == EmitParameterListMode.TrampolineArguments)
+                        { Writer.Write("&"); }
+
+                        if (writeTypes)
+                        {
+                            WriteType(context, declaration, declaration.ReturnType);
+                            Writer.Write(' ');
+                        }
+
+                        Writer.WriteIdentifier(emitContext.ReturnBufferParameterName);
                     }
 
-                    Writer.WriteIdentifier(emitContext.ReturnBufferParameterName);
                     first = false;
                 }
             }
@@ -325,7 +351,7 @@ namespace Biohazrd.CSharp
                     {
                         // Write MarshalAs for booleans at pinvoke boundaries
                         if (mode == EmitParameterListMode.DllImportParameters && parameter.Type.IsCSharpType(CSharpBuiltinType.Bool))
-                        { Writer.Write("[MarshalAs(UnmanagedType.I1)] "); }
+                        { WriteMarshallingHint("[MarshalAs(UnmanagedType.I1)] "); }
 
                         WriteType(parameterContext, parameter, parameter.Type);
                     }
@@ -333,6 +359,24 @@ namespace Biohazrd.CSharp
                     Writer.Write(' ');
                 }
 
+                // bool and char are passed to function pointer imports as their underlying integer types
+                if (mode == EmitParameterListMode.FunctionPointerImportArguments && !parameter.ImplicitlyPassedByReference)
+                {
+                    if (parameter.Type.IsCSharpType(CSharpBuiltinType.Bool))
+                    {
+                        Writer.Write("(byte)(");
+                        Writer.WriteIdentifier(parameter.Name);
+                        Writer.Write(" ? 1 : 0)");
+                        continue;
+                    }
+                    else if (parameter.Type.IsCSharpType(CSharpBuiltinType.Char))
+                    {
+                        Writer.Write("(ushort)");
+                        Writer.WriteIdentifier(parameter.Name);
+                        continue;
+                    }
+                }
+
                 Writer.WriteIdentifier(parameter.Name);
 
                 if (writeDefautValues && parameter.DefaultValue is not null)
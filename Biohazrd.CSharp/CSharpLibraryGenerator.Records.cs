@@ -10,7 +10,15 @@ namespace Biohazrd.CSharp
             Writer.Using("System.Runtime.InteropServices");
 
             Writer.EnsureSeparation();
-            Writer.Write($"[StructLayout(LayoutKind.Explicit, Size = {declaration.Size}");
+
+            // Use sequential layout when it's known to reproduce the native layout since the JIT is able to enregister sequential structs but not explicit ones
+            SequentialLayout? sequentialLayout = GetSequentialLayout(context, declaration);
+            if (sequentialLayout is null)
+            { Writer.Write($"[StructLayout(LayoutKind.Explicit, Size = {declaration.Size}"); }
+            else if (sequentialLayout.Value.Pack != 0)
+            { Writer.Write($"[StructLayout(LayoutKind.Sequential, Pack = {sequentialLayout.Value.Pack}"); }
+            else
+            { Writer.Write("[StructLayout(LayoutKind.Sequential"); }
 
             // Write out CharSet.Unicode if necessary. An explicit charset ensures char fields in this struct are considered blittable by the runtime
             // https://github.com/dotnet/runtime/blob/29e9b5b7fd95231d9cd9d3ae351404e63cbb6d5a/src/coreclr/src/vm/fieldmarshaler.cpp#L233-L235
@@ -18,7 +26,7 @@ namespace Biohazrd.CSharp
             {
                 if (field.Type.IsCSharpType(CSharpBuiltinType.Char))
                 {
-                    Writer.Write(", CharSet = CharSet.Unicode");
+                    WriteMarshallingHint(", CharSet = CharSet.Unicode");
                     break;
                 }
             }
@@ -41,6 +49,10 @@ namespace Biohazrd.CSharp
                 if (declaration.VTable is not null && declaration.VTableField is not null)
                 { EmitVTable(childContext, declaration.VTableField, declaration.VTable); }
 
+                // Emit the layout self-check for sequential records and records containing them
+                if (HasSequentialLayoutSelfCheck(context, declaration))
+                { EmitSequentialLayoutSelfCheck(context, declaration); }
+
                 // List any unsupported members
                 if (declaration.UnsupportedMembers.Count > 0)
                 {
@@ -58,7 +70,7 @@ namespace Biohazrd.CSharp
         {
             // Emit the VTable field
             Writer.EnsureSeparation();
-            StartField(field);
+            StartField(context, field);
             Writer.WriteLine($"{SanitizeIdentifier(vTable.Name)}* {SanitizeIdentifier(field.Name)};");
 
             // Emit the VTable type
@@ -0,0 +1,345 @@
+﻿using ClangSharp;
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using static Biohazrd.CSharp.CSharpCodeWriter;
+
+namespace Biohazrd.CSharp
+{
+    partial class CSharpLibraryGenerator
+    {
+        private readonly struct SequentialLayout
+        {
+            /// <summary>The packing to specify in the <c>StructLayoutAttribute</c>, or 0 if the default packing should be used.</summary>
+            public int Pack { get; }
+
+            /// <summary>The alignment the runtime will use for this type when it appears as a field in another sequential type.</summary>
+            public int Alignment { get; }
+
+            public SequentialLayout(int pack, int alignment)
+            {
+                Pack = pack;
+                Alignment = alignment;
+            }
+        }
+
+        private readonly struct SequentialLayoutField
+        {
+            public TranslatedNormalField Field { get; }
+            public long Size { get; }
+            public int Alignment { get; }
+
+            public SequentialLayoutField(TranslatedNormalField field, long size, int alignment)
+            {
+                Field = field;
+                Size = size;
+                Alignment = alignment;
+            }
+        }
+
+        // A null value indicates the record must use explicit layout (or that it is currently being analyzed.)
+        private readonly Dictionary<TranslatedRecord, SequentialLayout?> SequentialLayouts = new(ReferenceEqualityComparer.Instance);
+        private readonly List<string> SequentialLayoutRecordNames = new();
+        private const string VerifySequentialLayoutMethodName = "__VerifySequentialLayout";
+
+        // The packings to try, in order of preference. (0 indicates the runtime's default packing of 8, which is larger than any of our alignments.)
+        private static readonly int[] SequentialLayoutPackings = { 0, 4, 2, 1 };
+
+        private SequentialLayout? GetSequentialLayout(VisitorContext context, TranslatedRecord record)
+        {
+            if (!Options.UseSequentialLayoutWhenPossible)
+            { return null; }
+
+            SequentialLayout? result;
+            if (SequentialLayouts.TryGetValue(record, out result))
+            { return result; }
+
+            // Records whose self-check can't be reached must use explicit layout since their layout would never be verified
+            if (!IsSequentialLayoutSelfCheckReachable(context, record))
+            {
+                SequentialLayouts.Add(record, null);
+                return null;
+            }
+
+            // Records cannot contain themselves by value, but we mark the record as explicit while it's being analyzed just in case
+            SequentialLayouts.Add(record, null);
+            result = AnalyzeSequentialLayout(context, record, out _);
+            SequentialLayouts[record] = result;
+            return result;
+        }
+
+        private static bool IsAccessibleWithinAssembly(TranslatedDeclaration declaration)
+            => declaration.Accessibility is AccessModifier.Public or AccessModifier.Internal or AccessModifier.ProtectedOrInternal;
+
+        /// <summary>Determines if the layout self-check for the given record can be reached from <c>SequentialLayoutSelfCheck.Verify</c>.</summary>
+        /// <remarks>
+        /// Nested records are verified by the self-check of their containing record, which can always name them regardless of their accessibility.
+        /// The outermost record of each chain of nested records is verified by the library-wide check, so it and everything containing it must be accessible within the assembly.
+        /// </remarks>
+        private static bool IsSequentialLayoutSelfCheckReachable(VisitorContext context, TranslatedRecord record)
+        {
+            TranslatedDeclaration outermostRecord = record;
+            int outermostDepth = context.Parents.Length;
+            while (outermostDepth > 0 && context.Parents[outermostDepth - 1] is TranslatedRecord parentRecord)
+            {
+                outermostRecord = parentRecord;
+                outermostDepth--;
+            }
+
+            if (!IsAccessibleWithinAssembly(outermostRecord))
+            { return false; }
+
+            for (int i = 0; i < outermostDepth; i++)
+            {
+                if (!IsAccessibleWithinAssembly(context.Parents[i]))
+                { return false; }
+            }
+
+            return true;
+        }
+
+        /// <summary>Determines if the given record has a layout self-check, either because it uses sequential layout or because one of its nested records does.</summary>
+        private bool HasSequentialLayoutSelfCheck(VisitorContext context, TranslatedRecord record)
+        {
+            if (GetSequentialLayout(context, record) is not null)
+            { return true; }
+
+            VisitorContext childContext = context.Add(record);
+            foreach (TranslatedDeclaration member in record.Members)
+            {
+                if (member is TranslatedRecord nestedRecord && HasSequentialLayoutSelfCheck(childContext, nestedRecord))
+                { return true; }
+            }
+
+            return false;
+        }
+
+        /// <summary>Determines if <c>LayoutKind.Sequential</c> would reproduce the native layout of the given record exactly.</summary>
+        /// <remarks>
+        /// This simulates the runtime's sequential layout algorithm (each field is aligned to the lesser of its natural alignment and the packing, and the size is rounded up
+        /// to the alignment of the most-aligned field) and checks it against the offsets and size reported by Clang.
+        ///
+        /// The analysis is conservative. Unions, records with bases or virtual method tables, bit fields, and fields of types which aren't primitives, pointers, enums,
+        /// or other records which can use sequential layout will always use explicit layout.
+        /// </remarks>
+        private SequentialLayout? AnalyzeSequentialLayout(VisitorContext context, TranslatedRecord record, out List<SequentialLayoutField>? fields)
+        {
+            fields = null;
+
+            if (record.Kind == RecordKind.Union || record.NonVirtualBaseField is not null || record.VTableField is not null || record.UnsupportedMembers.Count > 0)
+            { return null; }
+
+            List<SequentialLayoutField> layoutFields = new();
+            int maxAlignment = 1;
+            foreach (TranslatedDeclaration member in record.Members)
+            {
+                if (member is not TranslatedField field)
+                { continue; }
+
+                if (field is not TranslatedNormalField normalField || field is TranslatedBitField)
+                { return null; }
+
+                // Clang is the source of truth for the sizes of types since the C# type might not be one we can measure (IE: pointers)
+                // (This uses the raw cursor rather than ClangSharp's lazily-populated object model since that isn't safe to use from parallel generators.)
+                if (normalField.Declaration is not FieldDecl fieldDeclaration)
+                { return null; }
+
+                long size = fieldDeclaration.Handle.Type.SizeOf;
+                int? alignment = GetSequentialLayoutAlignment(context, normalField.Type, size);
+
+                if (alignment is null || size <= 0)
+                { return null; }
+
+                // Fields are emitted in declaration order, so they must appear in increasing offset order to be laid out sequentially
+                if (layoutFields.Count > 0 && normalField.Offset <= layoutFields[layoutFields.Count - 1].Field.Offset)
+                { return null; }
+
+                layoutFields.Add(new SequentialLayoutField(normalField, size, alignment.Value));
+
+                if (alignment.Value > maxAlignment)
+                { maxAlignment = alignment.Value; }
+            }
+
+            // Empty records are 1 byte in C++ and in C#, but there's no benefit to making them sequential
+            if (layoutFields.Count == 0)
+            { return null; }
+
+            // Try the default packing first and then progressively tighter packings
+            foreach (int pack in SequentialLayoutPackings)
+            {
+                if (pack != 0 && pack >= maxAlignment)
+                { continue; }
+
+                int effectiveMaxAlignment = pack == 0 ? maxAlignment : pack;
+                long offset = 0;
+                bool matches = true;
+                foreach (SequentialLayoutField field in layoutFields)
+                {
+                    int fieldAlignment = pack == 0 ? field.Alignment : Math.Min(field.Alignment, pack);
+                    offset = AlignUp(offset, fieldAlignment);
+
+                    if (offset != field.Field.Offset)
+                    {
+                        matches = false;
+                        break;
+                    }
+
+                    offset += field.Size;
+                }
+
+                if (matches && AlignUp(offset, effectiveMaxAlignment) == record.Size)
+                {
+                    fields = layoutFields;
+                    return new SequentialLayout(pack, effectiveMaxAlignment);
+                }
+            }
+
+            return null;
+
+            static long AlignUp(long value, int alignment)
+                => (value + (alignment - 1)) / alignment * alignment;
+        }
+
+        /// <summary>Gets the alignment the runtime will use for the given type in a sequential layout, or null if it isn't known.</summary>
+        private int? GetSequentialLayoutAlignment(VisitorContext context, TypeReference type, long nativeSize)
+        {
+            switch (type)
+            {
+                case CSharpBuiltinTypeReference builtinType:
+                    return builtinType.Type.SizeOf == nativeSize ? builtinType.Type.SizeOf : null;
+                case PointerTypeReference:
+                case FunctionPointerTypeReference:
+                    return nativeSize is 4 or 8 ? (int)nativeSize : null;
+                case TranslatedTypeReference translatedType:
+                    switch (translatedType.TryResolve(context.Library))
+                    {
+                        case TranslatedEnum translatedEnum:
+                            return GetSequentialLayoutAlignment(context, translatedEnum.UnderlyingType, nativeSize);
+                        case NativeBooleanDeclaration:
+                            return nativeSize == sizeof(byte) ? sizeof(byte) : null;
+                        case NativeCharDeclaration:
+                            return nativeSize == sizeof(char) ? sizeof(char) : null;
+                        case TranslatedRecord translatedRecord:
+                        {
+                            translatedType.TryResolve(context.Library, out VisitorContext recordContext);
+                            SequentialLayout? layout = GetSequentialLayout(recordContext, translatedRecord);
+                            return layout is not null && translatedRecord.Size == nativeSize ? layout.Value.Alignment : null;
+                        }
+                        default:
+                            return null;
+                    }
+                default:
+                    return null;
+            }
+        }
+
+        private void EmitSequentialLayoutSelfCheck(VisitorContext context, TranslatedRecord declaration)
+        {
+            List<SequentialLayoutField>? fields = null;
+            if (GetSequentialLayout(context, declaration) is not null)
+            {
+                AnalyzeSequentialLayout(context, declaration, out fields);
+                if (fields is null)
+                {
+                    Diagnostics.Add(Severity.Error, $"Could not build the layout self-check for sequential record {declaration.Name}.");
+                    return;
+                }
+            }
+
+            // Record the fully-qualified name of the outermost record of each chain of nested records so that its self-check can be invoked from the library-wide check
+            // (Nested records are verified by the self-check of their containing record instead since they might not be accessible from the library-wide check.)
+            if (context.ParentDeclaration is not TranslatedRecord)
+            {
+                Debug.Assert(IsSequentialLayoutSelfCheckReachable(context, declaration), "Records with self-checks must be reachable from the library-wide check.");
+                List<string> nameParts = new();
+
+                // Only the root declaration is emitted within its namespace
+                string? namespaceName = context.Parents.Length > 0 ? context.Parents[0].Namespace : declaration.Namespace;
+                if (namespaceName is { Length: > 0 })
+                {
+                    foreach (string namespacePart in namespaceName.Split('.'))
+                    { nameParts.Add(SanitizeIdentifier(namespacePart)); }
+                }
+
+                foreach (TranslatedDeclaration parent in context.Parents)
+                { nameParts.Add(SanitizeIdentifier(parent.Name)); }
+                nameParts.Add(SanitizeIdentifier(declaration.Name));
+
+                // The check is emitted outside of any namespace, but it's possible for a translated namespace to be shadowed so we always start from the global namespace
+                SequentialLayoutRecordNames.Add($"global::{string.Join('.', nameParts)}");
+            }
+
+            Writer.EnsureSeparation();
+
+            if (fields is not null)
+            { Writer.WriteLine("/// <summary>Verifies that the runtime's sequential layout of this type and its nested types matches the native layout.</summary>"); }
+            else
+            { Writer.WriteLine("/// <summary>Verifies that the runtime's sequential layout of this type's nested types matches the native layout.</summary>"); }
+
+            Writer.WriteLine($"internal static void {VerifySequentialLayoutMethodName}()");
+            using (Writer.Block())
+            {
+                if (fields is not null)
+                { EmitSequentialLayoutChecks(declaration, fields); }
+
+                // Verify the nested records
+                VisitorContext childContext = context.Add(declaration);
+                bool needsSeparation = fields is not null;
+                foreach (TranslatedDeclaration member in declaration.Members)
+                {
+                    if (member is not TranslatedRecord nestedRecord || !HasSequentialLayoutSelfCheck(childContext, nestedRecord))
+                    { continue; }
+
+                    if (needsSeparation)
+                    {
+                        Writer.WriteLine();
+                        needsSeparation = false;
+                    }
+
+                    Writer.WriteLine($"{SanitizeIdentifier(nestedRecord.Name)}.{VerifySequentialLayoutMethodName}();");
+                }
+            }
+        }
+
+        private void EmitSequentialLayoutChecks(TranslatedRecord declaration, List<SequentialLayoutField> fields)
+        {
+            string sanitizedName = SanitizeIdentifier(declaration.Name);
+            string nameLiteral = SanitizeStringLiteral(declaration.Name);
+
+            Writer.Using("System"); // InvalidOperationException
+            Writer.WriteLine($"{sanitizedName} value = default;");
+            Writer.WriteLine("byte* basePointer = (byte*)&value;");
+            Writer.WriteLine();
+            Writer.WriteLine($"if (sizeof({sanitizedName}) != {declaration.Size})");
+            Writer.WriteLine($"{{ throw new InvalidOperationException($\"The size of {nameLiteral} is {{sizeof({sanitizedName})}} bytes, expected {declaration.Size}.\"); }}");
+
+            foreach (SequentialLayoutField field in fields)
+            {
+                string fieldName = SanitizeIdentifier(field.Field.Name);
+                Writer.WriteLine();
+                Writer.WriteLine($"if ((byte*)&value.{fieldName} - basePointer != {field.Field.Offset})");
+                Writer.WriteLine($"{{ throw new InvalidOperationException($\"{nameLiteral}.{SanitizeStringLiteral(field.Field.Name)} is at offset {{(byte*)&value.{fieldName} - basePointer}}, expected {field.Field.Offset}.\"); }}");
+            }
+        }
+
+        private static void EmitSequentialLayoutSelfCheckFile(OutputSession session, List<string> recordNames)
+        {
+            CSharpCodeWriter writer = session.Open<CSharpCodeWriter>("SequentialLayoutSelfCheck.cs");
+
+            writer.WriteLine("/// <summary>Verifies that every type translated with sequential layout has the same layout as its native counterpart.</summary>");
+            writer.WriteLine("/// <remarks>This is intended to be called from tests or during application startup in debug builds.</remarks>");
+            writer.WriteLine("internal static class SequentialLayoutSelfCheck");
+            using (writer.Block())
+            {
+                writer.WriteLine("public static void Verify()");
+                using (writer.Block())
+                {
+                    foreach (string recordName in recordNames)
+                    { writer.WriteLine($"{recordName}.{VerifySequentialLayoutMethodName}();"); }
+                }
+            }
+
+            writer.Finish();
+        }
+    }
+}
@@ -5,6 +5,9 @@ using System;
 using System.Collections.Generic;
 using System.Collections.Immutable;
 using System.IO;
+using System.Runtime.ExceptionServices;
+using System.Threading;
+using System.Threading.Tasks;
 using static Biohazrd.CSharp.CSharpCodeWriter;
 
 namespace Biohazrd.CSharp
@@ -18,6 +21,9 @@ namespace Biohazrd.CSharp
 
         private readonly List<TranslationDiagnostic> Diagnostics = new();
 
+        private CancellationToken CancellationToken;
+        private GenerationProgress? Progress;
+
         private CSharpLibraryGenerator(CSharpGenerationOptions options, OutputSession session, string filePath)
         {
             Options = options;
@@ -32,16 +38,38 @@ namespace Biohazrd.CSharp
             : this(options, session, filePath)
             => DeclarationFilter = filter;
 
-        public static ImmutableArray<TranslationDiagnostic> Generate(CSharpGenerationOptions options, OutputSession session, TranslatedLibrary library, LibraryTranslationMode mode)
+        /// <remarks>
+        /// When <paramref name="mode"/> produces more than one file, the files are generated in parallel unless <see cref="CSharpGenerationOptions.ParallelGeneration"/> is disabled.
+        /// Output files are always opened in a deterministic order and the returned diagnostics are always in the same order as they would be for serial generation.
+        /// </remarks>
+        /// <param name="cancellationToken">A token used to cancel generation. Cancellation is observed between top-level declarations.</param>
+        /// <param name="progress">If specified, receives the number of top-level declarations emitted out of the total.</param>
+        public static ImmutableArray<TranslationDiagnostic> Generate
+        (
+            CSharpGenerationOptions options,
+            OutputSession session,
+            TranslatedLibrary library,
+            LibraryTranslationMode mode,
+            CancellationToken cancellationToken = default,
+            IProgress<TranslationProgress>? progress = null
+        )
         {
-            ImmutableArray<TranslationDiagnostic>.Builder diagnosticsBuilder = ImmutableArray.CreateBuilder<TranslationDiagnostic>();
+            GenerationProgress? generationProgress = progress is null ? null : new GenerationProgress(progress, library.Declarations.Count);
+
+            // The generators (and therefore their output files) are all created up-front on this thread so that file names are assigned deterministically
+            // (This matters when AutoRenameConflictingFiles kicks in for types with conflicting names.)
+            List<CSharpLibraryGenerator> generators = new();
+            void AddGenerator(CSharpLibraryGenerator generator)
+                => generators.Add(generator);
 
-            void DoGenerate(CSharpLibraryGenerator generator)
+            // Static fields are always imported through the import tables, functions only are when a function pointer table mode is used
+            NativeImportTables importTables = options.FunctionImportMode switch
             {
-                generator.Visit(library);
-                generator.Writer.Finish();
-                diagnosticsBuilder.AddRange(generator.Diagnostics);
-            }
+                NativeFunctionImportMode.DllImport => new NativeImportTables(library, includeFunctions: false, isLazy: true),
+                NativeFunctionImportMode.EagerFunctionPointerTable => new NativeImportTables(library, includeFunctions: true, isLazy: false),
+                NativeFunctionImportMode.LazyFunctionPointerTable => new NativeImportTables(library, includeFunctions: true, isLazy: true),
+                _ => throw new ArgumentException($"The {nameof(options.FunctionImportMode)} is invalid.", nameof(options))
+            };
 
             switch (mode)
             {
@@ -56,13 +84,13 @@ namespace Biohazrd.CSharp
                         if (declaration is ICustomCSharpTranslatedDeclaration cSharpDeclaration && !cSharpDeclaration.HasOutput)
                         { continue; }
 
-                        DoGenerate(new CSharpLibraryGenerator(options, session, $"{SanitizeIdentifier(declaration.Name)}.cs", filter: declaration));
+                        AddGenerator(new CSharpLibraryGenerator(options, session, $"{SanitizeIdentifier(declaration.Name)}.cs", filter: declaration));
                     }
 
                     //HACK: Manually emit synthesized types
                     // Really the FindAllNonNestedTypeDeclarationsVisitor is a bit too naive about what constitutes as a "Type"
                     // We should probably just loop over library.Declarations, but right now constant arrays expect to all be emitted by the same generator.
-                    DoGenerate(new CSharpLibraryGenerator(options, session, "SynthesizedDeclarations.cs", filter: TranslatedFile.Synthesized));
+                    AddGenerator(new CSharpLibraryGenerator(options, session, "SynthesizedDeclarations.cs", filter: TranslatedFile.Synthesized));
                 }
                 break;
                 case LibraryTranslationMode.OneFilePerInputFile:
@@ -80,22 +108,166 @@ namespace Biohazrd.CSharp
                         if (file == TranslatedFile.Synthesized)
                         { fileName = "SynthesizedDeclarations.cs"; }
 
-                        DoGenerate(new CSharpLibraryGenerator(options, session, fileName, filter: file));
+                        AddGenerator(new CSharpLibraryGenerator(options, session, fileName, filter: file));
                     }
                 }
                 break;
                 case LibraryTranslationMode.OneFile:
                 {
-                    DoGenerate(new CSharpLibraryGenerator(options, session, "TranslatedLibrary.cs"));
+                    AddGenerator(new CSharpLibraryGenerator(options, session, "TranslatedLibrary.cs"));
                 }
                 break;
                 default:
                     throw new ArgumentException("The specified mode is invalid.", nameof(mode));
             }
 
+            if (importTables.Tables.Count > 0)
+            { EmitNativeImportTables(session, importTables); }
+
+            if (options.DisableRuntimeMarshalling)
+            { EmitRuntimeMarshallingAttributes(session); }
+
+            if (options.SkipLocalsInit)
+            { EmitSkipLocalsInitAttribute(session); }
+
+            void RunGenerator(CSharpLibraryGenerator generator)
+            {
+                cancellationToken.ThrowIfCancellationRequested();
+                generator.CancellationToken = cancellationToken;
+                generator.Progress = generationProgress;
+                generator.ImportTables = importTables;
+                generator.Visit(library);
+                generator.Writer.Finish();
+            }
+
+            // Dumping Clang info touches ClangSharp's object model, which is not thread-safe
+            if (generators.Count > 1 && options.ParallelGeneration && !options.DumpClangInfo)
+            {
+                ParallelOptions parallelOptions = new() { CancellationToken = cancellationToken };
+
+                // Failures are collected per-generator rather than letting Parallel wrap them in an AggregateException
+                // This way callers see the same exception they would for serial generation: The one from the first failing file.
+                // (Break still runs every generator before the failing one, so which failure is first does not depend on scheduling.)
+                ExceptionDispatchInfo?[] failures = new ExceptionDispatchInfo?[generators.Count];
+                Parallel.For(0, generators.Count, parallelOptions, (i, state) =>
+                {
+                    try
+                    { RunGenerator(generators[i]); }
+                    catch (Exception ex)
+                    {
+                        failures[i] = ExceptionDispatchInfo.Capture(ex);
+                        state.Break();
+                    }
+                });
+
+                foreach (ExceptionDispatchInfo? failure in failures)
+                { failure?.Throw(); }
+            }
+            else
+            {
+                foreach (CSharpLibraryGenerator generator in generators)
+                { RunGenerator(generator); }
+            }
+
+            // Merge the diagnostics in file order so they're deterministic regardless of how generation was scheduled
+            ImmutableArray<TranslationDiagnostic>.Builder diagnosticsBuilder = ImmutableArray.CreateBuilder<TranslationDiagnostic>();
+            foreach (CSharpLibraryGenerator generator in generators)
+            { diagnosticsBuilder.AddRange(generator.Diagnostics); }
+
+            // Emit the library-wide layout self-check
+            // (This is sorted so that it's deterministic regardless of how generation was scheduled.)
+            List<string> sequentialLayoutRecordNames = new();
+            foreach (CSharpLibraryGenerator generator in generators)
+            { sequentialLayoutRecordNames.AddRange(generator.SequentialLayoutRecordNames); }
+
+            if (sequentialLayoutRecordNames.Count > 0)
+            {
+                sequentialLayoutRecordNames.Sort(StringComparer.Ordinal);
+                EmitSequentialLayoutSelfCheckFile(session, sequentialLayoutRecordNames);
+            }
+
+            // Some top-level declarations (such as those without output) might never be visited, so make sure we always report completion
+            generationProgress?.ReportComplete();
+
             return diagnosticsBuilder.MoveToImmutableSafe();
         }
 
+        private static void EmitRuntimeMarshallingAttributes(OutputSession session)
+        {
+            CSharpCodeWriter writer = session.Open<CSharpCodeWriter>("RuntimeMarshalling.cs");
+
+            // Fully-qualified names are used here since using directives can't be conditional on the target framework without making a mess of the file header
+            writer.WriteLine("#if NET7_0_OR_GREATER");
+            writer.WriteLine("[assembly: System.Runtime.CompilerServices.DisableRuntimeMarshalling]");
+            writer.WriteLine("#endif");
+            writer.Finish();
+        }
+
+        private static void EmitSkipLocalsInitAttribute(OutputSession session)
+        {
+            CSharpCodeWriter writer = session.Open<CSharpCodeWriter>("SkipLocalsInit.cs");
+
+            // SkipLocalsInitAttribute is only available in .NET 5 and later
+            writer.WriteLine("#if NET5_0_OR_GREATER");
+            writer.WriteLine("[module: System.Runtime.CompilerServices.SkipLocalsInit]");
+            writer.WriteLine("#endif");
+            writer.Finish();
+        }
+
+        /// <summary>Writes a hint for the runtime marshaler (such as <c>MarshalAs</c> or <c>CharSet</c>) in the middle of a line.</summary>
+        /// <remarks>
+        /// When <see cref="CSharpGenerationOptions.DisableRuntimeMarshalling"/> is enabled the hint is still needed when the consuming project targets a runtime older than .NET 7,
+        /// since <c>DisableRuntimeMarshallingAttribute</c> isn't applied there. Preprocessor directives must be on their own line, so the hint is moved to its own line in that case.
+        /// </remarks>
+        private void WriteMarshallingHint(string hint)
+        {
+            if (!Options.DisableRuntimeMarshalling)
+            {
+                Writer.Write(hint);
+                return;
+            }
+
+            Writer.WriteLine();
+            WriteMarshallingHintLine(hint.Trim());
+        }
+
+        /// <summary>Writes a hint for the runtime marshaler on its own line.</summary>
+        /// <remarks>See <see cref="WriteMarshallingHint(string)"/> for details.</remarks>
+        private void WriteMarshallingHintLine(string hint)
+        {
+            if (!Options.DisableRuntimeMarshalling)
+            {
+                Writer.WriteLine(hint);
+                return;
+            }
+
+            Writer.WriteLineLeftAdjusted("#if !NET7_0_OR_GREATER");
+            Writer.WriteLine(hint);
+            Writer.WriteLineLeftAdjusted("#endif");
+        }
+
+        private sealed class GenerationProgress
+        {
+            private readonly IProgress<TranslationProgress> Progress;
+            private readonly int Total;
+            private int Completed;
+
+            public GenerationProgress(IProgress<TranslationProgress> progress, int total)
+            {
+                Progress = progress;
+                Total = total;
+            }
+
+            public void DeclarationCompleted()
+            {
+                int completed = Interlocked.Increment(ref Completed);
+                Progress.Report(new TranslationProgress(Math.Min(completed, Total), Total));
+            }
+
+            public void ReportComplete()
+                => Progress.Report(new TranslationProgress(Total, Total));
+        }
+
         protected override void Visit(VisitorContext context, TranslatedDeclaration declaration)
         {
             if (context.Parents.Length == 0)
@@ -104,8 +276,17 @@ namespace Biohazrd.CSharp
                 { return; }
                 else if (FileFilter is not null && declaration.File != FileFilter)
                 { return; }
+
+                CancellationToken.ThrowIfCancellationRequested();
+                VisitFiltered(context, declaration);
+                Progress?.DeclarationCompleted();
             }
+            else
+            { VisitFiltered(context, declaration); }
+        }
 
+        private void VisitFiltered(VisitorContext context, TranslatedDeclaration declaration)
+        {
             // Skip declarations with no output
             if (declaration is ICustomCSharpTranslatedDeclaration cSharpDeclaration && !cSharpDeclaration.HasOutput)
             { return; }
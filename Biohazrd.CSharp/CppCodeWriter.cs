@@ -47,7 +47,11 @@ namespace Biohazrd.CSharp
         protected override void WriteBetweenHeaderAndCode(StreamWriter writer)
         {
             foreach (string includeFile in IncludeFiles)
-            { writer.WriteLine($"#include \"{includeFile}\""); }
+            {
+                writer.Write("#include \"");
+                writer.Write(includeFile);
+                writer.WriteLine('"');
+            }
 
             if (IncludeFiles.Count > 0)
             { writer.WriteLine(); }
@@ -1,5 +1,7 @@
 ﻿using Biohazrd.OutputGeneration;
 using ClangSharp;
+using ClangSharp.Interop;
+using ClangType = ClangSharp.Type;
 
 namespace Biohazrd.CSharp
 {
@@ -20,9 +22,21 @@ namespace Biohazrd.CSharp
 
         protected override void VisitFunction(VisitorContext context, TranslatedFunction declaration)
         {
+            // Batched call shims are needed even for functions which don't need to be referenced
+            if (BatchedCallShims.ShouldEmit(declaration) && declaration.Declaration is FunctionDecl batchedFunctionDeclaration)
+            {
+                Writer.Include(declaration.File.FilePath);
+                WriteBatchedCallShim(declaration, batchedFunctionDeclaration);
+            }
+
             if (!ModuleDefinitionGenerator.CanFunctionBeExported(declaration))
             { return; }
 
+            // Taking the address of a virtual method references a vcall thunk rather than the method itself, so it's pointless to reference them here.
+            // (Final virtual methods might still be exported, but they're emitted alongside the virtual method table.)
+            if (declaration.IsVirtual)
+            { return; }
+
             Writer.Include(declaration.File.FilePath);
 
             switch (declaration.Declaration)
@@ -73,6 +87,87 @@ namespace Biohazrd.CSharp
             Writer.WriteLine($"{functionDeclaration};");
         }
 
+        private void WriteBatchedCallShim(TranslatedFunction function, FunctionDecl functionDeclaration)
+        {
+            string shimName = BatchedCallShims.GetShimName(function);
+            CXXMethodDecl? methodDeclaration = functionDeclaration as CXXMethodDecl;
+            bool isInstanceMethod = methodDeclaration is not null && !methodDeclaration.IsStatic;
+            bool hasReturnValue = functionDeclaration.ReturnType.CanonicalType.Kind != CXTypeKind.CXType_Void;
+
+            Writer.Include("stddef.h"); // size_t
+            Writer.EnsureSeparation();
+
+            // Type aliases are used so that types whose spelling can't simply have a * appended to it (such as function pointers) can be used as array elements
+            if (isInstanceMethod)
+            { Writer.WriteLine($"using {shimName}_this = {methodDeclaration!.Parent.TypeForDecl.CanonicalType};"); }
+
+            if (hasReturnValue)
+            { Writer.WriteLine($"using {shimName}_return = {functionDeclaration.ReturnType.CanonicalType};"); }
+
+            int i = 0;
+            foreach (ParmVarDecl parameter in functionDeclaration.Parameters)
+            {
+                // References are batched as arrays of pointers
+                ClangType parameterType = parameter.Type.CanonicalType;
+                if (parameterType is LValueReferenceType referenceType)
+                { parameterType = referenceType.PointeeType.CanonicalType; }
+
+                Writer.WriteLine($"using {shimName}_{i} = {parameterType};");
+                i++;
+            }
+
+            Writer.Write($"extern \"C\" void {shimName}(size_t count");
+
+            if (isInstanceMethod)
+            { Writer.Write($", {shimName}_this* const* instances"); }
+
+            i = 0;
+            foreach (ParmVarDecl parameter in functionDeclaration.Parameters)
+            {
+                if (parameter.Type.CanonicalType is LValueReferenceType)
+                { Writer.Write($", {shimName}_{i}* const* _{i}"); }
+                else
+                { Writer.Write($", const {shimName}_{i}* _{i}"); }
+                i++;
+            }
+
+            if (hasReturnValue)
+            { Writer.Write($", {shimName}_return* results"); }
+
+            Writer.WriteLine(')');
+            using (Writer.Block())
+            {
+                Writer.WriteLine("for (size_t i = 0; i < count; i++)");
+                Writer.Write("{ ");
+
+                if (hasReturnValue)
+                { Writer.Write("results[i] = "); }
+
+                if (isInstanceMethod)
+                { Writer.Write($"instances[i]->{functionDeclaration}("); }
+                else
+                {
+                    WriteOutNamespaceAndType(functionDeclaration);
+                    Writer.Write($"{functionDeclaration}(");
+                }
+
+                i = 0;
+                foreach (ParmVarDecl parameter in functionDeclaration.Parameters)
+                {
+                    if (i > 0)
+                    { Writer.Write(", "); }
+
+                    if (parameter.Type.CanonicalType is LValueReferenceType)
+                    { Writer.Write($"*_{i}[i]"); }
+                    else
+                    { Writer.Write($"_{i}[i]"); }
+                    i++;
+                }
+
+                Writer.WriteLine("); }");
+            }
+        }
+
         private void WriteConstructorReference(VisitorContext context, TranslatedFunction function, CXXConstructorDecl constructor)
         {
             string? typeName = context.ParentDeclaration?.Name;
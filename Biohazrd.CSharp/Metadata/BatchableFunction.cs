@@ -0,0 +1,17 @@
+﻿namespace Biohazrd.CSharp.Metadata
+{
+    /// <summary>The presence of this metadata on a function indicates a batched overload should be generated for it.</summary>
+    /// <remarks>
+    /// A batched overload takes a span for each argument (and a span of instance pointers for instance methods) and calls the function once for each element in a native loop,
+    /// so that calling the function many times only costs a single transition between managed and unmanaged code.
+    /// If the function returns a value, the overload takes an additional span to receive the results.
+    ///
+    /// The native side of the batched call is a C++ shim emitted by <see cref="InlineReferenceFileGenerator"/> and exported by <see cref="ModuleDefinitionGenerator"/>,
+    /// so this metadata item is only useful for libraries built with those files.
+    ///
+    /// This metadata item has no affect on constructors, destructors, non-public methods, or functions which return by reference or take rvalue references.
+    /// Pointers are batched as <c>IntPtr</c>, so overloads which would get batched overloads with the same signature are skipped by <see cref="CSharpTranslationVerifier"/>.
+    /// </remarks>
+    public struct BatchableFunction : IDeclarationMetadataItem
+    { }
+}
@@ -0,0 +1,15 @@
+﻿using System.Runtime.InteropServices;
+
+namespace Biohazrd.CSharp.Metadata
+{
+    /// <summary>The presence of this metadata on a function indicates <see cref="SuppressGCTransitionAttribute"/> will be applied to the corresponding P/Invoke or function pointer call.</summary>
+    /// <remarks>
+    /// This skips the transition between managed and unmanaged code, which can dominate the cost of calling trivial native functions.
+    /// It must only be used for functions which are very short, never block, and never call back into managed code.
+    /// See the documentation for <see cref="SuppressGCTransitionAttribute"/> for details.
+    ///
+    /// This metadata item has no affect on virtual methods.
+    /// </remarks>
+    public struct SuppressGCTransitionFunction : IDeclarationMetadataItem
+    { }
+}
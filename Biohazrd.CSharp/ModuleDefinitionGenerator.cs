@@ -22,7 +22,8 @@ namespace Biohazrd.CSharp
             { return false; }
 
             // Virtual functions do not need to be exported because they are accessed via the VTable
-            if (method is { IsVirtual: true })
+            // (Final virtual methods are the exception since exporting them allows them to be called directly.)
+            if (method is { IsVirtual: true } && !declaration.IsFinal)
             { return false; }
 
             // Skip destructors for now
@@ -56,8 +57,15 @@ namespace Biohazrd.CSharp
             List<string> exportDefinitions = new();
             foreach (TranslatedDeclaration declaration in library.EnumerateRecursively())
             {
-                if (declaration is TranslatedFunction function && CanFunctionBeExported(function))
-                { exportDefinitions.Add($"    {function.MangledName}"); }
+                if (declaration is TranslatedFunction function)
+                {
+                    if (CanFunctionBeExported(function))
+                    { exportDefinitions.Add($"    {function.MangledName}"); }
+
+                    // Batched call shims are emitted by InlineReferenceFileGenerator
+                    if (BatchedCallShims.ShouldEmit(function))
+                    { exportDefinitions.Add($"    {BatchedCallShims.GetShimName(function)}"); }
+                }
             }
 
             exportDefinitions.Sort(StringComparer.Ordinal);
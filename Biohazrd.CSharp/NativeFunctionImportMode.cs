@@ -0,0 +1,13 @@
+﻿namespace Biohazrd.CSharp
+{
+    /// <summary>Controls how non-virtual native functions are imported by the generated C# code.</summary>
+    public enum NativeFunctionImportMode
+    {
+        /// <summary>Functions are imported using <c>[DllImport]</c> and resolved lazily by the runtime.</summary>
+        DllImport,
+        /// <summary>Functions are called through a per-library table of unmanaged function pointers which is filled in a single pass the first time the table is accessed.</summary>
+        EagerFunctionPointerTable,
+        /// <summary>Functions are called through a per-library table of unmanaged function pointers where each entry is resolved the first time it is called.</summary>
+        LazyFunctionPointerTable
+    }
+}
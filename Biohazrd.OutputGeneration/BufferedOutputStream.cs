@@ -0,0 +1,26 @@
+﻿using System;
+using System.IO;
+
+namespace Biohazrd.OutputGeneration
+{
+    /// <summary>A memory stream which hands its contents off to a callback when it is disposed.</summary>
+    internal sealed class BufferedOutputStream : MemoryStream
+    {
+        private readonly Action<ReadOnlyMemory<byte>> Commit;
+        private bool IsCommitted = false;
+
+        public BufferedOutputStream(Action<ReadOnlyMemory<byte>> commit)
+            => Commit = commit;
+
+        protected override void Dispose(bool disposing)
+        {
+            if (disposing && !IsCommitted)
+            {
+                IsCommitted = true;
+                Commit(GetBuffer().AsMemory(0, checked((int)Length)));
+            }
+
+            base.Dispose(disposing);
+        }
+    }
+}
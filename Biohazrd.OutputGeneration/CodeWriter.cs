@@ -1,6 +1,8 @@
 ﻿using System;
+using System.Buffers;
 using System.Diagnostics;
 using System.IO;
+using System.Runtime.InteropServices;
 using System.Text;
 
 namespace Biohazrd.OutputGeneration
@@ -12,7 +14,17 @@ namespace Biohazrd.OutputGeneration
         private bool OnNewLine = true;
         private string? LinePrefix = null;
         private bool NoSeparationNeeded = true;
-        private readonly StringBuilder CodeBuilder = new StringBuilder();
+
+        // The code is accumulated in a pooled buffer until the writer is finished
+        // The buffer isn't rented until something is written since many writers may be open at once during generation
+        private const int InitialBufferSize = 16 * 1024;
+        private char[] CodeBuffer = Array.Empty<char>();
+        private int CodeLength = 0;
+
+        // Indents are written as a single pre-built string rather than one space at a time
+        private static readonly string[] CachedIndents = CreateCachedIndents(16);
+        private static readonly UTF8Encoding Utf8NoBom = new(encoderShouldEmitUTF8Identifier: false);
+        private const int FileBufferSize = 64 * 1024;
 
         public override Encoding Encoding => Encoding.Unicode;
 
@@ -28,9 +40,20 @@ namespace Biohazrd.OutputGeneration
             FilePath = filePath;
 
             // We don't need this until we're marked as finished, but we open it right away to lock the file.
-            _Writer = new StreamWriter(FilePath);
+            _Writer = new StreamWriter(session.OpenOutputStream(FilePath), Utf8NoBom, FileBufferSize);
         }
 
+        private static string[] CreateCachedIndents(int count)
+        {
+            string[] indents = new string[count];
+            for (int i = 0; i < indents.Length; i++)
+            { indents[i] = new string(' ', i * IndentSize); }
+            return indents;
+        }
+
+        private static string GetIndent(int indentLevel)
+            => indentLevel < CachedIndents.Length ? CachedIndents[indentLevel] : new string(' ', indentLevel * IndentSize);
+
         public void WriteLineLeftAdjusted(string value)
         {
             if (!OnNewLine)
@@ -68,31 +91,78 @@ namespace Biohazrd.OutputGeneration
         }
 
         public override void Write(char value)
+            => Write(MemoryMarshal.CreateReadOnlySpan(ref value, 1));
+
+        public override void Write(string? value)
+            => Write(value.AsSpan());
+
+        public override void Write(char[] buffer, int index, int count)
+            => Write(buffer.AsSpan(index, count));
+
+        public override void WriteLine(string? value)
+            => WriteLine(value.AsSpan());
+
+        public override void WriteLine(ReadOnlySpan<char> buffer)
+        {
+            Write(buffer);
+            Write(CoreNewLine);
+        }
+
+        public override void Write(ReadOnlySpan<char> buffer)
         {
             if (IsFinished)
             { throw new InvalidOperationException("Can't write to a code writer after it has been finished."); }
 
+            if (buffer.IsEmpty)
+            { return; }
+
             NoSeparationNeeded = false;
 
-            // Write out indent if we are starting a new line, but only if the line isn't empty
-            // (This assumes a carriage return never appears outside of a newline, which is a safe assumption for any valid files.)
-            if (OnNewLine && value != '\r' && value != '\n')
+            while (!buffer.IsEmpty)
             {
-                OnNewLine = false;
+                // Write out indent if we are starting a new line, but only if the line isn't empty
+                // (This assumes a carriage return never appears outside of a newline, which is a safe assumption for any valid files.)
+                if (OnNewLine && buffer[0] != '\r' && buffer[0] != '\n')
+                {
+                    OnNewLine = false;
+                    Append(GetIndent(IndentLevel));
+
+                    if (LinePrefix is not null)
+                    { Append(LinePrefix); }
+                }
+
+                // Write out everything up to and including the end of the current line
+                int newLineIndex = buffer.IndexOf('\n');
+                if (newLineIndex < 0)
+                {
+                    Append(buffer);
+                    break;
+                }
+
+                Append(buffer.Slice(0, newLineIndex + 1));
+                buffer = buffer.Slice(newLineIndex + 1);
+
+                // We just ended a line, so we need to indent the next one
+                OnNewLine = true;
+            }
+        }
 
-                for (int i = 0; i < IndentLevel * IndentSize; i++)
-                { Write(' '); }
+        private void Append(ReadOnlySpan<char> value)
+        {
+            if (CodeLength + value.Length > CodeBuffer.Length)
+            {
+                int newSize = CodeBuffer.Length == 0 ? InitialBufferSize : CodeBuffer.Length * 2;
+                char[] newBuffer = ArrayPool<char>.Shared.Rent(Math.Max(newSize, CodeLength + value.Length));
+                CodeBuffer.AsSpan(0, CodeLength).CopyTo(newBuffer);
 
-                if (LinePrefix is not null)
-                { Write(LinePrefix); }
-            }
+                if (CodeBuffer.Length > 0)
+                { ArrayPool<char>.Shared.Return(CodeBuffer); }
 
-            // Write out the actual content with the underlying writer
-            CodeBuilder.Append(value);
+                CodeBuffer = newBuffer;
+            }
 
-            // If this character started a newline, update onNewLine so we know to indent the next line
-            if (value == '\n')
-            { OnNewLine = true; }
+            value.CopyTo(CodeBuffer.AsSpan(CodeLength));
+            CodeLength += value.Length;
         }
 
         public void Finish()
@@ -105,15 +175,27 @@ namespace Biohazrd.OutputGeneration
 
             WriteOut(_Writer);
             _Writer.Flush();
-            CodeBuilder.Clear();
+            ReturnCodeBuffer();
             IsFinished = true;
         }
 
+        private void ReturnCodeBuffer()
+        {
+            if (CodeBuffer.Length == 0)
+            { return; }
+
+            ArrayPool<char>.Shared.Return(CodeBuffer);
+            CodeBuffer = Array.Empty<char>();
+            CodeLength = 0;
+        }
+
         protected virtual void WriteOut(StreamWriter writer)
         {
             WriteOutHeaderComment(writer);
             WriteBetweenHeaderAndCode(writer);
-            writer.Write(CodeBuilder.ToString());
+
+            // The code is encoded straight from our buffer into the file without an intermediate string
+            writer.Write(CodeBuffer.AsSpan(0, CodeLength));
         }
 
         protected abstract void WriteOutHeaderComment(StreamWriter writer);
@@ -125,8 +207,13 @@ namespace Biohazrd.OutputGeneration
         {
             if (disposing)
             {
-                if (!IsFinished)
-                { Finish(); }
+                try
+                {
+                    if (!IsFinished)
+                    { Finish(); }
+                }
+                finally
+                { ReturnCodeBuffer(); }
 
                 _Writer.Dispose();
             }
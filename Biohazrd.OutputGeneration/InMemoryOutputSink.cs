@@ -0,0 +1,40 @@
+﻿using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.IO;
+using System.Text;
+
+namespace Biohazrd.OutputGeneration
+{
+    /// <summary>Keeps output files in memory rather than writing them to disk.</summary>
+    /// <remarks>
+    /// The files remain available after the session is disposed, and the same sink can be used by a later session to compare against the previous output.
+    /// </remarks>
+    public sealed class InMemoryOutputSink : OutputSink
+    {
+        private readonly ConcurrentDictionary<string, byte[]> _Files = new();
+
+        /// <summary>The contents of each file in this sink, keyed by full path.</summary>
+        public IReadOnlyDictionary<string, byte[]> Files => _Files;
+
+        public override Stream CreateFile(string filePath)
+            => new BufferedOutputStream(contents => _Files[filePath] = contents.ToArray());
+
+        public override Stream? OpenFileForReading(string filePath)
+            => _Files.TryGetValue(filePath, out byte[]? contents) ? new MemoryStream(contents, writable: false) : null;
+
+        public override void DeleteFile(string filePath)
+            => _Files.TryRemove(filePath, out _);
+
+        /// <summary>Gets the contents of the specified file as UTF-8 text.</summary>
+        /// <returns>The contents of the file, or null if it does not exist.</returns>
+        public string? GetFileText(string filePath)
+        {
+            if (!_Files.TryGetValue(filePath, out byte[]? contents))
+            { return null; }
+
+            using StreamReader reader = new(new MemoryStream(contents, writable: false), Encoding.UTF8);
+            return reader.ReadToEnd();
+        }
+    }
+}
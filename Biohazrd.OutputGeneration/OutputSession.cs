@@ -3,11 +3,17 @@ using System.Collections.Generic;
 using System.IO;
 using System.Linq;
 using System.Reflection;
+using System.Threading;
 
 namespace Biohazrd.OutputGeneration
 {
+    /// <remarks>
+    /// Files may be opened concurrently from multiple threads. Properties which configure the session should not be modified while files are being opened.
+    /// </remarks>
     public sealed class OutputSession : IDisposable
     {
+        private readonly object SyncLock = new();
+
         private string _BaseOutputDirectory;
         public string BaseOutputDirectory
         {
@@ -20,6 +26,29 @@ namespace Biohazrd.OutputGeneration
 
         public bool AutoRenameConflictingFiles { get; set; } = true;
 
+        /// <summary>Where the files written by this session are stored. Defaults to a <see cref="PhysicalDirectoryOutputSink"/>.</summary>
+        /// <remarks>The sink should not be changed once files have been opened. It will be disposed along with this session.</remarks>
+        public OutputSink Sink { get; set; } = new PhysicalDirectoryOutputSink();
+
+        /// <summary>If true, text files are buffered in memory and only written to disk when their contents differ from the existing file.</summary>
+        /// <remarks>
+        /// Leaving unchanged files untouched preserves their timestamps, which avoids unnecessary rebuilds of projects consuming the generated code.
+        ///
+        /// This applies to code writers, <see cref="StreamWriter"/>s, and <see cref="Stream"/>s created by this session. Copied files are always written.
+        /// </remarks>
+        public bool SkipUnchangedFiles { get; set; } = false;
+
+        private int _ChangedFileCount;
+        private int _UnchangedFileCount;
+
+        /// <summary>The number of files which were written to disk because they were new or their contents changed.</summary>
+        /// <remarks>Only files affected by <see cref="SkipUnchangedFiles"/> are counted. Files are counted once they've been closed, which for most writers is when the session is disposed.</remarks>
+        public int ChangedFileCount => _ChangedFileCount;
+
+        /// <summary>The number of files which were left untouched because their contents did not change.</summary>
+        /// <remarks>This will always be 0 unless <see cref="SkipUnchangedFiles"/> is enabled.</remarks>
+        public int UnchangedFileCount => _UnchangedFileCount;
+
         private Dictionary<Type, Delegate> Factories = new();
 
         private Dictionary<string, object> Writers = new();
@@ -59,15 +88,32 @@ namespace Biohazrd.OutputGeneration
             BaseOutputDirectory = Environment.CurrentDirectory;
 
             // Add default factories
-            AddFactory((session, path) => new StreamWriter(path));
-            AddFactory((session, path) => new FileStream(path, FileMode.Create));
+            AddFactory((session, path) => new StreamWriter(session.OpenOutputStream(path)));
+            AddFactory((session, path) => session.OpenOutputStream(path));
+            AddFactory((session, path) =>
+            {
+                // Raw file streams only make sense for sinks backed by the file system
+                // (Note that they're never subject to SkipUnchangedFiles since the caller has direct access to the file.)
+                if (session.Sink is not PhysicalDirectoryOutputSink physicalSink)
+                {
+                    throw new NotSupportedException
+                    (
+                        $"{nameof(FileStream)}s can only be opened when the output session's sink is a {nameof(PhysicalDirectoryOutputSink)}, open a {nameof(Stream)} instead."
+                    );
+                }
+
+                return physicalSink.CreateFile(path);
+            });
             AddFactory((session, path) => new ReserveWithoutOpening(path));
         }
 
         public void WriteHeader(TextWriter writer, string linePrefix)
         {
             foreach (string line in GeneratedFileHeaderLines)
-            { writer.WriteLine($"{linePrefix}{line}"); }
+            {
+                writer.Write(linePrefix);
+                writer.WriteLine(line);
+            }
         }
 
         public delegate TWriter WriterFactory<TWriter>(OutputSession session, string filePath)
@@ -75,10 +121,20 @@ namespace Biohazrd.OutputGeneration
 
         public void AddFactory<TWriter>(WriterFactory<TWriter> factoryMethod)
             where TWriter : class
-            => Factories.Add(typeof(TWriter), factoryMethod);
+        {
+            lock (SyncLock)
+            { Factories.Add(typeof(TWriter), factoryMethod); }
+        }
 
         private WriterFactory<TWriter> GetFactory<TWriter>()
             where TWriter : class
+        {
+            lock (SyncLock)
+            { return GetFactoryNoLock<TWriter>(); }
+        }
+
+        private WriterFactory<TWriter> GetFactoryNoLock<TWriter>()
+            where TWriter : class
         {
             if (Factories.TryGetValue(typeof(TWriter), out Delegate? ret))
             { return (WriterFactory<TWriter>)ret; }
@@ -117,6 +173,14 @@ namespace Biohazrd.OutputGeneration
 
         public TWriter Open<TWriter>(string filePath, WriterFactory<TWriter> factory)
             where TWriter : class
+        {
+            // The entire open is done under the lock so that conflicting file paths are resolved atomically
+            lock (SyncLock)
+            { return OpenNoLock(filePath, factory); }
+        }
+
+        private TWriter OpenNoLock<TWriter>(string filePath, WriterFactory<TWriter> factory)
+            where TWriter : class
         {
             CheckDisposed();
 
@@ -146,12 +210,8 @@ namespace Biohazrd.OutputGeneration
                 while (Writers.ContainsKey(filePath));
             }
 
-            // Ensure the containing directory exists
-            string? fileDirectory = Path.GetDirectoryName(filePath);
-            if (fileDirectory is not null && !Directory.Exists(fileDirectory))
-            { Directory.CreateDirectory(fileDirectory); }
-
             // Create the writer
+            // (The sink is responsible for ensuring the file's directory exists if needed.)
             TWriter writer = factory(this, filePath);
             Writers.Add(filePath, writer);
             return writer;
@@ -161,14 +221,72 @@ namespace Biohazrd.OutputGeneration
             where TWriter : class
             => Open(filePath, GetFactory<TWriter>());
 
+        /// <summary>Creates the stream used to write the contents of a text file at the specified path which has already been opened by this session.</summary>
+        /// <remarks>When <see cref="SkipUnchangedFiles"/> is enabled, the contents are buffered until the stream is disposed.</remarks>
+        internal Stream OpenOutputStream(string filePath)
+            => OpenOutputStream(filePath, countFile: true);
+
+        private Stream OpenOutputStream(string filePath, bool countFile)
+        {
+            if (!SkipUnchangedFiles)
+            { return Sink.CreateFile(filePath); }
+
+            return new BufferedOutputStream(contents =>
+            {
+                bool changed = WriteFileIfChanged(filePath, contents.Span);
+
+                if (!countFile)
+                { }
+                else if (changed)
+                { Interlocked.Increment(ref _ChangedFileCount); }
+                else
+                { Interlocked.Increment(ref _UnchangedFileCount); }
+            });
+        }
+
+        /// <returns>True if the file was written, false if the file already had the specified contents.</returns>
+        private bool WriteFileIfChanged(string filePath, ReadOnlySpan<byte> contents)
+        {
+            using (Stream? existingFile = Sink.OpenFileForReading(filePath))
+            {
+                // The lengths are checked first since that lets us skip reading most changed files entirely
+                if (existingFile is not null && existingFile.Length == contents.Length && StreamContentsEqual(existingFile, contents))
+                { return false; }
+            }
+
+            using Stream stream = Sink.CreateFile(filePath);
+            stream.Write(contents);
+            return true;
+        }
+
+        private static bool StreamContentsEqual(Stream stream, ReadOnlySpan<byte> contents)
+        {
+            Span<byte> buffer = stackalloc byte[4096];
+            while (true)
+            {
+                int bytesRead = stream.Read(buffer);
+
+                if (bytesRead == 0)
+                { return contents.IsEmpty; }
+
+                if (bytesRead > contents.Length || !buffer.Slice(0, bytesRead).SequenceEqual(contents.Slice(0, bytesRead)))
+                { return false; }
+
+                contents = contents.Slice(bytesRead);
+            }
+        }
+
         /// <summary>Copies the specified input file to the specified output file.</summary>
         /// <returns>The path the file was copied to.</returns>
         /// <remarks>If <see cref="AutoRenameConflictingFiles"/> is true, the file name of the returned path may the same as <paramref name="destinationFilePath"/>.</remarks>
         public string CopyFile(string sourceFilePath, string destinationFilePath)
         {
             ReserveWithoutOpening reservation = Open<ReserveWithoutOpening>(destinationFilePath);
-            File.Copy(sourceFilePath, reservation.OutputPath);
-            reservation.LockFile();
+            Sink.CopyFile(sourceFilePath, reservation.OutputPath);
+
+            if (Sink is PhysicalDirectoryOutputSink)
+            { reservation.LockFile(); }
+
             return reservation.OutputPath;
         }
 
@@ -184,10 +302,11 @@ namespace Biohazrd.OutputGeneration
             string fileLogPath = Path.Combine(BaseOutputDirectory, "FilesWritten.txt");
 
             // Delete any files from previous output session that weren't written in this one
-            if (File.Exists(fileLogPath))
+            using (Stream? fileLogStream = Sink.OpenFileForReading(fileLogPath))
             {
-                using (StreamReader fileLog = new(fileLogPath))
+                if (fileLogStream is not null)
                 {
+                    using StreamReader fileLog = new(fileLogStream);
                     while (true)
                     {
                         string? filePath = fileLog.ReadLine();
@@ -199,13 +318,13 @@ namespace Biohazrd.OutputGeneration
                         filePath = Path.GetFullPath(filePath);
 
                         if (!Writers.ContainsKey(filePath))
-                        { File.Delete(filePath); }
+                        { Sink.DeleteFile(filePath); }
                     }
                 }
             }
 
             // Write out a listing of all files written
-            using (StreamWriter fileLog = new(fileLogPath))
+            using (StreamWriter fileLog = new(OpenOutputStream(fileLogPath, countFile: false)))
             {
                 foreach (string writtenFilePath in FilesWritten.OrderBy(f => f))
                 {
@@ -230,6 +349,12 @@ namespace Biohazrd.OutputGeneration
         }
 
         public void Dispose()
+        {
+            lock (SyncLock)
+            { DisposeNoLock(); }
+        }
+
+        private void DisposeNoLock()
         {
             if (IsDisposed)
             { return; }
@@ -243,6 +368,9 @@ namespace Biohazrd.OutputGeneration
                 { disposable.Dispose(); }
             }
 
+            // The sink is disposed last since disposing the writers might write to it
+            Sink.Dispose();
+
             IsDisposed = true;
         }
     }
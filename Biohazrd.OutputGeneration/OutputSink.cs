@@ -0,0 +1,36 @@
+﻿using System;
+using System.IO;
+
+namespace Biohazrd.OutputGeneration
+{
+    /// <summary>The destination for the files written by an <see cref="OutputSession"/>.</summary>
+    /// <remarks>
+    /// All file paths given to a sink are full paths which have already been normalized by the session.
+    ///
+    /// Sinks may be used from multiple threads concurrently. The sink will be disposed when the session using it is disposed.
+    /// </remarks>
+    public abstract class OutputSink : IDisposable
+    {
+        /// <summary>Creates (or truncates) the specified file for writing.</summary>
+        /// <remarks>The file's contents are not guaranteed to be visible until the returned stream is disposed.</remarks>
+        public abstract Stream CreateFile(string filePath);
+
+        /// <summary>Opens the specified file for reading.</summary>
+        /// <returns>The file's contents, or null if the file does not exist.</returns>
+        public abstract Stream? OpenFileForReading(string filePath);
+
+        /// <summary>Deletes the specified file if it exists.</summary>
+        public abstract void DeleteFile(string filePath);
+
+        /// <summary>Copies a file from the physical file system into this sink.</summary>
+        public virtual void CopyFile(string sourceFilePath, string destinationFilePath)
+        {
+            using FileStream source = new(sourceFilePath, FileMode.Open, FileAccess.Read, FileShare.Read);
+            using Stream destination = CreateFile(destinationFilePath);
+            source.CopyTo(destination);
+        }
+
+        public virtual void Dispose()
+        { }
+    }
+}
@@ -0,0 +1,33 @@
+﻿using System.IO;
+
+namespace Biohazrd.OutputGeneration
+{
+    /// <summary>Writes output files directly to the file system.</summary>
+    public sealed class PhysicalDirectoryOutputSink : OutputSink
+    {
+        public override FileStream CreateFile(string filePath)
+        {
+            // Ensure the containing directory exists
+            string? fileDirectory = Path.GetDirectoryName(filePath);
+            if (fileDirectory is not null && !Directory.Exists(fileDirectory))
+            { Directory.CreateDirectory(fileDirectory); }
+
+            return new FileStream(filePath, FileMode.Create, FileAccess.Write, FileShare.Read);
+        }
+
+        public override Stream? OpenFileForReading(string filePath)
+            => File.Exists(filePath) ? new FileStream(filePath, FileMode.Open, FileAccess.Read, FileShare.Read) : null;
+
+        public override void DeleteFile(string filePath)
+            => File.Delete(filePath);
+
+        public override void CopyFile(string sourceFilePath, string destinationFilePath)
+        {
+            string? fileDirectory = Path.GetDirectoryName(destinationFilePath);
+            if (fileDirectory is not null && !Directory.Exists(fileDirectory))
+            { Directory.CreateDirectory(fileDirectory); }
+
+            File.Copy(sourceFilePath, destinationFilePath, overwrite: true);
+        }
+    }
+}
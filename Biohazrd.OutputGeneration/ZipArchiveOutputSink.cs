@@ -0,0 +1,78 @@
+﻿using System;
+using System.Collections.Generic;
+using System.IO;
+using System.IO.Compression;
+
+namespace Biohazrd.OutputGeneration
+{
+    /// <summary>Writes output files into a single zip archive.</summary>
+    /// <remarks>
+    /// The archive is always created from scratch, so it never contains files from a previous session.
+    /// The archive is not complete until the sink (or the session using it) is disposed.
+    /// </remarks>
+    public sealed class ZipArchiveOutputSink : OutputSink
+    {
+        private readonly string RootDirectory;
+        private readonly ZipArchive Archive;
+        private readonly HashSet<string> EntryNames = new(StringComparer.Ordinal);
+        private bool IsDisposed = false;
+
+        /// <param name="archiveFilePath">The path of the zip archive to create.</param>
+        /// <param name="rootDirectory">The directory which corresponds to the root of the archive, generally the session's <see cref="OutputSession.BaseOutputDirectory"/>.</param>
+        public ZipArchiveOutputSink(string archiveFilePath, string rootDirectory)
+        {
+            RootDirectory = Path.GetFullPath(rootDirectory);
+            Archive = new ZipArchive(new FileStream(archiveFilePath, FileMode.Create, FileAccess.ReadWrite), ZipArchiveMode.Create);
+        }
+
+        private string GetEntryName(string filePath)
+        {
+            string relativePath = Path.GetRelativePath(RootDirectory, filePath);
+
+            if (Path.IsPathRooted(relativePath) || relativePath.StartsWith(".."))
+            { throw new ArgumentException($"'{filePath}' is outside of the archive's root directory.", nameof(filePath)); }
+
+            return relativePath.Replace(Path.DirectorySeparatorChar, '/');
+        }
+
+        public override Stream CreateFile(string filePath)
+        {
+            string entryName = GetEntryName(filePath);
+
+            // Zip archives can only have one entry open for writing at a time, so each file is buffered and written once it's complete
+            return new BufferedOutputStream(contents =>
+            {
+                lock (Archive)
+                {
+                    if (IsDisposed)
+                    { throw new ObjectDisposedException(nameof(ZipArchiveOutputSink)); }
+
+                    if (!EntryNames.Add(entryName))
+                    { throw new InvalidOperationException($"'{entryName}' was written to the archive more than once."); }
+
+                    using Stream entryStream = Archive.CreateEntry(entryName).Open();
+                    entryStream.Write(contents.Span);
+                }
+            });
+        }
+
+        // The archive is always fresh, so there's never anything to read or delete
+        public override Stream? OpenFileForReading(string filePath)
+            => null;
+
+        public override void DeleteFile(string filePath)
+        { }
+
+        public override void Dispose()
+        {
+            lock (Archive)
+            {
+                if (IsDisposed)
+                { return; }
+
+                IsDisposed = true;
+                Archive.Dispose();
+            }
+        }
+    }
+}
@@ -8,10 +8,14 @@ namespace Biohazrd.Transformation.Common
     /// <remarks>
     /// <see cref="BrokenDeclarations"/> is not reset between transforms, meaning this transformation
     /// can be used more than once to remove broken declarations at different points in the pipeline.
+    ///
+    /// Use <see cref="GetDiagnostics(TranslatedDeclaration)"/> to get the diagnostics of a broken declaration, including any which were recorded in the
+    /// <see cref="TranslatedLibrary.DiagnosticLog"/> of the library it was extracted from.
     /// </remarks>
     public sealed class BrokenDeclarationExtractor : TransformationBase
     {
         private readonly ConcurrentBag<TranslatedDeclaration> _BrokenDeclarations = new();
+        private readonly TranslationDiagnosticLog.Builder LoggedDiagnostics = TranslationDiagnosticLog.Empty.ToBuilder();
 
         private ImmutableArray<TranslatedDeclaration> BrokenDeclarationsCached;
         public ImmutableArray<TranslatedDeclaration> BrokenDeclarations
@@ -32,13 +36,32 @@ namespace Biohazrd.Transformation.Common
         protected override TransformationResult TransformDeclaration(TransformationContext context, TranslatedDeclaration declaration)
         {
             // Remove any declarations which have errors
-            if (declaration.Diagnostics.Any(d => d.IsError))
+            ImmutableArray<TranslationDiagnostic> diagnostics = context.GetDiagnostics(declaration);
+            if (diagnostics.Any(d => d.IsError))
             {
+                // The declaration is leaving the library, so we keep track of the diagnostics which were logged for it there
+                if (context.Library.DiagnosticLog is not null)
+                { LoggedDiagnostics.AddRange(declaration.Id, context.Library.DiagnosticLog.Get(declaration.Id)); }
+
                 _BrokenDeclarations.Add(declaration);
                 return null;
             }
 
             return declaration;
         }
+
+        /// <summary>Gets all diagnostics associated with the specified broken declaration.</summary>
+        /// <remarks>This includes both the declaration's <see cref="TranslatedDeclaration.Diagnostics"/> and any diagnostics recorded for it in the diagnostic log of the library it was extracted from.</remarks>
+        public ImmutableArray<TranslationDiagnostic> GetDiagnostics(TranslatedDeclaration declaration)
+        {
+            ImmutableArray<TranslationDiagnostic> loggedDiagnostics = LoggedDiagnostics.Get(declaration.Id);
+
+            if (loggedDiagnostics.IsEmpty)
+            { return declaration.Diagnostics; }
+            else if (declaration.Diagnostics.IsEmpty)
+            { return loggedDiagnostics; }
+            else
+            { return declaration.Diagnostics.AddRange(loggedDiagnostics); }
+        }
     }
 }
@@ -1,80 +1,77 @@
 ﻿using System.Collections.Generic;
+using System.Collections.Immutable;
 using System.Diagnostics;
+using System.Linq;
 
 namespace Biohazrd.Transformation.Common
 {
     public sealed class DeduplicateNamesTransformation : TransformationBase
     {
-        private readonly Dictionary<(object Parent, string Name), int> NextSuffixNumber = new();
+        // (Parent, Declaration) => New name
+        private ImmutableDictionary<(object Parent, TranslatedDeclaration Declaration), string> NewNames = ImmutableDictionary<(object, TranslatedDeclaration), string>.Empty;
 
-        protected override bool SupportsConcurrency => false;
-
-        private class DuplicateNamesFinder : DeclarationVisitor
+        private static IEnumerable<((object Parent, TranslatedDeclaration Declaration) Key, string NewName)> FindDuplicateNames(IEnumerable<TranslatedDeclaration> declarations)
         {
-            private readonly DeduplicateNamesTransformation Transformation;
+            HashSet<string> foundNames = new();
+            Dictionary<string, int>? nextSuffixNumber = null;
 
-            private void FindDuplicateNames(IEnumerable<TranslatedDeclaration> declarations)
+            foreach (TranslatedDeclaration declaration in declarations)
             {
-                HashSet<string> FoundNames = new();
-                HashSet<string> FoundDuplicates = new();
-
-                foreach (TranslatedDeclaration declaration in declarations)
+                if (!foundNames.Add(declaration.Name))
                 {
-                    if (!FoundNames.Add(declaration.Name))
-                    { FoundDuplicates.Add(declaration.Name); }
+                    nextSuffixNumber ??= new Dictionary<string, int>();
+                    nextSuffixNumber.TryAdd(declaration.Name, 0);
                 }
-
-                foreach (string duplicateName in FoundDuplicates)
-                { Transformation.NextSuffixNumber.Add((declarations, duplicateName), 0); }
             }
 
-            public DuplicateNamesFinder(DeduplicateNamesTransformation transformation, TranslatedLibrary library)
-            {
-                Transformation = transformation;
-                FindDuplicateNames(library);
-            }
+            if (nextSuffixNumber is null)
+            { yield break; }
 
-            protected override void VisitDeclaration(VisitorContext context, TranslatedDeclaration declaration)
+            // Suffixes are assigned in the order the declarations will be transformed
+            foreach (TranslatedDeclaration declaration in declarations)
             {
-                FindDuplicateNames(declaration);
-                base.VisitDeclaration(context, declaration);
+                // Don't rename functions since overloading allows duplicates
+                if (declaration is TranslatedFunction)
+                { continue; }
+
+                if (nextSuffixNumber.TryGetValue(declaration.Name, out int suffixNumber))
+                {
+                    nextSuffixNumber[declaration.Name] = suffixNumber + 1;
+                    yield return ((declarations, declaration), $"{declaration.Name}_{suffixNumber}");
+                }
             }
         }
 
         protected override TranslatedLibrary PreTransformLibrary(TranslatedLibrary library)
         {
-            Debug.Assert(NextSuffixNumber.Count == 0, "The suffix number dictionary should be empty.");
-            NextSuffixNumber.Clear();
+            Debug.Assert(NewNames.IsEmpty, "The new names dictionary should be empty.");
 
             // Find all the the names we will deduplicate
-            new DuplicateNamesFinder(this, library).Visit(library);
+            // Each set of siblings is independent from the others, so they're analyzed in parallel.
+            List<IEnumerable<TranslatedDeclaration>> parents = new() { library };
+            foreach (TranslatedDeclaration declaration in library.EnumerateRecursively())
+            { parents.Add(declaration); }
 
-            return library;
-        }
+            NewNames = parents.AsParallel()
+                .SelectMany(FindDuplicateNames)
+                .ToImmutableDictionary(r => r.Key, r => r.NewName);
 
-        protected override TranslatedLibrary PostTransformLibrary(TranslatedLibrary library)
-        {
-            NextSuffixNumber.Clear();
             return library;
         }
 
+        protected override void ResetTransformationState()
+            => NewNames = ImmutableDictionary<(object, TranslatedDeclaration), string>.Empty;
+
         protected override TransformationResult TransformDeclaration(TransformationContext context, TranslatedDeclaration declaration)
         {
-            // Don't rename functions since overloading allows duplicates
-            if (declaration is TranslatedFunction)
-            { return declaration; }
-
-            (object, string) key = (context.Parent, declaration.Name);
-
-            if (NextSuffixNumber.TryGetValue(key, out int suffixNumber))
+            if (NewNames.TryGetValue((context.Parent, declaration), out string? newName))
             {
-                NextSuffixNumber[key] = suffixNumber + 1;
-                string newName = $"{declaration.Name}_{suffixNumber}";
-                return declaration with
-                {
-                    Name = newName,
-                    Diagnostics = declaration.Diagnostics.Add(Severity.Warning, $"Renamed duplicate {declaration.GetType()} declaration '{declaration.Name}' -> '{newName}'")
-                };
+                return context.AddDiagnostic
+                (
+                    declaration with { Name = newName },
+                    Severity.Warning,
+                    $"Renamed duplicate {declaration.GetType()} declaration '{declaration.Name}' -> '{newName}'"
+                );
             }
 
             return declaration;
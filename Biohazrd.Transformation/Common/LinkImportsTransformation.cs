@@ -191,20 +191,18 @@ namespace Biohazrd.Transformation.Common
 
             if (!Resolve(declaration.MangledName, out resolvedDll, out resolvedName, ref diagnostics, isFunction: true, isVirtualMethod: declaration.IsVirtual))
             {
-                // If there's no changes, don't modify the function
-                if (!diagnostics.HasDiagnostics)
-                { return declaration; }
-
-                resolvedDll = declaration.DllFileName;
-                resolvedName = declaration.MangledName;
+                // If the symbol could not be resolved, only diagnostics need to be added (if any)
+                return context.AddDiagnostics(declaration, diagnostics.MoveToImmutable());
             }
 
-            return declaration with
+            TranslatedFunction result = declaration with
             {
                 DllFileName = resolvedDll,
                 MangledName = resolvedName,
-                Diagnostics = declaration.Diagnostics.AddRange(diagnostics.MoveToImmutable())
+                // Final virtual methods can only ever dispatch to this implementation, so they can be called directly once we know where they live
+                IsDevirtualized = declaration.IsFinal
             };
+            return context.AddDiagnostics(result, diagnostics.MoveToImmutable());
         }
 
         protected override TransformationResult TransformStaticField(TransformationContext context, TranslatedStaticField declaration)
@@ -215,20 +213,16 @@ namespace Biohazrd.Transformation.Common
 
             if (!Resolve(declaration.MangledName, out resolvedDll, out resolvedName, ref diagnostics, isFunction: false, isVirtualMethod: false))
             {
-                // If there's no changes, don't modify the field
-                if (!diagnostics.HasDiagnostics)
-                { return declaration; }
-
-                resolvedDll = declaration.DllFileName;
-                resolvedName = declaration.MangledName;
+                // If the symbol could not be resolved, only diagnostics need to be added (if any)
+                return context.AddDiagnostics(declaration, diagnostics.MoveToImmutable());
             }
 
-            return declaration with
+            TranslatedStaticField result = declaration with
             {
                 DllFileName = resolvedDll,
-                MangledName = resolvedName,
-                Diagnostics = declaration.Diagnostics.AddRange(diagnostics.MoveToImmutable())
+                MangledName = resolvedName
             };
+            return context.AddDiagnostics(result, diagnostics.MoveToImmutable());
         }
 
         private class SymbolEntry
@@ -6,6 +6,17 @@ namespace Biohazrd.Transformation.Common
 {
     public class TypeReductionTransformation : TypeTransformationBase
     {
+        protected override bool MemoizeTypeTransformations => true;
+
+        /// <remarks>
+        /// Most type reductions only depend on the type being reduced, but constant arrays and incomplete arrays are reduced differently depending on where they're used.
+        /// (Attributed types are also excluded since their diagnostics refer to the context.)
+        ///
+        /// If you extend this transformation with reductions that depend on the context, you must override this method to return false for the affected types.
+        /// </remarks>
+        protected override bool IsTransformTypeContextFree(TypeReference type)
+            => type is not ClangTypeReference { ClangType: ConstantArrayType or IncompleteArrayType or AttributedType };
+
         protected override TypeTransformationResult TransformClangTypeReference(TypeTransformationContext context, ClangTypeReference type)
         {
             switch (type.ClangType)
@@ -0,0 +1,47 @@
+﻿using Biohazrd.Expressions;
+using System;
+using System.Threading.Tasks;
+
+namespace Biohazrd.Transformation
+{
+    public static class ConstantEvaluationPipeline
+    {
+        /// <summary>Transforms a library while a constant evaluation runs in the background, then inserts the evaluation results into the transformed library.</summary>
+        /// <param name="evaluation">The pending evaluation, typically from <see cref="TranslatedLibraryConstantEvaluator.EvaluateBatchAsync(System.Collections.Generic.IReadOnlyList{string}, System.Threading.CancellationToken, IProgress{TranslationProgress}?)"/>.</param>
+        /// <param name="transform">The transformations to apply to the library while the evaluation is running. This runs on the calling thread.</param>
+        /// <param name="insertResults">
+        /// Called once both the transformations and the evaluation have completed to record the declarations (and any diagnostics) created from the evaluation results.
+        /// The edits are applied to the transformed library using <see cref="TranslatedLibraryEditExtensions.Edit(TranslatedLibrary, Action{TranslatedLibraryEditBuilder})"/>.
+        /// </param>
+        /// <remarks>
+        /// Constant evaluators use their own translation unit, so it's safe to transform the library concurrently with the evaluation.
+        /// Note that the results are inserted after <paramref name="transform"/> runs, so any declarations created from them will not be seen by those transformations.
+        /// </remarks>
+        public static TranslatedLibrary TransformWhileEvaluating
+        (
+            this TranslatedLibrary library,
+            Task<ConstantEvaluationBatchResult> evaluation,
+            Func<TranslatedLibrary, TranslatedLibrary> transform,
+            Action<TranslatedLibraryEditBuilder, ConstantEvaluationBatchResult> insertResults
+        )
+        {
+            library = transform(library);
+            ConstantEvaluationBatchResult results = evaluation.GetAwaiter().GetResult();
+            return library.Edit(builder => insertResults(builder, results));
+        }
+
+        /// <inheritdoc cref="TransformWhileEvaluating(TranslatedLibrary, Task{ConstantEvaluationBatchResult}, Func{TranslatedLibrary, TranslatedLibrary}, Action{TranslatedLibraryEditBuilder, ConstantEvaluationBatchResult})"/>
+        public static async Task<TranslatedLibrary> TransformWhileEvaluatingAsync
+        (
+            this TranslatedLibrary library,
+            Task<ConstantEvaluationBatchResult> evaluation,
+            Func<TranslatedLibrary, TranslatedLibrary> transform,
+            Action<TranslatedLibraryEditBuilder, ConstantEvaluationBatchResult> insertResults
+        )
+        {
+            library = transform(library);
+            ConstantEvaluationBatchResult results = await evaluation.ConfigureAwait(false);
+            return library.Edit(builder => insertResults(builder, results));
+        }
+    }
+}
@@ -20,41 +20,69 @@ namespace Biohazrd.Transformation
 
         private volatile TranslatedLibrary? _CurrentLibrary;
 
-        public TranslatedLibrary Transform(TranslatedLibrary library)
+        /// <summary>Applies this transformation to the specified library.</summary>
+        /// <param name="cancellationToken">A token used to cancel the transformation. Cancellation is observed between top-level declarations.</param>
+        /// <param name="progress">If specified, receives the number of top-level declarations transformed out of the total.</param>
+        public TranslatedLibrary Transform(TranslatedLibrary library, CancellationToken cancellationToken = default, IProgress<TranslationProgress>? progress = null)
         {
             // Ensure this instance is not used from multiple threads
             // This is to protect against invalid use with transformations which need to store state about the library being processed
             if (Interlocked.CompareExchange(ref _CurrentLibrary, library, null) is not null)
             { throw new InvalidOperationException("This instance is alreadyh being used from another thread to process a different library."); }
 
-            library = PreTransformLibrary(library);
+            try
+            {
+                cancellationToken.ThrowIfCancellationRequested();
+                library = PreTransformLibrary(library);
 
-            TransformationContext context = new(library);
-            using ListTransformHelper newDeclarations = new(library.Declarations);
+                TranslationDiagnosticLog.Builder? pendingDiagnostics = library.DiagnosticLog?.ToBuilder();
+                TransformationContext context = new(library, pendingDiagnostics);
+                using ListTransformHelper newDeclarations = new(library.Declarations);
 
-            // Recursively transform each declaration in the library
-            foreach (TranslatedDeclaration declaration in library.Declarations)
-            {
-                TransformationResult transformedDeclaration = TransformRecursively(context, declaration);
-                newDeclarations.Add(transformedDeclaration);
-            }
+                // Recursively transform each declaration in the library
+                int completed = 0;
+                int total = library.Declarations.Count;
+                foreach (TranslatedDeclaration declaration in library.Declarations)
+                {
+                    cancellationToken.ThrowIfCancellationRequested();
+                    TransformationResult transformedDeclaration = TransformRecursively(context, declaration);
+                    newDeclarations.Add(transformedDeclaration);
+                    completed++;
+                    progress?.Report(new TranslationProgress(completed, total));
+                }
 
-            // If the declarations list mutated, create a new library
-            if (newDeclarations.WasChanged)
-            {
-                library = library with
+                // If the declarations list mutated, create a new library
+                if (newDeclarations.WasChanged)
                 {
-                    Declarations = newDeclarations.ToImmutable()
-                };
-            }
+                    library = library with
+                    {
+                        Declarations = newDeclarations.ToImmutable()
+                    };
+                }
 
-            library = PostTransformLibrary(library);
+                // If any diagnostics were logged, attach the new version of the log to the library
+                if (pendingDiagnostics is not null && pendingDiagnostics.HasChanges)
+                {
+                    library = library with
+                    {
+                        DiagnosticLog = pendingDiagnostics.ToImmutable()
+                    };
+                }
 
-            // Release this instance from processing the library
-            _CurrentLibrary = null;
+                cancellationToken.ThrowIfCancellationRequested();
+                library = PostTransformLibrary(library);
 
-            // Return the modified library
-            return library;
+                // Return the modified library
+                return library;
+            }
+            finally
+            {
+                // Release this instance from processing the library
+                // (This is done even when the transformation fails or is cancelled so the instance can be reused.)
+                ResetTransformationState();
+                TransformationComplete();
+                _CurrentLibrary = null;
+            }
         }
 
         protected virtual TranslatedLibrary PreTransformLibrary(TranslatedLibrary library)
@@ -63,6 +91,18 @@ namespace Biohazrd.Transformation
         protected virtual TranslatedLibrary PostTransformLibrary(TranslatedLibrary library)
             => library;
 
+        /// <summary>Called after every call to <see cref="Transform(TranslatedLibrary, CancellationToken, IProgress{TranslationProgress}?)"/> to clear any state specific to the library which was being processed.</summary>
+        /// <remarks>
+        /// This is called whether the transformation completed, failed, or was cancelled.
+        /// Transformations which store per-library state in <see cref="PreTransformLibrary(TranslatedLibrary)"/> should clear it here so the instance can be reused.
+        /// </remarks>
+        protected virtual void ResetTransformationState()
+        { }
+
+        /// <summary>Called after a library has been completely processed so infrastructure state specific to that library can be released.</summary>
+        private protected virtual void TransformationComplete()
+        { }
+
         private TransformationResult TransformRecursively(TransformationContext context, TranslatedDeclaration declaration)
         {
             // Transform this declaration
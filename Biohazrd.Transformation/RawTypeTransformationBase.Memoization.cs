@@ -0,0 +1,85 @@
+﻿using System;
+using System.Collections.Concurrent;
+using System.Collections.Immutable;
+
+namespace Biohazrd.Transformation
+{
+    partial class RawTypeTransformationBase
+    {
+        // Tracks whether the type transformation currently being memoized on this thread observed a type which could not be transformed without context
+        [ThreadStatic]
+        private static bool CurrentTransformationIsContextDependent;
+
+        private volatile TypeTransformationMemo? _Memo;
+
+        private TypeTransformationMemo? GetMemo(TranslatedLibrary library)
+        {
+            if (!MemoizeTypeTransformations)
+            { return null; }
+
+            // Memoized results are only valid for the library they were created for
+            TypeTransformationMemo? memo = _Memo;
+            if (memo is null || !ReferenceEquals(memo.Library, library))
+            { _Memo = memo = new TypeTransformationMemo(library); }
+
+            return memo;
+        }
+
+        private protected override void TransformationComplete()
+        {
+            _Memo = null;
+            base.TransformationComplete();
+        }
+
+        private TypeTransformationResult TransformTypeTrackingContextDependence(TypeTransformationContext context, TypeReference type)
+        {
+            if (MemoizeTypeTransformations && !CurrentTransformationIsContextDependent && !IsTransformTypeContextFree(type))
+            { CurrentTransformationIsContextDependent = true; }
+
+            return TransformType(context, type);
+        }
+
+        private sealed class TypeTransformationMemo
+        {
+            public TranslatedLibrary Library { get; }
+            private readonly ConcurrentDictionary<TypeReference, MemoizedResult> Results = new();
+            private readonly TypeReferenceInternPool InternPool = new();
+
+            public TypeTransformationMemo(TranslatedLibrary library)
+                => Library = library;
+
+            public bool TryGetValue(TypeReference type, out TypeTransformationResult result)
+            {
+                if (Results.TryGetValue(type, out MemoizedResult memoizedResult))
+                {
+                    result = new TypeTransformationResult(memoizedResult.TypeReference, memoizedResult.Diagnostics);
+                    return true;
+                }
+
+                result = default;
+                return false;
+            }
+
+            public TypeTransformationResult Add(TypeReference type, TypeTransformationResult result)
+            {
+                MemoizedResult memoizedResult = new(InternPool.Intern(result.TypeReference), result.Diagnostics);
+
+                // If another thread beat us to memoizing this type we use their result so that the interned instance is shared
+                memoizedResult = Results.GetOrAdd(type, memoizedResult);
+                return new TypeTransformationResult(memoizedResult.TypeReference, memoizedResult.Diagnostics);
+            }
+
+            private readonly struct MemoizedResult
+            {
+                public readonly TypeReference TypeReference;
+                public readonly ImmutableArray<TranslationDiagnostic> Diagnostics;
+
+                public MemoizedResult(TypeReference typeReference, ImmutableArray<TranslationDiagnostic> diagnostics)
+                {
+                    TypeReference = typeReference;
+                    Diagnostics = diagnostics;
+                }
+            }
+        }
+    }
+}
@@ -6,128 +6,120 @@
         {
             TypeTransformationResult result = TransformTypeRecursively(context, declaration.UnderlyingType);
 
-            if (result.IsChange(declaration.UnderlyingType))
+            // If the type didn't change, let the context decide how to record any diagnostics
+            if (result.TypeReference == declaration.UnderlyingType)
+            { return context.AddDiagnostics(declaration, result.Diagnostics); }
+
+            return declaration with
             {
-                return declaration with
-                {
-                    UnderlyingType = result.TypeReference,
-                    Diagnostics = declaration.Diagnostics.AddRange(result.Diagnostics)
-                };
-            }
-            else
-            { return declaration; }
+                UnderlyingType = result.TypeReference,
+                Diagnostics = declaration.Diagnostics.AddRange(result.Diagnostics)
+            };
         }
 
         private TransformationResult TransformFunctionTypeReferences(TransformationContext context, TranslatedFunction declaration)
         {
             TypeTransformationResult result = TransformTypeRecursively(context, declaration.ReturnType);
 
-            if (result.IsChange(declaration.ReturnType))
+            // If the type didn't change, let the context decide how to record any diagnostics
+            if (result.TypeReference == declaration.ReturnType)
+            { return context.AddDiagnostics(declaration, result.Diagnostics); }
+
+            return declaration with
             {
-                return declaration with
-                {
-                    ReturnType = result.TypeReference,
-                    Diagnostics = declaration.Diagnostics.AddRange(result.Diagnostics)
-                };
-            }
-            else
-            { return declaration; }
+                ReturnType = result.TypeReference,
+                Diagnostics = declaration.Diagnostics.AddRange(result.Diagnostics)
+            };
         }
 
         private TransformationResult TransformParameterTypeReferences(TransformationContext context, TranslatedParameter declaration)
         {
             TypeTransformationResult result = TransformTypeRecursively(context, declaration.Type);
 
-            if (result.IsChange(declaration.Type))
+            // If the type didn't change, let the context decide how to record any diagnostics
+            if (result.TypeReference == declaration.Type)
+            { return context.AddDiagnostics(declaration, result.Diagnostics); }
+
+            return declaration with
             {
-                return declaration with
-                {
-                    Type = result.TypeReference,
-                    Diagnostics = declaration.Diagnostics.AddRange(result.Diagnostics)
-                };
-            }
-            else
-            { return declaration; }
+                Type = result.TypeReference,
+                Diagnostics = declaration.Diagnostics.AddRange(result.Diagnostics)
+            };
         }
 
         private TransformationResult TransformStaticFieldTypeReferences(TransformationContext context, TranslatedStaticField declaration)
         {
             TypeTransformationResult result = TransformTypeRecursively(context, declaration.Type);
 
-            if (result.IsChange(declaration.Type))
+            // If the type didn't change, let the context decide how to record any diagnostics
+            if (result.TypeReference == declaration.Type)
+            { return context.AddDiagnostics(declaration, result.Diagnostics); }
+
+            return declaration with
             {
-                return declaration with
-                {
-                    Type = result.TypeReference,
-                    Diagnostics = declaration.Diagnostics.AddRange(result.Diagnostics)
-                };
-            }
-            else
-            { return declaration; }
+                Type = result.TypeReference,
+                Diagnostics = declaration.Diagnostics.AddRange(result.Diagnostics)
+            };
         }
 
         private TransformationResult TransformBaseFieldTypeReferences(TransformationContext context, TranslatedBaseField declaration)
         {
             TypeTransformationResult result = TransformTypeRecursively(context, declaration.Type);
 
-            if (result.IsChange(declaration.Type))
+            // If the type didn't change, let the context decide how to record any diagnostics
+            if (result.TypeReference == declaration.Type)
+            { return context.AddDiagnostics(declaration, result.Diagnostics); }
+
+            return declaration with
             {
-                return declaration with
-                {
-                    Type = result.TypeReference,
-                    Diagnostics = declaration.Diagnostics.AddRange(result.Diagnostics)
-                };
-            }
-            else
-            { return declaration; }
+                Type = result.TypeReference,
+                Diagnostics = declaration.Diagnostics.AddRange(result.Diagnostics)
+            };
         }
 
         private TransformationResult TransformNormalFieldTypeReferences(TransformationContext context, TranslatedNormalField declaration)
         {
             TypeTransformationResult result = TransformTypeRecursively(context, declaration.Type);
 
-            if (result.IsChange(declaration.Type))
+            // If the type didn't change, let the context decide how to record any diagnostics
+            if (result.TypeReference == declaration.Type)
+            { return context.AddDiagnostics(declaration, result.Diagnostics); }
+
+            return declaration with
             {
-                return declaration with
-                {
-                    Type = result.TypeReference,
-                    Diagnostics = declaration.Diagnostics.AddRange(result.Diagnostics)
-                };
-            }
-            else
-            { return declaration; }
+                Type = result.TypeReference,
+                Diagnostics = declaration.Diagnostics.AddRange(result.Diagnostics)
+            };
         }
 
         private TransformationResult TransformTypedefTypeReferences(TransformationContext context, TranslatedTypedef declaration)
         {
             TypeTransformationResult result = TransformTypeRecursively(context, declaration.UnderlyingType);
 
-            if (result.IsChange(declaration.UnderlyingType))
+            // If the type didn't change, let the context decide how to record any diagnostics
+            if (result.TypeReference == declaration.UnderlyingType)
+            { return context.AddDiagnostics(declaration, result.Diagnostics); }
+
+            return declaration with
             {
-                return declaration with
-                {
-                    UnderlyingType = result.TypeReference,
-                    Diagnostics = declaration.Diagnostics.AddRange(result.Diagnostics)
-                };
-            }
-            else
-            { return declaration; }
+                UnderlyingType = result.TypeReference,
+                Diagnostics = declaration.Diagnostics.AddRange(result.Diagnostics)
+            };
         }
 
         private TransformationResult TransformVTableEntryTypeReferences(TransformationContext context, TranslatedVTableEntry declaration)
         {
             TypeTransformationResult result = TransformTypeRecursively(context, declaration.Type);
 
-            if (result.IsChange(declaration.Type))
+            // If the type didn't change, let the context decide how to record any diagnostics
+            if (result.TypeReference == declaration.Type)
+            { return context.AddDiagnostics(declaration, result.Diagnostics); }
+
+            return declaration with
             {
-                return declaration with
-                {
-                    Type = result.TypeReference,
-                    Diagnostics = declaration.Diagnostics.AddRange(result.Diagnostics)
-                };
-            }
-            else
-            { return declaration; }
+                Type = result.TypeReference,
+                Diagnostics = declaration.Diagnostics.AddRange(result.Diagnostics)
+            };
         }
     }
 }
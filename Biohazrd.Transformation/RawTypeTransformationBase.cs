@@ -9,10 +9,52 @@ namespace Biohazrd.Transformation
         /// <remarks>Persistent transformation only occurs when the actual type reference changes. Persistent transformation does not occur if only diagnostics are added.</remarks>
         protected virtual bool PersistentTypeTransformation => true;
 
+        /// <summary>If true, the results of <see cref="TransformTypeRecursively"/> will be memoized per unique type reference for the duration of a single pass.</summary>
+        /// <remarks>
+        /// A result is only memoized when <see cref="IsTransformTypeContextFree(TypeReference)"/> returned true for every type passed to <see cref="TransformType"/> while producing it.
+        /// Memoized type references are interned, so structurally equal types transformed by the same pass will share a single instance.
+        ///
+        /// Transformations which enable memoization must not rely on the context in <see cref="TransformTypeChildren"/> and must not have side-effects which need to happen once per type reference.
+        /// </remarks>
+        protected virtual bool MemoizeTypeTransformations => false;
+
+        /// <summary>Indicates whether the result of <see cref="TransformType"/> for the given type only depends on the type itself and the library being transformed.</summary>
+        /// <remarks>This method is only consulted when <see cref="MemoizeTypeTransformations"/> is true.</remarks>
+        protected virtual bool IsTransformTypeContextFree(TypeReference type)
+            => false;
+
         protected TypeTransformationResult TransformTypeRecursively(TypeTransformationContext context, TypeReference type)
+        {
+            TypeTransformationMemo? memo = GetMemo(context.Library);
+
+            // Memoization is disabled for this transformation
+            if (memo is null)
+            { return TransformTypeRecursivelyCore(context, type); }
+
+            // If we already transformed an equivalent type in a context-free manner, reuse that result
+            if (memo.TryGetValue(type, out TypeTransformationResult memoizedResult))
+            { return memoizedResult; }
+
+            // Transform the type while tracking whether any context-dependent type transformations occur
+            bool outerTransformationIsContextDependent = CurrentTransformationIsContextDependent;
+            CurrentTransformationIsContextDependent = false;
+            try
+            {
+                TypeTransformationResult result = TransformTypeRecursivelyCore(context, type);
+
+                if (!CurrentTransformationIsContextDependent)
+                { result = memo.Add(type, result); }
+
+                return result;
+            }
+            finally
+            { CurrentTransformationIsContextDependent |= outerTransformationIsContextDependent; }
+        }
+
+        private TypeTransformationResult TransformTypeRecursivelyCore(TypeTransformationContext context, TypeReference type)
         {
             // Transform this type
-            TypeTransformationResult result = TransformType(context, type);
+            TypeTransformationResult result = TransformTypeTrackingContextDependence(context, type);
 
             // Persistently transform if applicable
             if (PersistentTypeTransformation)
@@ -24,7 +66,7 @@ namespace Biohazrd.Transformation
                     previousResult = result.TypeReference;
                     ImmutableArray<TranslationDiagnostic> previousDiagnostics = result.Diagnostics;
 
-                    result = TransformType(context, previousResult);
+                    result = TransformTypeTrackingContextDependence(context, previousResult);
 
                     // Preserve diagnostics emitted during the previous iteration
                     result = result.AddDiagnostics(previousDiagnostics);
@@ -9,6 +9,9 @@ namespace Biohazrd.Transformation
         public TranslatedLibrary Library { get; }
         public ImmutableArray<TranslatedDeclaration> Parents { get; init; }
 
+        /// <summary>Diagnostics recorded during the current transformation pass, or <c>null</c> if the library has no <see cref="TranslatedLibrary.DiagnosticLog"/>.</summary>
+        private readonly TranslationDiagnosticLog.Builder? PendingDiagnostics;
+
         /// <summary>The parent declaration of the declaration (if it has one.)</summary>
         /// <remarks>To enumerate siblings of the declaration, use <see cref="Parent"/> instead.</remarks>
         public TranslatedDeclaration? ParentDeclaration => Parents.IsEmpty ? null : Parents[Parents.Length - 1];
@@ -21,10 +24,11 @@ namespace Biohazrd.Transformation
         /// </remarks>
         public IEnumerable<TranslatedDeclaration> Parent => (IEnumerable<TranslatedDeclaration>?)ParentDeclaration ?? Library;
 
-        internal TransformationContext(TranslatedLibrary library)
+        internal TransformationContext(TranslatedLibrary library, TranslationDiagnosticLog.Builder? pendingDiagnostics)
         {
             Library = library;
             Parents = ImmutableArray<TranslatedDeclaration>.Empty;
+            PendingDiagnostics = pendingDiagnostics;
         }
 
         private TransformationContext(TransformationContext other)
@@ -36,6 +40,68 @@ namespace Biohazrd.Transformation
                 Parents = Parents.Add(newParent)
             };
 
+        /// <summary>Adds a diagnostic to the specified declaration.</summary>
+        /// <remarks>
+        /// If the library being transformed has a <see cref="TranslatedLibrary.DiagnosticLog"/>, the diagnostic is recorded in the log of the transformed library and
+        /// <paramref name="declaration"/> is returned as-is. (The log of the library being transformed is not modified.)
+        /// Otherwise a copy of <paramref name="declaration"/> with the diagnostic added to <see cref="TranslatedDeclaration.Diagnostics"/> is returned.
+        /// </remarks>
+        public TDeclaration AddDiagnostic<TDeclaration>(TDeclaration declaration, TranslationDiagnostic diagnostic)
+            where TDeclaration : TranslatedDeclaration
+        {
+            if (PendingDiagnostics is not null)
+            {
+                PendingDiagnostics.Add(declaration.Id, diagnostic);
+                return declaration;
+            }
+
+            return declaration with
+            {
+                Diagnostics = declaration.Diagnostics.Add(diagnostic)
+            };
+        }
+
+        /// <inheritdoc cref="AddDiagnostic{TDeclaration}(TDeclaration, TranslationDiagnostic)"/>
+        public TDeclaration AddDiagnostic<TDeclaration>(TDeclaration declaration, Severity severity, string message)
+            where TDeclaration : TranslatedDeclaration
+            => AddDiagnostic(declaration, new TranslationDiagnostic(severity, message));
+
+        /// <summary>Adds diagnostics to the specified declaration.</summary>
+        /// <remarks>See <see cref="AddDiagnostic{TDeclaration}(TDeclaration, TranslationDiagnostic)"/> for details.</remarks>
+        public TDeclaration AddDiagnostics<TDeclaration>(TDeclaration declaration, ImmutableArray<TranslationDiagnostic> diagnostics)
+            where TDeclaration : TranslatedDeclaration
+        {
+            if (diagnostics.IsDefaultOrEmpty)
+            { return declaration; }
+
+            if (PendingDiagnostics is not null)
+            {
+                PendingDiagnostics.AddRange(declaration.Id, diagnostics);
+                return declaration;
+            }
+
+            return declaration with
+            {
+                Diagnostics = declaration.Diagnostics.AddRange(diagnostics)
+            };
+        }
+
+        /// <summary>Gets all diagnostics associated with the specified declaration, including any added earlier in the current transformation.</summary>
+        public ImmutableArray<TranslationDiagnostic> GetDiagnostics(TranslatedDeclaration declaration)
+        {
+            if (PendingDiagnostics is null)
+            { return Library.GetDiagnostics(declaration); }
+
+            ImmutableArray<TranslationDiagnostic> loggedDiagnostics = PendingDiagnostics.Get(declaration.Id);
+
+            if (loggedDiagnostics.IsEmpty)
+            { return declaration.Diagnostics; }
+            else if (declaration.Diagnostics.IsEmpty)
+            { return loggedDiagnostics; }
+            else
+            { return declaration.Diagnostics.AddRange(loggedDiagnostics); }
+        }
+
         public override string ToString()
         {
             StringBuilder builder = new();
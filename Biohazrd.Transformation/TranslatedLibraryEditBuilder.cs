@@ -0,0 +1,100 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Collections.Immutable;
+
+namespace Biohazrd.Transformation
+{
+    /// <summary>Accumulates a batch of edits to be applied to a <see cref="TranslatedLibrary"/> all at once.</summary>
+    /// <remarks>
+    /// Instances of this type are obtained via <see cref="TranslatedLibraryEditExtensions.Edit(TranslatedLibrary, Action{TranslatedLibraryEditBuilder})"/>.
+    ///
+    /// Edits are applied against declaration IDs (see <see cref="TranslatedDeclaration.Id"/> and <see cref="TranslatedDeclaration.ReplacedIds"/>) in a single rebuild of the library.
+    /// Applying the edits walks the entire declaration tree once (serially), but only the parts of the tree which lead to an edited declaration are rebuilt.
+    /// </remarks>
+    public sealed class TranslatedLibraryEditBuilder
+    {
+        internal ImmutableList<TranslatedDeclaration>.Builder Additions { get; } = ImmutableList.CreateBuilder<TranslatedDeclaration>();
+        internal HashSet<DeclarationId> Removals { get; } = new();
+        internal Dictionary<DeclarationId, ImmutableList<TranslatedDeclaration>> Replacements { get; } = new();
+        internal Dictionary<DeclarationId, ImmutableArray<TranslationDiagnostic>.Builder> Diagnostics { get; } = new();
+
+        /// <summary>True if any edits which need to locate existing declarations have been made.</summary>
+        internal bool HasDeclarationEdits => Removals.Count > 0 || Replacements.Count > 0 || Diagnostics.Count > 0;
+
+        internal TranslatedLibraryEditBuilder()
+        { }
+
+        private void VerifyNotRemoved(DeclarationId id)
+        {
+            if (Removals.Contains(id))
+            { throw new InvalidOperationException($"{id} has already been removed in this edit."); }
+        }
+
+        /// <summary>Adds a new declaration to the root of the library.</summary>
+        public void Add(TranslatedDeclaration declaration)
+            => Additions.Add(declaration);
+
+        /// <summary>Adds new declarations to the root of the library.</summary>
+        public void AddRange(IEnumerable<TranslatedDeclaration> declarations)
+            => Additions.AddRange(declarations);
+
+        /// <summary>Removes the declaration with the specified ID from the library.</summary>
+        public void Remove(DeclarationId id)
+        {
+            if (Replacements.ContainsKey(id))
+            { throw new InvalidOperationException($"{id} cannot be removed because it has already been replaced in this edit."); }
+
+            if (Diagnostics.ContainsKey(id))
+            { throw new InvalidOperationException($"{id} cannot be removed because diagnostics have already been added to it in this edit."); }
+
+            Removals.Add(id);
+        }
+
+        /// <summary>Removes the specified declaration from the library.</summary>
+        public void Remove(TranslatedDeclaration declaration)
+            => Remove(declaration.Id);
+
+        /// <summary>Replaces the declaration with the specified ID with zero or more new declarations.</summary>
+        public void Replace(DeclarationId id, ImmutableList<TranslatedDeclaration> replacements)
+        {
+            VerifyNotRemoved(id);
+
+            if (!Replacements.TryAdd(id, replacements))
+            { throw new InvalidOperationException($"{id} has already been replaced in this edit."); }
+        }
+
+        /// <summary>Replaces the declaration with the specified ID with a new declaration.</summary>
+        public void Replace(DeclarationId id, TranslatedDeclaration replacement)
+            => Replace(id, ImmutableList.Create(replacement));
+
+        /// <summary>Replaces the specified declaration with a new declaration.</summary>
+        /// <remarks>Typically <paramref name="replacement"/> will be derived from <paramref name="declaration"/> via a <c>with</c> expression.</remarks>
+        public void Replace(TranslatedDeclaration declaration, TranslatedDeclaration replacement)
+            => Replace(declaration.Id, replacement);
+
+        /// <summary>Adds a diagnostic to the declaration with the specified ID.</summary>
+        /// <remarks>If the declaration is also replaced by this edit, the diagnostic will be added to all of its replacements.</remarks>
+        public void AddDiagnostic(DeclarationId id, TranslationDiagnostic diagnostic)
+        {
+            VerifyNotRemoved(id);
+
+            ImmutableArray<TranslationDiagnostic>.Builder? diagnostics;
+            if (!Diagnostics.TryGetValue(id, out diagnostics))
+            {
+                diagnostics = ImmutableArray.CreateBuilder<TranslationDiagnostic>();
+                Diagnostics.Add(id, diagnostics);
+            }
+
+            diagnostics.Add(diagnostic);
+        }
+
+        /// <summary>Adds a diagnostic to the declaration with the specified ID.</summary>
+        /// <remarks>If the declaration is also replaced by this edit, the diagnostic will be added to all of its replacements.</remarks>
+        public void AddDiagnostic(DeclarationId id, Severity severity, string message)
+            => AddDiagnostic(id, new TranslationDiagnostic(severity, message));
+
+        /// <summary>Adds a diagnostic to the specified declaration.</summary>
+        public void AddDiagnostic(TranslatedDeclaration declaration, Severity severity, string message)
+            => AddDiagnostic(declaration.Id, new TranslationDiagnostic(severity, message));
+    }
+}
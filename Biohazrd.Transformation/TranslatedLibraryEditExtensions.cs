@@ -0,0 +1,141 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Collections.Immutable;
+using System.Text;
+
+namespace Biohazrd.Transformation
+{
+    public static class TranslatedLibraryEditExtensions
+    {
+        /// <summary>Applies a batch of edits to the library in a single rebuild.</summary>
+        /// <param name="edit">A callback which records the desired edits to the provided <see cref="TranslatedLibraryEditBuilder"/>.</param>
+        /// <returns>The edited library, or <paramref name="library"/> if no edits were made.</returns>
+        /// <remarks>
+        /// This is preferable to making many consecutive modifications to <see cref="TranslatedLibrary.Declarations"/> or to individual declarations since
+        /// each of those modifications needs to copy the root declarations list and/or the spine of the declaration tree leading to the modified declaration.
+        ///
+        /// An <see cref="InvalidOperationException"/> will be thrown if any of the edited declarations could not be found in the library.
+        /// </remarks>
+        public static TranslatedLibrary Edit(this TranslatedLibrary library, Action<TranslatedLibraryEditBuilder> edit)
+        {
+            TranslatedLibraryEditBuilder builder = new();
+            edit(builder);
+
+            // Apply edits to existing declarations
+            if (builder.HasDeclarationEdits)
+            { library = new ApplyEditsTransformation(builder).Transform(library); }
+
+            // Apply additions
+            if (builder.Additions.Count > 0)
+            {
+                library = library with
+                {
+                    Declarations = library.Declarations.AddRange(builder.Additions)
+                };
+            }
+
+            return library;
+        }
+
+        private sealed class ApplyEditsTransformation : TransformationBase
+        {
+            private readonly TranslatedLibraryEditBuilder Edits;
+            private readonly HashSet<DeclarationId> UnappliedEdits = new();
+
+            // UnappliedEdits is modified during the transformation
+            protected override bool SupportsConcurrency => false;
+
+            public ApplyEditsTransformation(TranslatedLibraryEditBuilder edits)
+            {
+                Edits = edits;
+                UnappliedEdits.UnionWith(edits.Removals);
+                UnappliedEdits.UnionWith(edits.Replacements.Keys);
+                UnappliedEdits.UnionWith(edits.Diagnostics.Keys);
+            }
+
+            private bool TryGetEditId<TValue>(TranslatedDeclaration declaration, IReadOnlyDictionary<DeclarationId, TValue> edits, out DeclarationId id)
+            {
+                if (edits.ContainsKey(declaration.Id))
+                {
+                    id = declaration.Id;
+                    return true;
+                }
+
+                foreach (DeclarationId replacedId in declaration.ReplacedIds)
+                {
+                    if (edits.ContainsKey(replacedId))
+                    {
+                        id = replacedId;
+                        return true;
+                    }
+                }
+
+                id = default;
+                return false;
+            }
+
+            private bool IsRemoved(TranslatedDeclaration declaration)
+            {
+                if (Edits.Removals.Contains(declaration.Id))
+                {
+                    UnappliedEdits.Remove(declaration.Id);
+                    return true;
+                }
+
+                foreach (DeclarationId replacedId in declaration.ReplacedIds)
+                {
+                    if (Edits.Removals.Contains(replacedId))
+                    {
+                        UnappliedEdits.Remove(replacedId);
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            protected override TranslatedLibrary PostTransformLibrary(TranslatedLibrary library)
+            {
+                if (UnappliedEdits.Count > 0)
+                {
+                    StringBuilder message = new("The following declarations could not be found in the library:");
+                    foreach (DeclarationId id in UnappliedEdits)
+                    { message.Append($" {id}"); }
+
+                    throw new InvalidOperationException(message.ToString());
+                }
+
+                return library;
+            }
+
+            protected override TransformationResult TransformDeclaration(TransformationContext context, TranslatedDeclaration declaration)
+            {
+                if (IsRemoved(declaration))
+                { return null; }
+
+                // Collect any diagnostics for this declaration
+                ImmutableArray<TranslationDiagnostic> newDiagnostics = ImmutableArray<TranslationDiagnostic>.Empty;
+                if (TryGetEditId(declaration, Edits.Diagnostics, out DeclarationId diagnosticsId))
+                {
+                    newDiagnostics = Edits.Diagnostics[diagnosticsId].ToImmutable();
+                    UnappliedEdits.Remove(diagnosticsId);
+                }
+
+                // Apply the replacement if there is one
+                if (TryGetEditId(declaration, Edits.Replacements, out DeclarationId replacementId))
+                {
+                    UnappliedEdits.Remove(replacementId);
+                    ImmutableList<TranslatedDeclaration> replacements = Edits.Replacements[replacementId];
+
+                    if (newDiagnostics.Length > 0)
+                    { replacements = replacements.ConvertAll(replacement => context.AddDiagnostics(replacement, newDiagnostics)); }
+
+                    return new TransformationResult(replacements);
+                }
+
+                // Apply the diagnostics if there are any
+                return context.AddDiagnostics(declaration, newDiagnostics);
+            }
+        }
+    }
+}
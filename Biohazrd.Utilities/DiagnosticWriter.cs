@@ -26,11 +26,12 @@ namespace Biohazrd.Utilities
             ImmutableArray<DiagnosticOrSubcategory>.Builder translationDiagnostics = ImmutableArray.CreateBuilder<DiagnosticOrSubcategory>();
             foreach (TranslatedDeclaration declaration in library.EnumerateRecursively())
             {
-                if (declaration.Diagnostics.Length > 0)
+                ImmutableArray<TranslationDiagnostic> diagnostics = library.GetDiagnostics(declaration);
+                if (diagnostics.Length > 0)
                 {
                     translationDiagnostics.Add($"{declaration.GetType().Name} {declaration.Name}");
 
-                    foreach (TranslationDiagnostic diagnostic in declaration.Diagnostics)
+                    foreach (TranslationDiagnostic diagnostic in diagnostics)
                     { translationDiagnostics.Add(diagnostic); }
                 }
             }
@@ -46,7 +47,7 @@ namespace Biohazrd.Utilities
             {
                 diagnostics.Add($"{declaration.GetType().Name} {declaration.Name}");
 
-                foreach (TranslationDiagnostic diagnostic in declaration.Diagnostics)
+                foreach (TranslationDiagnostic diagnostic in brokenDeclarationExtractor.GetDiagnostics(declaration))
                 { diagnostics.Add(diagnostic); }
             }
 
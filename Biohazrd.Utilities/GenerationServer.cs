@@ -0,0 +1,337 @@
+﻿using Biohazrd.OutputGeneration;
+using System;
+using System.Collections.Generic;
+using System.Collections.Immutable;
+using System.Diagnostics;
+using System.IO;
+using System.IO.Pipes;
+using System.Linq;
+using System.Security.Cryptography;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace Biohazrd.Utilities
+{
+    /// <summary>Keeps a generator resident so that bindings can be regenerated on request without paying process startup and libclang initialization every time.</summary>
+    /// <remarks>
+    /// The server keeps the library builder warm and watches every file which contributed to the last translated library.
+    /// When a regeneration is requested and none of those files changed, the previous result is returned immediately.
+    /// Otherwise the library is reparsed, transformed, and emitted with <see cref="OutputSession.SkipUnchangedFiles"/> enabled so that only the output files which actually changed are touched.
+    ///
+    /// Clients communicate with the server over a local named pipe (see <see cref="SendRequestAsync(string, string, int, CancellationToken)"/>) using a simple line-based protocol.
+    /// Each request is a single line containing one of the commands below, and each response is a single line:
+    /// <list type="bullet">
+    /// <item>
+    /// <c>regenerate</c> / <c>regenerate-force</c> — Responds with <c>up-to-date</c> or <c>ok &lt;changed files&gt; &lt;unchanged files&gt; &lt;errors&gt; &lt;warnings&gt; &lt;milliseconds&gt;</c>.
+    /// If the library was regenerated in the background since the last request, the response describes that regeneration.
+    /// </item>
+    /// <item><c>shutdown</c> — Responds with <c>ok</c> and stops the server.</item>
+    /// </list>
+    /// Failures are reported as <c>error &lt;message&gt;</c>.
+    /// </remarks>
+    public sealed class GenerationServer : IDisposable
+    {
+        public string PipeName { get; }
+
+        /// <summary>If true, the library will be regenerated in the background shortly after any of its input files change.</summary>
+        /// <remarks>This makes the next regeneration request effectively instant in typical edit-regenerate-compile loops.</remarks>
+        public bool RegenerateOnChange { get; set; } = true;
+
+        /// <summary>How long to wait for file changes to settle before regenerating in the background.</summary>
+        public TimeSpan ChangeDebounceDelay { get; set; } = TimeSpan.FromMilliseconds(250);
+
+        private readonly TranslatedLibraryBuilder Builder;
+        private readonly Func<TranslatedLibrary, CancellationToken, TranslatedLibrary> Transform;
+        private readonly Func<TranslatedLibrary, OutputSession, CancellationToken, ImmutableArray<TranslationDiagnostic>> Generate;
+        private readonly Func<OutputSession> CreateSession;
+
+        private readonly object RegenerationLock = new();
+        private GenerationServerResult? LastResult;
+        // True when LastResult came from a background regeneration and hasn't been returned by Regenerate yet
+        private bool LastResultIsUnreported;
+        private Dictionary<string, string> InputHashes = new(StringComparer.OrdinalIgnoreCase);
+
+        private readonly List<FileSystemWatcher> Watchers = new();
+        private readonly Timer DebounceTimer;
+        private int InputsMightHaveChanged = 1;
+
+        /// <param name="pipeName">The name of the pipe used to serve regeneration requests.</param>
+        /// <param name="builder">The builder used to create the library. It will be reused for every regeneration.</param>
+        /// <param name="transform">Applies the generator's transformations to the freshly parsed library.</param>
+        /// <param name="generate">Emits the transformed library to the given output session, returning any generation diagnostics.</param>
+        /// <param name="createSession">Creates the output session for each regeneration. The server enables <see cref="OutputSession.SkipUnchangedFiles"/> on it.</param>
+        public GenerationServer
+        (
+            string pipeName,
+            TranslatedLibraryBuilder builder,
+            Func<TranslatedLibrary, CancellationToken, TranslatedLibrary> transform,
+            Func<TranslatedLibrary, OutputSession, CancellationToken, ImmutableArray<TranslationDiagnostic>> generate,
+            Func<OutputSession> createSession
+        )
+        {
+            PipeName = pipeName;
+            Builder = builder;
+            Transform = transform;
+            Generate = generate;
+            CreateSession = createSession;
+            DebounceTimer = new Timer(_ => BackgroundRegenerate(), null, Timeout.Infinite, Timeout.Infinite);
+        }
+
+        /// <summary>Regenerates the library if any of its inputs changed since the last regeneration.</summary>
+        /// <param name="force">If true, the library will be regenerated even if none of its inputs changed.</param>
+        /// <remarks>If the library was regenerated in the background since the last call, the result of that regeneration is returned rather than reporting that the library is up-to-date.</remarks>
+        public GenerationServerResult Regenerate(bool force = false, CancellationToken cancellationToken = default)
+            => Regenerate(force, isBackground: false, cancellationToken);
+
+        private GenerationServerResult Regenerate(bool force, bool isBackground, CancellationToken cancellationToken)
+        {
+            CheckDisposed();
+
+            lock (RegenerationLock)
+            {
+                if (!force && LastResult is not null && !InputsChanged())
+                {
+                    // Background regenerations consume the changes, so make sure their results reach whoever asks next
+                    if (LastResultIsUnreported && !isBackground)
+                    {
+                        LastResultIsUnreported = false;
+                        return LastResult;
+                    }
+
+                    return LastResult with { WasUpToDate = true, Elapsed = TimeSpan.Zero };
+                }
+
+                Stopwatch stopwatch = Stopwatch.StartNew();
+
+                // Clear this before parsing so that changes made while we're regenerating aren't lost
+                Interlocked.Exchange(ref InputsMightHaveChanged, 0);
+
+                TranslatedLibrary library = Builder.Create(cancellationToken);
+                // The hashes come from the contents Clang actually parsed, so edits made during the parse will still be seen as changes
+                HashInputs(library);
+
+                library = Transform(library, cancellationToken);
+
+                ImmutableArray<TranslationDiagnostic>.Builder diagnostics = ImmutableArray.CreateBuilder<TranslationDiagnostic>();
+                diagnostics.AddRange(library.ParsingDiagnostics);
+
+                int changedFileCount;
+                int unchangedFileCount;
+                using (OutputSession session = CreateSession())
+                {
+                    session.SkipUnchangedFiles = true;
+                    diagnostics.AddRange(Generate(library, session, cancellationToken));
+                    session.Dispose();
+                    changedFileCount = session.ChangedFileCount;
+                    unchangedFileCount = session.UnchangedFileCount;
+                }
+
+                LastResult = new GenerationServerResult(false, changedFileCount, unchangedFileCount, diagnostics.MoveToImmutableSafe(), stopwatch.Elapsed);
+                LastResultIsUnreported = isBackground;
+                return LastResult;
+            }
+        }
+
+        private bool InputsChanged()
+        {
+            // If the watchers haven't seen anything, we don't need to bother hashing anything
+            if (Interlocked.Exchange(ref InputsMightHaveChanged, 0) == 0)
+            { return false; }
+
+            // Editors frequently touch files without changing them, so we compare contents rather than trusting the watchers
+            foreach ((string filePath, string hash) in InputHashes)
+            {
+                if (HashFile(filePath) != hash)
+                { return true; }
+            }
+
+            return false;
+        }
+
+        private void HashInputs(TranslatedLibrary library)
+        {
+            Dictionary<string, string> inputHashes = new(StringComparer.OrdinalIgnoreCase);
+
+            foreach ((string filePath, string hash) in library.GetInputFileHashes())
+            { inputHashes[filePath] = hash; }
+
+            InputHashes = inputHashes;
+            UpdateWatchers();
+        }
+
+        /// <summary>Hashes the current contents of a file in the same format as <see cref="TranslatedLibrary.GetInputFileHashes"/>.</summary>
+        private static string HashFile(string filePath)
+        {
+            try
+            {
+                using FileStream stream = new(filePath, FileMode.Open, FileAccess.Read, FileShare.ReadWrite | FileShare.Delete);
+                using SHA256 sha256 = SHA256.Create();
+                return Convert.ToHexString(sha256.ComputeHash(stream));
+            }
+            catch (IOException)
+            {
+                // Missing or inaccessible files hash to nothing so that they're considered changed once they're readable again
+                return "";
+            }
+        }
+
+        private void UpdateWatchers()
+        {
+            foreach (FileSystemWatcher watcher in Watchers)
+            { watcher.Dispose(); }
+            Watchers.Clear();
+
+            foreach (string directory in InputHashes.Keys.Select(f => Path.GetDirectoryName(f)).Distinct(StringComparer.OrdinalIgnoreCase))
+            {
+                if (directory is null || !Directory.Exists(directory))
+                { continue; }
+
+                FileSystemWatcher watcher = new(directory)
+                {
+                    NotifyFilter = NotifyFilters.FileName | NotifyFilters.LastWrite | NotifyFilters.Size
+                };
+
+                watcher.Changed += OnFileChanged;
+                watcher.Created += OnFileChanged;
+                watcher.Deleted += OnFileChanged;
+                watcher.Renamed += OnFileChanged;
+                // If the watcher's buffer overflows we don't know what changed, so assume the worst
+                watcher.Error += (_, _) => OnInputsMightHaveChanged();
+                watcher.EnableRaisingEvents = true;
+                Watchers.Add(watcher);
+            }
+        }
+
+        private void OnFileChanged(object sender, FileSystemEventArgs e)
+        {
+            if (InputHashes.ContainsKey(e.FullPath) || (e is RenamedEventArgs renamed && InputHashes.ContainsKey(renamed.OldFullPath)))
+            { OnInputsMightHaveChanged(); }
+        }
+
+        private void OnInputsMightHaveChanged()
+        {
+            Interlocked.Exchange(ref InputsMightHaveChanged, 1);
+
+            if (RegenerateOnChange && !IsDisposed)
+            { DebounceTimer.Change(ChangeDebounceDelay, Timeout.InfiniteTimeSpan); }
+        }
+
+        private void BackgroundRegenerate()
+        {
+            try
+            {
+                if (!IsDisposed)
+                { Regenerate(force: false, isBackground: true, CancellationToken.None); }
+            }
+            catch (Exception ex) when (ex is not OutOfMemoryException)
+            {
+                // The error will be reported to the client when it next requests a regeneration
+                Interlocked.Exchange(ref InputsMightHaveChanged, 1);
+            }
+        }
+
+        /// <summary>Serves regeneration requests until <paramref name="cancellationToken"/> is cancelled or a client requests a shutdown.</summary>
+        public async Task RunAsync(CancellationToken cancellationToken = default)
+        {
+            CheckDisposed();
+
+            while (!cancellationToken.IsCancellationRequested)
+            {
+                using NamedPipeServerStream pipe = new(PipeName, PipeDirection.InOut, 1, PipeTransmissionMode.Byte, PipeOptions.Asynchronous);
+                await pipe.WaitForConnectionAsync(cancellationToken).ConfigureAwait(false);
+
+                using StreamReader reader = new(pipe, Encoding.UTF8, leaveOpen: true);
+                using StreamWriter writer = new(pipe, new UTF8Encoding(false), leaveOpen: true) { AutoFlush = true };
+
+                while (pipe.IsConnected)
+                {
+                    string? command = await reader.ReadLineAsync().ConfigureAwait(false);
+
+                    if (command is null)
+                    { break; }
+
+                    if (command == "shutdown")
+                    {
+                        await writer.WriteLineAsync("ok").ConfigureAwait(false);
+                        return;
+                    }
+
+                    string response = ProcessCommand(command, cancellationToken);
+                    await writer.WriteLineAsync(response).ConfigureAwait(false);
+                }
+            }
+        }
+
+        private string ProcessCommand(string command, CancellationToken cancellationToken)
+        {
+            bool force;
+            switch (command)
+            {
+                case "regenerate":
+                    force = false;
+                    break;
+                case "regenerate-force":
+                    force = true;
+                    break;
+                default:
+                    return $"error Unknown command '{command}'.";
+            }
+
+            try
+            {
+                GenerationServerResult result = Regenerate(force, cancellationToken);
+
+                if (result.WasUpToDate)
+                { return "up-to-date"; }
+
+                int errorCount = result.Diagnostics.Count(d => d.IsError);
+                int warningCount = result.Diagnostics.Count(d => d.Severity == Severity.Warning);
+                return $"ok {result.ChangedFileCount} {result.UnchangedFileCount} {errorCount} {warningCount} {(long)result.Elapsed.TotalMilliseconds}";
+            }
+            catch (Exception ex) when (ex is not OutOfMemoryException)
+            {
+                // Make sure we try again on the next request rather than reporting a stale result
+                Interlocked.Exchange(ref InputsMightHaveChanged, 1);
+                return $"error {ex.Message.Replace('\r', ' ').Replace('\n', ' ')}";
+            }
+        }
+
+        /// <summary>Sends a single command to a running generation server and returns its response.</summary>
+        public static async Task<string> SendRequestAsync(string pipeName, string command = "regenerate", int connectTimeoutMilliseconds = 5000, CancellationToken cancellationToken = default)
+        {
+            using NamedPipeClientStream pipe = new(".", pipeName, PipeDirection.InOut, PipeOptions.Asynchronous);
+            await pipe.ConnectAsync(connectTimeoutMilliseconds, cancellationToken).ConfigureAwait(false);
+
+            using StreamReader reader = new(pipe, Encoding.UTF8, leaveOpen: true);
+            using StreamWriter writer = new(pipe, new UTF8Encoding(false), leaveOpen: true) { AutoFlush = true };
+
+            await writer.WriteLineAsync(command).ConfigureAwait(false);
+            string? response = await reader.ReadLineAsync().ConfigureAwait(false);
+            return response ?? "error The server closed the connection without responding.";
+        }
+
+        private volatile bool IsDisposed = false;
+        private void CheckDisposed()
+        {
+            if (IsDisposed)
+            { throw new ObjectDisposedException(nameof(GenerationServer)); }
+        }
+
+        public void Dispose()
+        {
+            if (IsDisposed)
+            { return; }
+
+            IsDisposed = true;
+            DebounceTimer.Dispose();
+
+            lock (RegenerationLock)
+            {
+                foreach (FileSystemWatcher watcher in Watchers)
+                { watcher.Dispose(); }
+                Watchers.Clear();
+            }
+        }
+    }
+}
@@ -0,0 +1,20 @@
+﻿using System;
+using System.Collections.Immutable;
+
+namespace Biohazrd.Utilities
+{
+    /// <summary>The outcome of a <see cref="GenerationServer"/> regeneration.</summary>
+    /// <param name="WasUpToDate">True if none of the inputs changed, in which case the other values describe the previous regeneration.</param>
+    /// <param name="ChangedFileCount">The number of output files which were written because their contents changed.</param>
+    /// <param name="UnchangedFileCount">The number of output files which were left untouched.</param>
+    /// <param name="Diagnostics">The parsing and generation diagnostics from the regeneration.</param>
+    /// <param name="Elapsed">How long the regeneration took.</param>
+    public sealed record GenerationServerResult
+    (
+        bool WasUpToDate,
+        int ChangedFileCount,
+        int UnchangedFileCount,
+        ImmutableArray<TranslationDiagnostic> Diagnostics,
+        TimeSpan Elapsed
+    );
+}
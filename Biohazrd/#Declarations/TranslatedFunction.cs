@@ -18,6 +18,13 @@ namespace Biohazrd
 
         public bool IsInstanceMethod { get; }
         public bool IsVirtual { get; }
+
+        /// <summary>True if this is a virtual method which cannot be overridden, either because it or its class was marked as <c>final</c>.</summary>
+        public bool IsFinal { get; }
+
+        /// <summary>True if this virtual method's implementation is known and has been resolved, meaning it can be called directly rather than through the virtual method table.</summary>
+        /// <remarks>This is set by <c>LinkImportsTransformation</c> for <see cref="IsFinal"/> methods which are exported by the native library.</remarks>
+        public bool IsDevirtualized { get; init; }
         public bool IsConst { get; }
         public bool IsOperatorOverload { get; }
 
@@ -52,6 +59,7 @@ namespace Biohazrd
                 Accessibility = method.Access.ToTranslationAccessModifier();
                 IsInstanceMethod = !method.IsStatic;
                 IsVirtual = method.IsVirtual;
+                IsFinal = method.IsVirtual && (method.IsFinal() || method.Parent.IsFinal());
                 IsConst = method.IsConst;
             }
             // Non-method defaults
@@ -60,6 +68,7 @@ namespace Biohazrd
                 Accessibility = AccessModifier.Public; // Don't use function.Access here, it's always private on non-method functions for some reason
                 IsInstanceMethod = false;
                 IsVirtual = false;
+                IsFinal = false;
                 IsConst = false;
             }
 
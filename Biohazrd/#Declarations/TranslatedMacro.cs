@@ -15,9 +15,17 @@ namespace Biohazrd
         public ImmutableArray<string> ParameterNames { get; }
         public bool LastParameterIsVardic { get; }
 
-        internal unsafe TranslatedMacro(TranslatedFile file, PathogenMacroInformation* macroInfo)
+        /// <summary>The raw source text of this macro's replacement list (the part of the definition after the name and parameters.)</summary>
+        /// <remarks>
+        /// This will be null for macros which don't come from a source file (such as built-in macros or ones defined on the command line) or for undefined macros.
+        /// Comments are not removed, but line continuations are replaced with spaces.
+        /// </remarks>
+        public string? ReplacementText { get; }
+
+        internal unsafe TranslatedMacro(TranslatedFile file, PathogenMacroInformation* macroInfo, string? replacementText)
         {
             File = file;
+            ReplacementText = replacementText;
             Name = macroInfo->Name;
             WasUndefined = macroInfo->WasUndefined;
             IsFunctionLike = macroInfo->IsFunctionLike;
@@ -20,6 +20,9 @@ namespace Biohazrd
         public long Size { get; init; }
 
         public RecordKind Kind { get; init; }
+
+        /// <summary>True if this record was marked as <c>final</c>, meaning no other record can derive from it.</summary>
+        public bool IsFinal { get; init; }
         public bool MustBePassedByReference { get; init; }
 
         internal unsafe TranslatedRecord(TranslationUnitParser parsingContext, TranslatedFile file, RecordDecl record)
@@ -39,6 +42,8 @@ namespace Biohazrd
             else
             { Kind = RecordKind.Unknown; }
 
+            IsFinal = record.IsFinal();
+
             // Process layout and vtables
             // Normal fields are stored in this dictionary and added as they are encountered in the cursor tree
             // This primarily allows us to easily ensure our member order matches the input file's declaration order
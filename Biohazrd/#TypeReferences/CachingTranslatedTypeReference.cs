@@ -10,10 +10,23 @@ namespace Biohazrd
     /// </remarks>
     public abstract record CachingTranslatedTypeReference : TranslatedTypeReference
     {
-        //TODO: Thread safety
-        private TranslatedLibrary? CachedLibrary;
-        private TranslatedDeclaration? CachedDeclaration;
-        private VisitorContext CachedContext;
+        // The cache is stored as a single immutable object so that it can be swapped atomically.
+        // This keeps lookups thread-safe when the same type reference instance is shared between declarations or threads.
+        private sealed class CacheEntry
+        {
+            public readonly TranslatedLibrary Library;
+            public readonly TranslatedDeclaration? Declaration;
+            public readonly VisitorContext Context;
+
+            public CacheEntry(TranslatedLibrary library, TranslatedDeclaration? declaration, VisitorContext context)
+            {
+                Library = library;
+                Declaration = declaration;
+                Context = context;
+            }
+        }
+
+        private volatile CacheEntry? Cache;
 
         protected abstract TranslatedDeclaration? TryResolveImplementation(TranslatedLibrary library);
         protected abstract TranslatedDeclaration? TryResolveImplementation(TranslatedLibrary library, out VisitorContext context);
@@ -24,13 +37,13 @@ namespace Biohazrd
             { throw new ArgumentNullException(nameof(library)); }
 
             // If there's a cache hit, return the cached value
-            if (ReferenceEquals(library, CachedLibrary))
-            { return CachedDeclaration; }
+            CacheEntry? cache = Cache;
+            if (cache is not null && ReferenceEquals(library, cache.Library))
+            { return cache.Declaration; }
 
-            CachedLibrary = library;
-            CachedDeclaration = null;
-            CachedContext = default;
-            return CachedDeclaration = TryResolveImplementation(library);
+            TranslatedDeclaration? result = TryResolveImplementation(library);
+            Cache = new CacheEntry(library, result, default);
+            return result;
         }
 
         public override sealed TranslatedDeclaration? TryResolve(TranslatedLibrary library, out VisitorContext context)
@@ -39,21 +52,19 @@ namespace Biohazrd
             { throw new ArgumentNullException(nameof(library)); }
 
             // If there's a cache hit, return the cached value
-            if (ReferenceEquals(library, CachedLibrary) && !CachedContext.IsDefault)
+            CacheEntry? cache = Cache;
+            if (cache is not null && ReferenceEquals(library, cache.Library) && !cache.Context.IsDefault)
             {
-                context = CachedContext;
-                return CachedDeclaration;
+                context = cache.Context;
+                return cache.Declaration;
             }
 
-            CachedLibrary = library;
-            CachedDeclaration = null;
-            CachedContext = default;
             TranslatedDeclaration? result = TryResolveImplementation(library, out context);
-            CachedContext = context;
-            return CachedDeclaration = result;
+            Cache = new CacheEntry(library, result, context);
+            return result;
         }
 
-        protected string ToStringSuffix => CachedDeclaration is not null ? $" ({CachedDeclaration.Name})" : String.Empty;
+        protected string ToStringSuffix => Cache?.Declaration is TranslatedDeclaration cachedDeclaration ? $" ({cachedDeclaration.Name})" : String.Empty;
 
         public override string ToString()
             => $"`Cached translated type reference{ToStringSuffix}`";
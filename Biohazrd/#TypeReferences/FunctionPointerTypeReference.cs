@@ -1,5 +1,6 @@
 ﻿using ClangSharp;
 using ClangSharp.Interop;
+using System;
 using System.Collections.Immutable;
 using System.ComponentModel;
 using System.Text;
@@ -78,5 +79,51 @@ namespace Biohazrd
 
             return builder.ToString();
         }
+
+        // ImmutableArray<T> compares by reference to the underlying array, so we manually implement Equals and GetHashCode to compare the parameter types structurally.
+        public virtual bool Equals(FunctionPointerTypeReference? other)
+        {
+            if (ReferenceEquals(this, other))
+            { return true; }
+
+            if (other is null || !base.Equals(other))
+            { return false; }
+
+            if (this.CallingConvention != other.CallingConvention
+                || this.IsNotActuallyAPointer != other.IsNotActuallyAPointer
+                || this.ReturnType != other.ReturnType)
+            { return false; }
+
+            if (this.ParameterTypes.IsDefault || other.ParameterTypes.IsDefault)
+            { return this.ParameterTypes.IsDefault == other.ParameterTypes.IsDefault; }
+
+            if (this.ParameterTypes.Length != other.ParameterTypes.Length)
+            { return false; }
+
+            for (int i = 0; i < ParameterTypes.Length; i++)
+            {
+                if (this.ParameterTypes[i] != other.ParameterTypes[i])
+                { return false; }
+            }
+
+            return true;
+        }
+
+        public override int GetHashCode()
+        {
+            HashCode hashCode = new();
+            hashCode.Add(base.GetHashCode());
+            hashCode.Add(CallingConvention);
+            hashCode.Add(IsNotActuallyAPointer);
+            hashCode.Add(ReturnType);
+
+            if (!ParameterTypes.IsDefault)
+            {
+                foreach (TypeReference parameterType in ParameterTypes)
+                { hashCode.Add(parameterType); }
+            }
+
+            return hashCode.ToHashCode();
+        }
     }
 }
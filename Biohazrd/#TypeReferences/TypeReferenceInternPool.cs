@@ -0,0 +1,37 @@
+﻿using System;
+using System.Collections.Concurrent;
+using System.Diagnostics;
+
+namespace Biohazrd
+{
+    /// <summary>A thread-safe pool used to share a single instance between structurally equal <see cref="TypeReference"/>s.</summary>
+    /// <remarks>
+    /// Type references implement value equality, so it is always safe to substitute a type reference with an equal one from the pool.
+    /// Interning is purely an optimization to reduce allocations and to make equality checks between common types cheaper.
+    /// </remarks>
+    public sealed class TypeReferenceInternPool
+    {
+        private readonly ConcurrentDictionary<TypeReference, TypeReference> Pool = new();
+
+        /// <summary>The number of unique type references in this pool.</summary>
+        public int Count => Pool.Count;
+
+        /// <summary>Gets the pooled instance which is equal to <paramref name="type"/>, adding it to the pool if there isn't one yet.</summary>
+        public T Intern<T>(T type)
+            where T : TypeReference
+        {
+            if (type is null)
+            { throw new ArgumentNullException(nameof(type)); }
+
+            TypeReference result = Pool.GetOrAdd(type, type);
+
+            // Record equality checks the equality contract, so the pooled instance will always be of the same type
+            Debug.Assert(result is T, "Pooled type references must be the same type as the type they're equal to.");
+            return (T)result;
+        }
+
+        /// <summary>Removes all type references from this pool.</summary>
+        public void Clear()
+            => Pool.Clear();
+    }
+}
@@ -49,6 +49,18 @@ namespace Biohazrd
 #endif
         }
 
+        /// <summary>Determines if the given declaration was marked with the C++ <c>final</c> specifier.</summary>
+        internal static bool IsFinal(this Decl declaration)
+        {
+            foreach (Attr attribute in declaration.Attrs)
+            {
+                if (attribute.Kind == CX_AttrKind.CX_AttrKind_Final)
+                { return true; }
+            }
+
+            return false;
+        }
+
         public static AccessModifier ToTranslationAccessModifier(this CX_CXXAccessSpecifier accessSpecifier)
             => accessSpecifier switch
             {
@@ -0,0 +1,439 @@
+﻿using Biohazrd.Expressions;
+using ClangSharp.Interop;
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Collections.Immutable;
+using System.IO;
+using System.Linq;
+using System.Runtime.InteropServices;
+using System.Security.Cryptography;
+using System.Text;
+using System.Threading;
+
+namespace Biohazrd
+{
+    /// <summary>A persistent on-disk cache of constant evaluation results.</summary>
+    /// <remarks>
+    /// Results are keyed by the expression text. The cache as a whole is keyed by a hash of the command line arguments, the Biohazrd index file,
+    /// and the paths and in-memory contents of the files added to the <see cref="TranslatedLibraryBuilder"/>.
+    ///
+    /// The cache also records the content hash of every file which was actually read by Clang while evaluating (including headers which are only reached via
+    /// <c>#include</c>, such as system or SDK headers.) Whenever an evaluator parses or reparses its translation unit, it reports the files it read to the cache.
+    /// If they don't match the recorded inputs, the results from the previous run are discarded. If different parses within the same run observe different inputs
+    /// (IE: a header was modified while evaluating) the cache stops recording and saving results entirely for the remainder of the run.
+    ///
+    /// This type is thread-safe.
+    /// </remarks>
+    public sealed class ConstantEvaluationCache
+    {
+        private const string FileMagic = "BiohazrdConstantEvaluationCache";
+        private const int FileVersion = 2;
+
+        /// <summary>The path of the file backing this cache.</summary>
+        public string FilePath { get; }
+
+        private readonly string Key;
+        private readonly ConcurrentDictionary<string, ConstantEvaluationResult> Entries;
+        private readonly object SaveLock = new();
+        private volatile bool IsDirty = false;
+
+        /// <summary>The content hashes of the files read by Clang, keyed by their full path.</summary>
+        /// <remarks>Initially these are the inputs recorded by a previous run, they are replaced by the inputs observed by this run's first parse.</remarks>
+        private ImmutableSortedDictionary<string, string> Inputs;
+        private readonly object InputsLock = new();
+        private volatile bool InputsWereObserved = false;
+        private volatile bool IsConsistent = true;
+
+        /// <summary>The number of results in this cache.</summary>
+        public int Count => Entries.Count;
+
+        internal ConstantEvaluationCache(string filePath, string key)
+        {
+            FilePath = filePath;
+            Key = key;
+            Entries = Load(filePath, key, out Inputs);
+        }
+
+        internal bool TryGet(string expression, out ConstantEvaluationResult result)
+        {
+            // Results can't be trusted until we know they were evaluated from the same inputs Clang is seeing now
+            if (!InputsWereObserved || !IsConsistent)
+            {
+                result = default;
+                return false;
+            }
+
+            return Entries.TryGetValue(expression, out result);
+        }
+
+        internal void Add(ConstantEvaluationResult result)
+        {
+            if (!IsConsistent)
+            { return; }
+
+            // Results with constants we don't know how to persist are simply not cached
+            if (result.Value is not null && !CanWrite(result.Value))
+            { return; }
+
+            Entries[result.Expression] = result;
+            IsDirty = true;
+        }
+
+        /// <summary>Records the inputs read by Clang for a parse of an evaluation translation unit.</summary>
+        internal void ObserveInputs(ImmutableSortedDictionary<string, string> inputs)
+        {
+            lock (InputsLock)
+            {
+                bool inputsMatch = inputs.Count == Inputs.Count && inputs.All(pair => Inputs.TryGetValue(pair.Key, out string? hash) && hash == pair.Value);
+
+                if (inputsMatch)
+                { InputsWereObserved = true; }
+                else if (!InputsWereObserved)
+                {
+                    // The inputs changed since the results were cached, so none of them can be used
+                    Entries.Clear();
+                    Inputs = inputs;
+                    InputsWereObserved = true;
+                    IsDirty = true;
+                }
+                else
+                {
+                    // The inputs changed while we were evaluating, we can't know which inputs any new results were evaluated with so we stop caching altogether
+                    // The cache file is left as-is since its recorded inputs no longer match, it'll be discarded by the next run unless the inputs are changed back.
+                    IsConsistent = false;
+                    Entries.Clear();
+                }
+            }
+        }
+
+        /// <summary>Collects the paths and content hashes of every file read by Clang for the specified translation unit.</summary>
+        /// <param name="excludedFiles">The names of files to skip, such as in-memory files which are already covered by the cache key.</param>
+        /// <remarks>The main file of the translation unit is always skipped since it's an in-memory file generated by Biohazrd.</remarks>
+        internal static unsafe ImmutableSortedDictionary<string, string> CollectInputs(CXTranslationUnit unit, IReadOnlySet<string> excludedFiles)
+        {
+            List<IntPtr> includedFiles = new();
+            GCHandle includedFilesHandle = GCHandle.Alloc(includedFiles);
+            try
+            {
+                delegate* unmanaged[Cdecl]<CXFile, CXSourceLocation*, uint, void*, void> visitorPtr = &InclusionVisitor;
+                clang.getInclusions(unit, (IntPtr)visitorPtr, (void*)GCHandle.ToIntPtr(includedFilesHandle));
+            }
+            finally
+            { includedFilesHandle.Free(); }
+
+            ImmutableSortedDictionary<string, string>.Builder inputs = ImmutableSortedDictionary.CreateBuilder<string, string>(StringComparer.Ordinal);
+            foreach (IntPtr fileHandle in includedFiles)
+            {
+                CXFile file = new(fileHandle);
+                string fileName = file.Name.ToString();
+
+                if (String.IsNullOrEmpty(fileName) || excludedFiles.Contains(fileName))
+                { continue; }
+
+                string realPath = file.TryGetRealPathName().ToString();
+                string fullPath = Path.GetFullPath(String.IsNullOrEmpty(realPath) ? fileName : realPath);
+
+                // Hash the exact contents Clang read when possible
+                // (Files which were only validated via a precompiled header might not have been loaded, in which case we read them ourselves.)
+                nuint fileSize;
+                sbyte* fileContents = clang.getFileContents(unit, file, &fileSize);
+
+                byte[] hash;
+                if (fileContents is not null)
+                { hash = SHA256.HashData(new ReadOnlySpan<byte>(fileContents, checked((int)fileSize))); }
+                else if (File.Exists(fullPath))
+                { hash = SHA256.HashData(File.ReadAllBytes(fullPath)); }
+                else
+                { hash = Array.Empty<byte>(); }
+
+                inputs[fullPath] = Convert.ToHexString(hash);
+            }
+
+            return inputs.ToImmutable();
+        }
+
+        [UnmanagedCallersOnly(CallConvs = new[] { typeof(System.Runtime.CompilerServices.CallConvCdecl) })]
+        private static unsafe void InclusionVisitor(CXFile includedFile, CXSourceLocation* inclusionStack, uint includeLength, void* clientData)
+        {
+            // The main file is the only one with an empty inclusion stack
+            if (includeLength == 0)
+            { return; }
+
+            List<IntPtr> includedFiles = (List<IntPtr>)GCHandle.FromIntPtr((IntPtr)clientData).Target!;
+            includedFiles.Add(includedFile.Handle);
+        }
+
+        internal delegate ImmutableArray<ConstantEvaluationResult> EvaluateBatchFunc
+        (
+            IReadOnlyList<string> expressions,
+            out ImmutableArray<TranslationDiagnostic> batchDiagnostics,
+            CancellationToken cancellationToken,
+            IProgress<TranslationProgress>? progress
+        );
+
+        /// <summary>Evaluates the specified expressions, only passing those which are not already in the cache to <paramref name="evaluate"/>.</summary>
+        /// <remarks>Batch diagnostics are not cached, so <paramref name="batchDiagnostics"/> only contains those from expressions which were actually evaluated.</remarks>
+        internal ImmutableArray<ConstantEvaluationResult> EvaluateBatch
+        (
+            IReadOnlyList<string> expressions,
+            out ImmutableArray<TranslationDiagnostic> batchDiagnostics,
+            EvaluateBatchFunc evaluate,
+            CancellationToken cancellationToken,
+            IProgress<TranslationProgress>? progress
+        )
+        {
+            ConstantEvaluationResult[] results = new ConstantEvaluationResult[expressions.Count];
+            List<string> misses = new();
+            List<int> missIndices = new();
+
+            for (int i = 0; i < expressions.Count; i++)
+            {
+                if (!TryGet(expressions[i], out results[i]))
+                {
+                    misses.Add(expressions[i]);
+                    missIndices.Add(i);
+                }
+            }
+
+            batchDiagnostics = ImmutableArray<TranslationDiagnostic>.Empty;
+            int hitCount = expressions.Count - misses.Count;
+            progress?.Report(new TranslationProgress(hitCount, expressions.Count));
+
+            if (misses.Count > 0)
+            {
+                OffsetProgress? missProgress = progress is null ? null : new OffsetProgress(progress, hitCount, expressions.Count);
+                ImmutableArray<ConstantEvaluationResult> missResults = evaluate(misses, out batchDiagnostics, cancellationToken, missProgress);
+
+                for (int i = 0; i < missResults.Length; i++)
+                {
+                    results[missIndices[i]] = missResults[i];
+                    Add(missResults[i]);
+                }
+
+                Save();
+            }
+
+            return ImmutableArray.Create(results);
+        }
+
+        private sealed class OffsetProgress : IProgress<TranslationProgress>
+        {
+            private readonly IProgress<TranslationProgress> Progress;
+            private readonly int Offset;
+            private readonly int Total;
+
+            public OffsetProgress(IProgress<TranslationProgress> progress, int offset, int total)
+            {
+                Progress = progress;
+                Offset = offset;
+                Total = total;
+            }
+
+            public void Report(TranslationProgress value)
+                => Progress.Report(new TranslationProgress(Offset + value.Completed, Total));
+        }
+
+        /// <summary>Writes any new results to disk.</summary>
+        /// <remarks>This is called automatically after each batch which evaluated at least one expression.</remarks>
+        public void Save()
+        {
+            lock (SaveLock)
+            {
+                if (!IsDirty || !IsConsistent)
+                { return; }
+
+                IsDirty = false;
+
+                // Write to a temporary file first so a crash mid-write can't corrupt the cache
+                string temporaryFilePath = $"{FilePath}.{Environment.ProcessId}.tmp";
+                using (FileStream stream = new(temporaryFilePath, FileMode.Create, FileAccess.Write))
+                using (BinaryWriter writer = new(stream, Encoding.UTF8))
+                {
+                    writer.Write(FileMagic);
+                    writer.Write(FileVersion);
+                    writer.Write(Key);
+
+                    ImmutableSortedDictionary<string, string> inputs;
+                    lock (InputsLock)
+                    { inputs = Inputs; }
+
+                    writer.Write(inputs.Count);
+                    foreach ((string inputPath, string inputHash) in inputs)
+                    {
+                        writer.Write(inputPath);
+                        writer.Write(inputHash);
+                    }
+
+                    KeyValuePair<string, ConstantEvaluationResult>[] entries = Entries.ToArray();
+                    writer.Write(entries.Length);
+                    foreach ((string expression, ConstantEvaluationResult result) in entries)
+                    {
+                        writer.Write(expression);
+                        WriteValue(writer, result.Value);
+
+                        ImmutableArray<TranslationDiagnostic> diagnostics = result.Diagnostics.IsDefault ? ImmutableArray<TranslationDiagnostic>.Empty : result.Diagnostics;
+                        writer.Write(diagnostics.Length);
+                        foreach (TranslationDiagnostic diagnostic in diagnostics)
+                        { WriteDiagnostic(writer, diagnostic); }
+                    }
+                }
+
+                File.Move(temporaryFilePath, FilePath, overwrite: true);
+            }
+        }
+
+        private static ConcurrentDictionary<string, ConstantEvaluationResult> Load(string filePath, string key, out ImmutableSortedDictionary<string, string> inputs)
+        {
+            ConcurrentDictionary<string, ConstantEvaluationResult> entries = new();
+            inputs = ImmutableSortedDictionary.Create<string, string>(StringComparer.Ordinal);
+
+            if (!File.Exists(filePath))
+            { return entries; }
+
+            try
+            {
+                using FileStream stream = new(filePath, FileMode.Open, FileAccess.Read, FileShare.Read);
+                using BinaryReader reader = new(stream, Encoding.UTF8);
+
+                // If the cache is from a different version of Biohazrd or a different library configuration, we start over
+                if (reader.ReadString() != FileMagic || reader.ReadInt32() != FileVersion || reader.ReadString() != key)
+                { return entries; }
+
+                int inputCount = reader.ReadInt32();
+                ImmutableSortedDictionary<string, string>.Builder inputsBuilder = ImmutableSortedDictionary.CreateBuilder<string, string>(StringComparer.Ordinal);
+                for (int i = 0; i < inputCount; i++)
+                { inputsBuilder[reader.ReadString()] = reader.ReadString(); }
+
+                inputs = inputsBuilder.ToImmutable();
+
+                int count = reader.ReadInt32();
+                for (int i = 0; i < count; i++)
+                {
+                    string expression = reader.ReadString();
+                    ConstantValue? value = ReadValue(reader);
+
+                    int diagnosticCount = reader.ReadInt32();
+                    ImmutableArray<TranslationDiagnostic>.Builder diagnostics = ImmutableArray.CreateBuilder<TranslationDiagnostic>(diagnosticCount);
+                    for (int j = 0; j < diagnosticCount; j++)
+                    { diagnostics.Add(ReadDiagnostic(reader, expression)); }
+
+                    entries[expression] = new ConstantEvaluationResult(expression, value, diagnostics.MoveToImmutable());
+                }
+            }
+            catch (Exception ex) when (ex is IOException || ex is InvalidDataException)
+            {
+                // A corrupt cache is treated as an empty one, it'll be overwritten the next time it's saved
+                entries.Clear();
+                inputs = inputs.Clear();
+            }
+
+            return entries;
+        }
+
+        private enum ValueKind : byte
+        {
+            None,
+            Integer,
+            Float,
+            Double,
+            String,
+            NullPointer,
+            Unsupported
+        }
+
+        private static bool CanWrite(ConstantValue value)
+            => value is IntegerConstant or FloatConstant or DoubleConstant or StringConstant or NullPointerConstant or UnsupportedConstantExpression;
+
+        private static void WriteValue(BinaryWriter writer, ConstantValue? value)
+        {
+            switch (value)
+            {
+                case null:
+                    writer.Write((byte)ValueKind.None);
+                    break;
+                case IntegerConstant integer:
+                    writer.Write((byte)ValueKind.Integer);
+                    writer.Write(integer.SizeBits);
+                    writer.Write(integer.IsSigned);
+                    writer.Write(integer.Value);
+                    break;
+                case FloatConstant floatConstant:
+                    writer.Write((byte)ValueKind.Float);
+                    writer.Write(floatConstant.Value);
+                    break;
+                case DoubleConstant doubleConstant:
+                    writer.Write((byte)ValueKind.Double);
+                    writer.Write(doubleConstant.Value);
+                    break;
+                case StringConstant stringConstant:
+                    writer.Write((byte)ValueKind.String);
+                    writer.Write(stringConstant.Value);
+                    break;
+                case NullPointerConstant:
+                    writer.Write((byte)ValueKind.NullPointer);
+                    break;
+                case UnsupportedConstantExpression unsupported:
+                    writer.Write((byte)ValueKind.Unsupported);
+                    writer.Write(unsupported.Message);
+                    break;
+                default:
+                    throw new InvalidOperationException($"Constants of type {value.GetType().Name} cannot be cached.");
+            }
+        }
+
+        private static ConstantValue? ReadValue(BinaryReader reader)
+            => (ValueKind)reader.ReadByte() switch
+            {
+                ValueKind.None => null,
+                ValueKind.Integer => new IntegerConstant()
+                {
+                    SizeBits = reader.ReadInt32(),
+                    IsSigned = reader.ReadBoolean(),
+                    Value = reader.ReadUInt64()
+                },
+                ValueKind.Float => new FloatConstant(reader.ReadSingle()),
+                ValueKind.Double => new DoubleConstant(reader.ReadDouble()),
+                ValueKind.String => new StringConstant(reader.ReadString()),
+                ValueKind.NullPointer => NullPointerConstant.Instance,
+                ValueKind.Unsupported => new UnsupportedConstantExpression(reader.ReadString()),
+                ValueKind kind => throw new InvalidDataException($"Unknown constant kind {kind} in constant evaluation cache.")
+            };
+
+        private static void WriteDiagnostic(BinaryWriter writer, TranslationDiagnostic diagnostic)
+        {
+            writer.Write((byte)diagnostic.Severity);
+            writer.Write(diagnostic.IsFromClang);
+            writer.Write(diagnostic.Message);
+
+            bool hasSourceFile = diagnostic.Location.SourceFile is not null;
+            writer.Write(hasSourceFile);
+            if (hasSourceFile)
+            { writer.Write(diagnostic.Location.SourceFile!); }
+
+            writer.Write(diagnostic.Location.Line);
+            writer.Write(diagnostic.Location.Column);
+        }
+
+        private static TranslationDiagnostic ReadDiagnostic(BinaryReader reader, string expression)
+        {
+            Severity severity = (Severity)reader.ReadByte();
+            bool isFromClang = reader.ReadBoolean();
+            string message = reader.ReadString();
+            string? sourceFile = reader.ReadBoolean() ? reader.ReadString() : null;
+            int line = reader.ReadInt32();
+            int column = reader.ReadInt32();
+
+            // Locations without a file are mapped the same way as they are when evaluating live
+            SourceLocation location;
+            if (sourceFile is not null)
+            { location = new SourceLocation(sourceFile, line, column); }
+            else if (line == 0 && column == 0)
+            { location = SourceLocation.Null; }
+            else
+            { location = new SourceLocation(TranslatedLibraryConstantEvaluator.GetEvaluationSourceFileName(expression), line, column); }
+
+            return new TranslationDiagnostic(location, severity, isFromClang, message);
+        }
+    }
+}
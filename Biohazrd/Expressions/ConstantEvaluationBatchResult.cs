@@ -0,0 +1,42 @@
+﻿using System.Collections;
+using System.Collections.Generic;
+using System.Collections.Immutable;
+
+namespace Biohazrd.Expressions
+{
+    /// <summary>The results of evaluating a batch of expressions along with the diagnostics which belong to the batch as a whole.</summary>
+    /// <remarks>
+    /// This type implicitly converts to an array of its <see cref="Results"/> for compatibility with code which doesn't care about <see cref="BatchDiagnostics"/>.
+    /// </remarks>
+    public sealed class ConstantEvaluationBatchResult : IReadOnlyList<ConstantEvaluationResult>
+    {
+        /// <summary>The results of the evaluations, in the same order as the expressions which were evaluated.</summary>
+        public ImmutableArray<ConstantEvaluationResult> Results { get; }
+
+        /// <summary>Diagnostics which aren't associated with any particular evaluation, such as errors from the library's headers.</summary>
+        /// <remarks>Each unique diagnostic is reported once for the entire batch rather than once for every evaluation.</remarks>
+        public ImmutableArray<TranslationDiagnostic> BatchDiagnostics { get; }
+
+        internal ConstantEvaluationBatchResult(ImmutableArray<ConstantEvaluationResult> results, ImmutableArray<TranslationDiagnostic> batchDiagnostics)
+        {
+            Results = results;
+            BatchDiagnostics = batchDiagnostics;
+        }
+
+        public ConstantEvaluationResult this[int index] => Results[index];
+        public int Length => Results.Length;
+        int IReadOnlyCollection<ConstantEvaluationResult>.Count => Results.Length;
+
+        public ImmutableArray<ConstantEvaluationResult>.Enumerator GetEnumerator()
+            => Results.GetEnumerator();
+
+        IEnumerator<ConstantEvaluationResult> IEnumerable<ConstantEvaluationResult>.GetEnumerator()
+            => ((IEnumerable<ConstantEvaluationResult>)Results).GetEnumerator();
+
+        IEnumerator IEnumerable.GetEnumerator()
+            => ((IEnumerable)Results).GetEnumerator();
+
+        public static implicit operator ImmutableArray<ConstantEvaluationResult>(ConstantEvaluationBatchResult batchResult)
+            => batchResult.Results;
+    }
+}
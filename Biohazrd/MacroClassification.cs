@@ -0,0 +1,15 @@
+﻿namespace Biohazrd
+{
+    /// <summary>Describes how likely a macro is to represent a constant, as determined by <see cref="MacroClassifier"/>.</summary>
+    public enum MacroClassification
+    {
+        /// <summary>The macro has no replacement tokens. (Include guards and feature flags typically fall into this category.)</summary>
+        Empty,
+        /// <summary>The macro is a single integer, floating point, or string literal whose value can be determined without Clang.</summary>
+        TriviallyLiteral,
+        /// <summary>The macro might represent a constant, but Clang must be used to evaluate it.</summary>
+        LikelyConstant,
+        /// <summary>The macro cannot represent a constant. (Attribute and calling convention macros, statement-like macros, macros which require arguments, etc.)</summary>
+        NotConstant
+    }
+}
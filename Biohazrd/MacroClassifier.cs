@@ -0,0 +1,493 @@
+﻿using Biohazrd.Expressions;
+using System;
+using System.Collections.Generic;
+using System.Collections.Immutable;
+using System.Diagnostics;
+using System.Globalization;
+
+namespace Biohazrd
+{
+    /// <summary>Cheaply classifies macros based on their replacement tokens so that only macros which might be constants are evaluated by Clang.</summary>
+    /// <remarks>
+    /// Most macros in a typical library are include guards, empty defines, attribute or calling convention macros, or function-like helpers which can never be constants.
+    /// Evaluating them with <see cref="TranslatedLibraryConstantEvaluator"/> wastes time and produces noisy diagnostics.
+    ///
+    /// Classification is conservative: a macro is only classified as <see cref="MacroClassification.NotConstant"/> when it definitely can't be a constant,
+    /// and only classified as <see cref="MacroClassification.TriviallyLiteral"/> when its value is the same on every target Biohazrd supports.
+    /// </remarks>
+    public static class MacroClassifier
+    {
+        public static MacroClassification Classify(TranslatedMacro macro)
+            => Classify(macro, out _);
+
+        /// <summary>Classifies the specified macro.</summary>
+        /// <param name="literalValue">If the macro is <see cref="MacroClassification.TriviallyLiteral"/>, receives its value.</param>
+        public static MacroClassification Classify(TranslatedMacro macro, out ConstantValue? literalValue)
+        {
+            literalValue = null;
+
+            // Undefined macros and macros which need arguments can't be evaluated on their own
+            if (macro.WasUndefined || (macro.IsFunctionLike && macro.ParameterNames.Length > 0))
+            { return MacroClassification.NotConstant; }
+
+            // If we don't know the replacement tokens (IE: for built-in macros) we have to assume the macro might be a constant
+            if (macro.ReplacementText is null)
+            { return MacroClassification.LikelyConstant; }
+
+            List<string>? tokenList = Tokenize(macro.ReplacementText);
+
+            if (tokenList is null)
+            { return MacroClassification.LikelyConstant; }
+
+            if (tokenList.Count == 0)
+            { return MacroClassification.Empty; }
+
+            bool allTokensAreTypeKeywords = true;
+            int depth = 0;
+            Stack<int> typeOperandDepths = new();
+            for (int i = 0; i < tokenList.Count; i++)
+            {
+                string token = tokenList[i];
+
+                if (token == "(")
+                { depth++; }
+                else if (token == ")")
+                {
+                    if (typeOperandDepths.Count > 0 && typeOperandDepths.Peek() == depth)
+                    { typeOperandDepths.Pop(); }
+
+                    depth--;
+                }
+                // The operand of sizeof and friends starts at the parenthesis which follows them
+                else if (TypeOperandOperators.Contains(token) && i + 1 < tokenList.Count && tokenList[i + 1] == "(")
+                { typeOperandDepths.Push(depth + 1); }
+
+                if (NotConstantTokens.Contains(token))
+                { return MacroClassification.NotConstant; }
+
+                // Elaborated type specifiers are fine in things like `sizeof(struct hdr)` or `offsetof(struct s, f)`, but not elsewhere
+                if (typeOperandDepths.Count == 0 && TypeOperandOnlyTokens.Contains(token))
+                { return MacroClassification.NotConstant; }
+
+                if (!TypeKeywords.Contains(token))
+                { allTokensAreTypeKeywords = false; }
+            }
+
+            // Macros like `#define BOOL int` are type aliases
+            if (allTokensAreTypeKeywords)
+            { return MacroClassification.NotConstant; }
+
+            ReadOnlySpan<string> tokens = tokenList.ToArray();
+
+            // Remove redundant parenthesis
+            while (tokens.Length >= 3 && tokens[0] == "(" && tokens[tokens.Length - 1] == ")" && IsSingleParenthesizedGroup(tokens))
+            { tokens = tokens.Slice(1, tokens.Length - 2); }
+
+            bool negate = false;
+            if (tokens.Length == 2 && tokens[0] == "-")
+            {
+                negate = true;
+                tokens = tokens.Slice(1);
+            }
+
+            if (tokens.Length == 1 && TryParseLiteral(tokens[0], negate, out literalValue))
+            { return MacroClassification.TriviallyLiteral; }
+
+            return MacroClassification.LikelyConstant;
+        }
+
+        /// <summary>Evaluates all of the macros which might be constants, evaluating trivial literals directly and sending the remainder to Clang as a single batch.</summary>
+        /// <returns>The results for every macro which was classified as <see cref="MacroClassification.TriviallyLiteral"/> or <see cref="MacroClassification.LikelyConstant"/>, in input order.</returns>
+        public static ImmutableArray<(TranslatedMacro Macro, ConstantEvaluationResult Result)> EvaluateConstants(TranslatedLibraryConstantEvaluator evaluator, IEnumerable<TranslatedMacro> macros)
+            => EvaluateConstants(macros, expressions => evaluator.EvaluateBatch(expressions));
+
+        /// <inheritdoc cref="EvaluateConstants(TranslatedLibraryConstantEvaluator, IEnumerable{TranslatedMacro})"/>
+        public static ImmutableArray<(TranslatedMacro Macro, ConstantEvaluationResult Result)> EvaluateConstants(TranslatedLibraryConstantEvaluatorPool evaluatorPool, IEnumerable<TranslatedMacro> macros)
+            => EvaluateConstants(macros, expressions => evaluatorPool.EvaluateBatch(expressions));
+
+        private static ImmutableArray<(TranslatedMacro Macro, ConstantEvaluationResult Result)> EvaluateConstants
+        (
+            IEnumerable<TranslatedMacro> macros,
+            Func<IReadOnlyList<string>, ImmutableArray<ConstantEvaluationResult>> evaluateBatch
+        )
+        {
+            List<(TranslatedMacro Macro, ConstantEvaluationResult? Result)> results = new();
+            List<TranslatedMacro> ambiguousMacros = new();
+            List<int> ambiguousIndices = new();
+
+            foreach (TranslatedMacro macro in macros)
+            {
+                switch (Classify(macro, out ConstantValue? literalValue))
+                {
+                    case MacroClassification.TriviallyLiteral:
+                        Debug.Assert(literalValue is not null);
+                        string expression = macro.IsFunctionLike ? $"{macro.Name}()" : macro.Name;
+                        results.Add((macro, new ConstantEvaluationResult(expression, literalValue, ImmutableArray<TranslationDiagnostic>.Empty)));
+                        break;
+                    case MacroClassification.LikelyConstant:
+                        ambiguousIndices.Add(results.Count);
+                        ambiguousMacros.Add(macro);
+                        results.Add((macro, null));
+                        break;
+                }
+            }
+
+            if (ambiguousMacros.Count > 0)
+            {
+                ImmutableArray<ConstantEvaluationResult> ambiguousResults = evaluateBatch(TranslatedLibraryConstantEvaluator.GetMacroExpressions(ambiguousMacros));
+                Debug.Assert(ambiguousResults.Length == ambiguousMacros.Count);
+
+                for (int i = 0; i < ambiguousResults.Length; i++)
+                { results[ambiguousIndices[i]] = (ambiguousMacros[i], ambiguousResults[i]); }
+            }
+
+            ImmutableArray<(TranslatedMacro Macro, ConstantEvaluationResult Result)>.Builder resultsBuilder = ImmutableArray.CreateBuilder<(TranslatedMacro, ConstantEvaluationResult)>(results.Count);
+            foreach ((TranslatedMacro macro, ConstantEvaluationResult? result) in results)
+            { resultsBuilder.Add((macro, result!.Value)); }
+
+            return resultsBuilder.MoveToImmutable();
+        }
+
+        /// <summary>Tokens which can never appear in a constant expression.</summary>
+        private static readonly HashSet<string> NotConstantTokens = new()
+        {
+            // Punctuation which only appears in statements and declarations
+            "{", "}", ";", "#", "##",
+            // Attributes and calling conventions
+            "__declspec", "__attribute__", "__stdcall", "__cdecl", "__fastcall", "__thiscall", "__vectorcall", "__clrcall", "__forceinline", "__inline", "inline",
+            "__unaligned", "__ptr32", "__ptr64", "__restrict", "__pragma", "_Pragma", "__asm", "asm", "alignas", "_Alignas",
+            // Statements
+            "do", "while", "for", "if", "else", "switch", "case", "default", "return", "goto", "break", "continue", "try", "catch", "throw",
+            // Declarations
+            "static", "extern", "typedef", "namespace", "template", "typename", "using", "virtual", "explicit", "friend",
+            "public", "private", "protected", "operator", "new", "delete", "register", "thread_local", "mutable"
+        };
+
+        /// <summary>Tokens which can only appear in a constant expression within the operand of one of the <see cref="TypeOperandOperators"/>.</summary>
+        private static readonly HashSet<string> TypeOperandOnlyTokens = new()
+        {
+            "struct", "class", "union", "enum", "volatile"
+        };
+
+        /// <summary>Operators which accept a type name as their operand.</summary>
+        private static readonly HashSet<string> TypeOperandOperators = new()
+        {
+            "sizeof", "alignof", "_Alignof", "__alignof", "__alignof__", "offsetof", "__builtin_offsetof"
+        };
+
+        private static readonly HashSet<string> TypeKeywords = new()
+        {
+            "void", "bool", "char", "wchar_t", "char8_t", "char16_t", "char32_t", "short", "int", "long", "float", "double", "signed", "unsigned", "const", "*", "&",
+            "__int8", "__int16", "__int32", "__int64"
+        };
+
+        private static bool IsSingleParenthesizedGroup(ReadOnlySpan<string> tokens)
+        {
+            int depth = 0;
+            for (int i = 0; i < tokens.Length; i++)
+            {
+                if (tokens[i] == "(")
+                { depth++; }
+                else if (tokens[i] == ")")
+                { depth--; }
+
+                // If we close the outer parenthesis before the end, this is something like `(a) + (b)`
+                if (depth == 0 && i != tokens.Length - 1)
+                { return false; }
+            }
+
+            return depth == 0;
+        }
+
+        private static bool TryParseLiteral(string token, bool negate, out ConstantValue? value)
+        {
+            value = null;
+
+            if (token.Length == 0)
+            { return false; }
+
+            // Only unprefixed string literals without escape sequences are handled
+            if (token[0] == '"')
+            {
+                if (negate || token.Length < 2 || token[token.Length - 1] != '"')
+                { return false; }
+
+                string contents = token.Substring(1, token.Length - 2);
+                foreach (char c in contents)
+                {
+                    if (c == '\\' || c == '"' || c < ' ' || c > '~')
+                    { return false; }
+                }
+
+                value = new StringConstant(contents);
+                return true;
+            }
+
+            if (!Char.IsDigit(token[0]) && token[0] != '.')
+            { return false; }
+
+            token = token.Replace("'", "");
+
+            if (TryParseIntegerLiteral(token, negate, out IntegerConstant? integer))
+            {
+                value = integer;
+                return true;
+            }
+
+            return TryParseFloatingPointLiteral(token, negate, out value);
+        }
+
+        private static bool TryParseIntegerLiteral(string token, bool negate, out IntegerConstant? value)
+        {
+            value = null;
+
+            // Separate the suffix
+            int suffixStart = token.Length;
+            while (suffixStart > 0 && (token[suffixStart - 1] is 'u' or 'U' or 'l' or 'L'))
+            { suffixStart--; }
+
+            ReadOnlySpan<char> digits = token.AsSpan(0, suffixStart);
+            string suffix = token.Substring(suffixStart).ToLowerInvariant();
+
+            int radix = 10;
+            if (digits.StartsWith("0x", StringComparison.OrdinalIgnoreCase))
+            {
+                radix = 16;
+                digits = digits.Slice(2);
+            }
+            else if (digits.StartsWith("0b", StringComparison.OrdinalIgnoreCase))
+            {
+                radix = 2;
+                digits = digits.Slice(2);
+            }
+            else if (digits.Length > 1 && digits[0] == '0')
+            {
+                radix = 8;
+                digits = digits.Slice(1);
+            }
+
+            if (digits.Length == 0)
+            { return false; }
+
+            ulong magnitude = 0;
+            foreach (char c in digits)
+            {
+                int digit = c switch
+                {
+                    >= '0' and <= '9' => c - '0',
+                    >= 'a' and <= 'f' => c - 'a' + 10,
+                    >= 'A' and <= 'F' => c - 'A' + 10,
+                    _ => -1
+                };
+
+                if (digit < 0 || digit >= radix)
+                { return false; }
+
+                // Overflow would be ill-formed (or an extension), let Clang deal with it
+                if (magnitude > (UInt64.MaxValue - (ulong)digit) / (ulong)radix)
+                { return false; }
+
+                magnitude = magnitude * (ulong)radix + (ulong)digit;
+            }
+
+            // Determine the type of the literal, see [lex.icon]
+            // We skip suffixes involving `long` on its own since its size varies between targets.
+            // Note that `int` is always 32 bits and `long long` is always 64 bits for targets Biohazrd supports.
+            bool isDecimal = radix == 10;
+            int sizeBits;
+            bool isSigned;
+            switch (suffix)
+            {
+                case "":
+                    if (magnitude <= Int32.MaxValue)
+                    { (sizeBits, isSigned) = (32, true); }
+                    else if (!isDecimal && magnitude <= UInt32.MaxValue)
+                    { (sizeBits, isSigned) = (32, false); }
+                    else if (magnitude <= Int64.MaxValue)
+                    { (sizeBits, isSigned) = (64, true); }
+                    else if (!isDecimal)
+                    { (sizeBits, isSigned) = (64, false); }
+                    else
+                    { return false; }
+                    break;
+                case "u":
+                    (sizeBits, isSigned) = magnitude <= UInt32.MaxValue ? (32, false) : (64, false);
+                    break;
+                case "ll":
+                    if (magnitude <= Int64.MaxValue)
+                    { (sizeBits, isSigned) = (64, true); }
+                    else if (!isDecimal)
+                    { (sizeBits, isSigned) = (64, false); }
+                    else
+                    { return false; }
+                    break;
+                case "ull":
+                case "llu":
+                    (sizeBits, isSigned) = (64, false);
+                    break;
+                default:
+                    return false;
+            }
+
+            ulong result = negate ? unchecked(0UL - magnitude) : magnitude;
+
+            // Signed values are sign-extended and unsigned values are zero-extended
+            if (sizeBits == 32)
+            { result = isSigned ? unchecked((ulong)(long)(int)result) : (uint)result; }
+
+            value = new IntegerConstant()
+            {
+                SizeBits = sizeBits,
+                IsSigned = isSigned,
+                Value = result
+            };
+            return true;
+        }
+
+        private static bool TryParseFloatingPointLiteral(string token, bool negate, out ConstantValue? value)
+        {
+            value = null;
+
+            // Hexadecimal floating point literals are left to Clang
+            if (token.StartsWith("0x", StringComparison.OrdinalIgnoreCase))
+            { return false; }
+
+            // A floating point literal must have either a decimal point or an exponent, otherwise it's a malformed integer
+            if (token.IndexOfAny(new[] { '.', 'e', 'E' }) < 0)
+            { return false; }
+
+            bool isFloat = token.EndsWith('f') || token.EndsWith('F');
+            string number = isFloat ? token.Substring(0, token.Length - 1) : token;
+
+            foreach (char c in number)
+            {
+                // Long double and other suffixes are left to Clang
+                if (!Char.IsDigit(c) && c is not '.' and not 'e' and not 'E' and not '+' and not '-')
+                { return false; }
+            }
+
+            const NumberStyles styles = NumberStyles.AllowDecimalPoint | NumberStyles.AllowExponent;
+            if (isFloat)
+            {
+                if (!Single.TryParse(number, styles, CultureInfo.InvariantCulture, out float floatValue))
+                { return false; }
+
+                value = new FloatConstant(negate ? -floatValue : floatValue);
+            }
+            else
+            {
+                if (!Double.TryParse(number, styles, CultureInfo.InvariantCulture, out double doubleValue))
+                { return false; }
+
+                value = new DoubleConstant(negate ? -doubleValue : doubleValue);
+            }
+
+            return true;
+        }
+
+        /// <summary>Splits a macro's replacement text into preprocessing tokens.</summary>
+        /// <returns>The list of tokens or null if the text could not be tokenized.</returns>
+        /// <remarks>This is only a rough approximation of the C preprocessor's tokenizer, but it's good enough for classification purposes.</remarks>
+        private static List<string>? Tokenize(string text)
+        {
+            List<string> tokens = new();
+
+            static bool IsIdentifierStart(char c)
+                => c == '_' || c == '$' || Char.IsLetter(c);
+
+            static bool IsIdentifierPart(char c)
+                => IsIdentifierStart(c) || Char.IsDigit(c);
+
+            static bool SkipQuoted(string text, ref int i)
+            {
+                char quote = text[i];
+                i++;
+
+                while (i < text.Length)
+                {
+                    if (text[i] == '\\')
+                    { i += 2; }
+                    else if (text[i] == quote)
+                    {
+                        i++;
+                        return true;
+                    }
+                    else
+                    { i++; }
+                }
+
+                return false;
+            }
+
+            int i = 0;
+            while (i < text.Length)
+            {
+                char c = text[i];
+                char next = i + 1 < text.Length ? text[i + 1] : '\0';
+
+                if (Char.IsWhiteSpace(c))
+                {
+                    i++;
+                    continue;
+                }
+
+                // Comments
+                if (c == '/' && next == '/')
+                { break; }
+
+                if (c == '/' && next == '*')
+                {
+                    int commentEnd = text.IndexOf("*/", i + 2, StringComparison.Ordinal);
+
+                    if (commentEnd < 0)
+                    { return null; }
+
+                    i = commentEnd + 2;
+                    continue;
+                }
+
+                int start = i;
+                if (IsIdentifierStart(c))
+                {
+                    while (i < text.Length && IsIdentifierPart(text[i]))
+                    { i++; }
+
+                    // Prefixed string and character literals (L"", u8'', etc.)
+                    if (i < text.Length && (text[i] == '"' || text[i] == '\'') && !SkipQuoted(text, ref i))
+                    { return null; }
+                }
+                else if (Char.IsDigit(c) || (c == '.' && Char.IsDigit(next)))
+                {
+                    // Preprocessing numbers, see [lex.ppnumber]
+                    i++;
+                    while (i < text.Length)
+                    {
+                        char d = text[i];
+                        if (IsIdentifierPart(d) || d == '.' || d == '\'' || ((d == '+' || d == '-') && text[i - 1] is 'e' or 'E' or 'p' or 'P'))
+                        { i++; }
+                        else
+                        { break; }
+                    }
+                }
+                else if (c == '"' || c == '\'')
+                {
+                    if (!SkipQuoted(text, ref i))
+                    { return null; }
+                }
+                else if (TwoCharacterPunctuators.Contains((c, next)))
+                { i += 2; }
+                else
+                { i++; }
+
+                tokens.Add(text.Substring(start, i - start));
+            }
+
+            return tokens;
+        }
+
+        private static readonly HashSet<(char, char)> TwoCharacterPunctuators = new()
+        {
+            ('#', '#'), (':', ':'), ('-', '>'), ('<', '<'), ('>', '>'), ('<', '='), ('>', '='), ('=', '='), ('!', '='), ('&', '&'), ('|', '|'), ('+', '+'), ('-', '-')
+        };
+    }
+}
@@ -24,6 +24,18 @@ namespace Biohazrd
             }
         }
 
+        /// <summary>The UTF8-encoded contents of the unsaved file.</summary>
+        internal ReadOnlySpan<byte> UnsavedFileContents
+        {
+            get
+            {
+                if (UnsavedFileBuffer is null)
+                { throw new InvalidOperationException("This source file does not represent an unsaved file."); }
+
+                return UnsavedFileBuffer.AsSpan(UnsavedFileBuffer.Length - checked((int)_UnsavedFile.Length));
+            }
+        }
+
         public string FilePath { get; }
         public bool IsInScope { get; }
         public bool IndexDirectly { get; }
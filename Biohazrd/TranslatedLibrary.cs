@@ -6,6 +6,7 @@ using System.Collections.Generic;
 using System.Collections.Immutable;
 using System.Diagnostics;
 using System.Runtime.CompilerServices;
+using System.Threading;
 using ClangType = ClangSharp.Type;
 
 namespace Biohazrd
@@ -13,6 +14,7 @@ namespace Biohazrd
     public sealed record TranslatedLibrary : IEnumerable<TranslatedDeclaration>
     {
         private readonly TranslationUnitAndIndex TranslationUnitAndIndex;
+        private readonly IReadOnlySet<string> InMemoryFileNames;
 
         public ImmutableList<TranslatedDeclaration> Declarations { get; init; }
         public ImmutableArray<TranslatedMacro> Macros { get; }
@@ -21,9 +23,20 @@ namespace Biohazrd
         public ImmutableArray<TranslatedFile> Files { get; }
         public ImmutableArray<TranslationDiagnostic> ParsingDiagnostics { get; init; }
 
+        /// <summary>An optional log used by transformations to record diagnostics without modifying declarations.</summary>
+        /// <remarks>
+        /// This log is <c>null</c> by default, which means diagnostics are recorded in <see cref="TranslatedDeclaration.Diagnostics"/> as usual.
+        /// To enable it, set it to <see cref="TranslationDiagnosticLog.Empty"/>.
+        ///
+        /// The log is immutable. Each transformation produces a library with a new version of the log, so diagnostics never leak between libraries which branch from a common library.
+        /// Use <see cref="GetDiagnostics(TranslatedDeclaration)"/> to get all of the diagnostics for a declaration regardless of where they were recorded.
+        /// </remarks>
+        public TranslationDiagnosticLog? DiagnosticLog { get; init; }
+
         internal TranslatedLibrary
         (
             TranslationUnitAndIndex translationUnitAndIndex,
+            IReadOnlySet<string> inMemoryFileNames,
             ImmutableArray<TranslatedFile> files,
             ImmutableArray<TranslationDiagnostic> parsingDiagnostics,
             ImmutableList<TranslatedDeclaration> declarations,
@@ -31,6 +44,7 @@ namespace Biohazrd
         )
         {
             TranslationUnitAndIndex = translationUnitAndIndex;
+            InMemoryFileNames = inMemoryFileNames;
             Declarations = declarations;
             Macros = macros;
             Files = files;
@@ -43,7 +57,9 @@ namespace Biohazrd
         IEnumerator IEnumerable.GetEnumerator()
             => GetEnumerator();
 
-        //TODO: Thread safety
+        // The lookup caches are shared by every thread which resolves type references against this library (IE: parallel output generation), so all access to them must be done under this lock.
+        // (Note that clones of this library share the lock along with the caches themselves.)
+        private readonly object DeclarationLookupCacheLock = new();
         private WeakReference<TranslatedLibrary>? DeclarationLookupCacheLibrary = null;
         private Dictionary<Decl, (TranslatedDeclaration?, VisitorContext)> ClangDeclarationLookupCache = new();
         private Dictionary<DeclarationId, (TranslatedDeclaration?, VisitorContext)> DeclarationIdLookupCache = new();
@@ -51,6 +67,8 @@ namespace Biohazrd
         [MethodImpl(MethodImplOptions.AggressiveInlining)]
         private void InvalidateCacheIfStale()
         {
+            Debug.Assert(Monitor.IsEntered(DeclarationLookupCacheLock));
+
             // Check if this library is the same one the cache corresponds to
             // (Ideally we just don't bring over the cache when this object is cloned, but records don't currently allow this.)
             if (DeclarationLookupCacheLibrary is null || !DeclarationLookupCacheLibrary.TryGetTarget(out TranslatedLibrary? cacheLibrary) || !ReferenceEquals(cacheLibrary, this))
@@ -69,18 +87,22 @@ namespace Biohazrd
 
         public TranslatedDeclaration? TryFindTranslation(Decl declaration, out VisitorContext context)
         {
-            // Invalidate the cache if necessary
-            InvalidateCacheIfStale();
-
-            // Search for the declaration
             (TranslatedDeclaration? Result, VisitorContext Context) resultWithContext = default;
 
-            if (ClangDeclarationLookupCache.TryGetValue(declaration, out resultWithContext))
+            lock (DeclarationLookupCacheLock)
             {
-                context = resultWithContext.Context;
-                return resultWithContext.Result;
+                // Invalidate the cache if necessary
+                InvalidateCacheIfStale();
+
+                if (ClangDeclarationLookupCache.TryGetValue(declaration, out resultWithContext))
+                {
+                    context = resultWithContext.Context;
+                    return resultWithContext.Result;
+                }
             }
 
+            // Search for the declaration
+            // (This is done outside of the lock since it can be slow and the library itself is immutable.)
             foreach ((VisitorContext childContext, TranslatedDeclaration child) in this.EnumerateRecursivelyWithContext())
             {
                 if (child.IsTranslationOf(declaration))
@@ -98,7 +120,13 @@ namespace Biohazrd
             }
 
             // Cache the results and return them
-            ClangDeclarationLookupCache.Add(declaration, resultWithContext);
+            // (Another thread might've beaten us to it, in which case the results will be the same.)
+            lock (DeclarationLookupCacheLock)
+            {
+                InvalidateCacheIfStale();
+                ClangDeclarationLookupCache[declaration] = resultWithContext;
+            }
+
             context = resultWithContext.Context;
             return resultWithContext.Result;
         }
@@ -111,18 +139,22 @@ namespace Biohazrd
 
         public TranslatedDeclaration? TryFindTranslation(DeclarationId id, out VisitorContext context)
         {
-            // Invalidate the cache if necessary
-            InvalidateCacheIfStale();
-
-            // Search for the declaration
             (TranslatedDeclaration? Result, VisitorContext Context) resultWithContext = default;
 
-            if (DeclarationIdLookupCache.TryGetValue(id, out resultWithContext))
+            lock (DeclarationLookupCacheLock)
             {
-                context = resultWithContext.Context;
-                return resultWithContext.Result;
+                // Invalidate the cache if necessary
+                InvalidateCacheIfStale();
+
+                if (DeclarationIdLookupCache.TryGetValue(id, out resultWithContext))
+                {
+                    context = resultWithContext.Context;
+                    return resultWithContext.Result;
+                }
             }
 
+            // Search for the declaration
+            // (This is done outside of the lock since it can be slow and the library itself is immutable.)
             foreach ((VisitorContext childContext, TranslatedDeclaration child) in this.EnumerateRecursivelyWithContext())
             {
                 if (child.Id == id || child.ReplacedIds.Contains(id))
@@ -140,11 +172,45 @@ namespace Biohazrd
             }
 
             // Cache the results and return them
-            DeclarationIdLookupCache.Add(id, resultWithContext);
+            // (Another thread might've beaten us to it, in which case the results will be the same.)
+            lock (DeclarationLookupCacheLock)
+            {
+                InvalidateCacheIfStale();
+                DeclarationIdLookupCache[id] = resultWithContext;
+            }
+
             context = resultWithContext.Context;
             return resultWithContext.Result;
         }
 
+        /// <summary>Gets all diagnostics associated with the specified declaration.</summary>
+        /// <remarks>This includes both the declaration's <see cref="TranslatedDeclaration.Diagnostics"/> and any diagnostics recorded for it in <see cref="DiagnosticLog"/>.</remarks>
+        public ImmutableArray<TranslationDiagnostic> GetDiagnostics(TranslatedDeclaration declaration)
+        {
+            if (DiagnosticLog is null)
+            { return declaration.Diagnostics; }
+
+            ImmutableArray<TranslationDiagnostic> loggedDiagnostics = DiagnosticLog.Get(declaration.Id);
+
+            if (loggedDiagnostics.IsEmpty)
+            { return declaration.Diagnostics; }
+            else if (declaration.Diagnostics.IsEmpty)
+            { return loggedDiagnostics; }
+            else
+            { return declaration.Diagnostics.AddRange(loggedDiagnostics); }
+        }
+
+        /// <summary>Hashes the contents of every file on disk which Clang read while parsing this library.</summary>
+        /// <returns>The hex-encoded SHA-256 hash of each file's contents, keyed by the file's full path.</returns>
+        /// <remarks>
+        /// The hashes are computed from the exact contents Clang parsed rather than the current contents of the files,
+        /// so a file which was modified while the library was being parsed will not match its hash.
+        ///
+        /// In-memory files are not included since they can't change.
+        /// </remarks>
+        public ImmutableSortedDictionary<string, string> GetInputFileHashes()
+            => ConstantEvaluationCache.CollectInputs(TranslationUnitAndIndex.TranslationUnit.Handle, InMemoryFileNames);
+
         /// <summary>Finds the ClangSharp <see cref="Cursor"/> for the given <see cref="CXCursor"/> handle.</summary>
         /// <remarks>
         /// The provided cursor handle must be valid, non-null, and come from the same translation unit as the one used by this library.
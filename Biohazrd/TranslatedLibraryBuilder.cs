@@ -8,7 +8,9 @@ using System.Diagnostics;
 using System.IO;
 using System.Reflection;
 using System.Runtime.InteropServices;
+using System.Security.Cryptography;
 using System.Text;
+using System.Threading;
 
 namespace Biohazrd
 {
@@ -19,6 +21,23 @@ namespace Biohazrd
 
         public TranslationOptions Options { get; set; } = new();
 
+        /// <summary>If set, <see cref="Create"/> saves the parsed library as a precompiled header at this path for use by constant evaluators.</summary>
+        /// <remarks>
+        /// Constant evaluators created by <see cref="CreateConstantEvaluator"/> or <see cref="CreateConstantEvaluatorPool(int)"/> will use this precompiled header
+        /// instead of reparsing the entire library. If the file already exists from a previous run, it will be used even if <see cref="Create"/> is never called.
+        ///
+        /// Clang validates that the headers and command line arguments used to create the precompiled header have not changed.
+        /// If the file is stale or cannot be loaded, the evaluator will fall back to reparsing the library.
+        /// </remarks>
+        public string? PrecompiledHeaderPath { get; set; }
+
+        /// <summary>If set, constant evaluators will persist their results to a <see cref="ConstantEvaluationCache"/> at this path.</summary>
+        /// <remarks>
+        /// The cache allows subsequent runs of a generator to skip reparsing for any expressions which were evaluated by a previous run.
+        /// See <see cref="ConstantEvaluationCache"/> for details on how the cache is invalidated.
+        /// </remarks>
+        public string? ConstantEvaluationCachePath { get; set; }
+
         public void AddFile(SourceFile sourceFile)
         {
             Debug.Assert(Path.IsPathFullyQualified(sourceFile.FilePath), "File paths should always be fully qualified.");
@@ -191,9 +210,16 @@ namespace Biohazrd
             return result;
         }
 
-        public unsafe TranslatedLibrary Create()
+        /// <summary>Parses the configured files and creates a <see cref="TranslatedLibrary"/> from them.</summary>
+        /// <param name="cancellationToken">A token used to cancel processing of the translation unit.</param>
+        /// <param name="progress">If specified, receives the number of top-level cursors processed out of the total as the translation unit is processed.</param>
+        /// <remarks>
+        /// Parsing by Clang itself cannot be interrupted, so cancellation is only observed before parsing begins and while the resulting translation unit is being processed.
+        /// </remarks>
+        public unsafe TranslatedLibrary Create(CancellationToken cancellationToken = default, IProgress<TranslationProgress>? progress = null)
         {
             __HACK__InstallLibClangDllWorkaround();
+            cancellationToken.ThrowIfCancellationRequested();
 
             ImmutableArray<TranslationDiagnostic>.Builder miscDiagnostics = ImmutableArray.CreateBuilder<TranslationDiagnostic>();
 
@@ -202,6 +228,7 @@ namespace Biohazrd
             //---------------------------------------------------------------------------------------------------------------------------------------------------------------------
             TranslationUnitAndIndex? translationUnitAndIndex = null;
             TranslationUnit? translationUnit = null;
+            HashSet<string> inMemoryFileNames = new();
             {
                 CXIndex clangIndex = default;
                 CXTranslationUnit translationUnitHandle = default;
@@ -213,7 +240,10 @@ namespace Biohazrd
                     // Create the translation unit
                     //---------------------------------------------------------------------------------
                     // Do not enable CXTranslationUnit_IncludeAttributedTypes without resolving https://github.com/InfectedLibraries/Biohazrd/issues/130
-                    const CXTranslationUnit_Flags translationUnitFlags = 0;
+                    CXTranslationUnit_Flags translationUnitFlags = 0;
+
+                    if (PrecompiledHeaderPath is not null)
+                    { translationUnitFlags |= CXTranslationUnit_Flags.CXTranslationUnit_ForSerialization; }
 
                     // Allocate the libclang Index
                     clangIndex = CXIndex.Create();
@@ -222,6 +252,14 @@ namespace Biohazrd
                     indexFile = new SourceFileInternal(CreateIndexFile());
                     List<CXUnsavedFile> unsavedFiles = CreateUnsavedFilesList(indexFile);
 
+                    foreach (CXUnsavedFile unsavedFile in unsavedFiles)
+                    {
+                        string? fileName = Marshal.PtrToStringUTF8((IntPtr)unsavedFile.Filename);
+
+                        if (fileName is not null)
+                        { inMemoryFileNames.Add(fileName); }
+                    }
+
                     CXErrorCode translationUnitStatus = CXTranslationUnit.TryParse
                     (
                         clangIndex,
@@ -257,6 +295,21 @@ namespace Biohazrd
                         { miscDiagnostics.Add(Severity.Warning, $"Failed to late-instantiate {metrics.FailedInstantiationsCount} template specialization{(metrics.FailedInstantiationsCount == 1 ? "" : "s")}."); }
                     }
 
+                    // Save the precompiled header for the constant evaluator if requested
+                    // If saving fails we remove any existing file so evaluators don't pick up a precompiled header from a previous run.
+                    if (PrecompiledHeaderPath is not null)
+                    {
+                        CXSaveError saveStatus = translationUnitHandle.Save(PrecompiledHeaderPath, CXSaveTranslationUnit_Flags.CXSaveTranslationUnit_None);
+
+                        if (saveStatus != CXSaveError.CXSaveError_None)
+                        {
+                            miscDiagnostics.Add(Severity.Warning, $"Failed to save the precompiled header for constant evaluation to '{PrecompiledHeaderPath}': {saveStatus}");
+
+                            if (File.Exists(PrecompiledHeaderPath))
+                            { File.Delete(PrecompiledHeaderPath); }
+                        }
+                    }
+
                     // Create the translation unit
                     translationUnit = TranslationUnit.GetOrCreate(translationUnitHandle);
 
@@ -282,7 +335,16 @@ namespace Biohazrd
             //---------------------------------------------------------------------------------------------------------------------------------------------------------------------
             // Process the translation unit
             //---------------------------------------------------------------------------------------------------------------------------------------------------------------------
-            TranslationUnitParser processor = new(Files, Options, translationUnit);
+            TranslationUnitParser processor;
+            try
+            { processor = new(Files, Options, translationUnit, cancellationToken, progress); }
+            catch
+            {
+                // Make sure the translation unit doesn't outlive a cancelled or failed parse
+                translationUnitAndIndex?.Dispose();
+                throw;
+            }
+
             ImmutableArray<TranslatedFile> files;
             ImmutableArray<TranslationDiagnostic> parsingDiagnostics;
             ImmutableList<TranslatedDeclaration> declarations;
@@ -301,18 +363,91 @@ namespace Biohazrd
             { parsingDiagnostics = stl1300Workaround.Diagnostics.AddRange(parsingDiagnostics); }
 
             // Create the library
-            return new TranslatedLibrary(translationUnitAndIndex, files, parsingDiagnostics, declarations, macros);
+            return new TranslatedLibrary(translationUnitAndIndex, inMemoryFileNames, files, parsingDiagnostics, declarations, macros);
         }
 
         /// <summary>Creates a constant evaluator for evaluating macros and arbitrary C++ expressions.</summary>
-        /// <remarks>The constant evaluator has a significant overhead (internally it has to reparse the entirity of the C++ library) so don't create it unless you plan to actually use it.</remarks>
+        /// <remarks>
+        /// The constant evaluator has a significant overhead (internally it has to reparse the entirity of the C++ library) so don't create it unless you plan to actually use it.
+        ///
+        /// This overhead can be avoided by setting <see cref="PrecompiledHeaderPath"/> before calling <see cref="Create"/>, in which case the evaluator starts from the saved parse.
+        /// </remarks>
         public TranslatedLibraryConstantEvaluator CreateConstantEvaluator()
             => new TranslatedLibraryConstantEvaluator
             (
                 CreateIndexFile(),
                 Files.ToImmutableArray(),
                 CreateUnsavedFilesList(indexFile: null), // The constant evaluator needs to be responsible for the index file so it can keep it from being collected.
-                CollectionsMarshal.AsSpan(CommandLineArguments)
+                CollectionsMarshal.AsSpan(CommandLineArguments),
+                PrecompiledHeaderPath,
+                CreateConstantEvaluationCache()
             );
+
+        /// <summary>Creates a pool of constant evaluators for evaluating large batches of macros and arbitrary C++ expressions concurrently.</summary>
+        /// <param name="degreeOfParallelism">The number of evaluators in the pool. Defaults to the number of processors.</param>
+        /// <remarks>
+        /// Each evaluator in the pool has the same overhead as one created by <see cref="CreateConstantEvaluator"/> (although they are created concurrently),
+        /// so only use a pool when you have enough expressions to evaluate to make it worthwhile.
+        /// </remarks>
+        public TranslatedLibraryConstantEvaluatorPool CreateConstantEvaluatorPool(int degreeOfParallelism = 0)
+        {
+            if (degreeOfParallelism < 0)
+            { throw new ArgumentOutOfRangeException(nameof(degreeOfParallelism)); }
+            else if (degreeOfParallelism == 0)
+            { degreeOfParallelism = Environment.ProcessorCount; }
+
+            // Snapshot the index file and arguments ahead of time since the evaluators are created concurrently
+            SourceFile indexFile = CreateIndexFile();
+            ImmutableArray<SourceFileInternal> files = Files.ToImmutableArray();
+            string[] commandLineArguments = CommandLineArguments.ToArray();
+            string? precompiledHeaderPath = PrecompiledHeaderPath;
+
+            // Each evaluator gets its own unsaved files list since it uses the first entry for its evaluation index file
+            List<CXUnsavedFile>[] unsavedFiles = new List<CXUnsavedFile>[degreeOfParallelism];
+            for (int i = 0; i < unsavedFiles.Length; i++)
+            { unsavedFiles[i] = CreateUnsavedFilesList(indexFile: null); }
+
+            // The cache is handled by the pool rather than the individual evaluators so that each batch only needs to be looked up and saved once
+            int nextEvaluator = -1;
+            ConstantEvaluationCache? cache = CreateConstantEvaluationCache();
+            return new TranslatedLibraryConstantEvaluatorPool
+            (
+                degreeOfParallelism,
+                // The evaluators still report the inputs they read to the cache so it can tell whether its results are stale
+                () => new TranslatedLibraryConstantEvaluator(indexFile, files, unsavedFiles[Interlocked.Increment(ref nextEvaluator)], commandLineArguments, precompiledHeaderPath, inputTracker: cache),
+                cache
+            );
+        }
+
+        private ConstantEvaluationCache? CreateConstantEvaluationCache()
+        {
+            if (ConstantEvaluationCachePath is null)
+            { return null; }
+
+            // The cache key covers the configuration of the library and the contents of in-memory files
+            // The contents of files on disk (including those only reached via #include) are validated by the cache itself once an evaluator reports which files Clang read.
+            using IncrementalHash hash = IncrementalHash.CreateHash(HashAlgorithmName.SHA256);
+
+            void AppendString(string value)
+            {
+                hash.AppendData(Encoding.UTF8.GetBytes(value));
+                hash.AppendData(stackalloc byte[1] { 0 });
+            }
+
+            foreach (string argument in CommandLineArguments)
+            { AppendString(argument); }
+
+            AppendString(CreateIndexFile().Contents ?? "");
+
+            foreach (SourceFileInternal file in Files)
+            {
+                AppendString(file.FilePath);
+
+                if (file.HasUnsavedFile)
+                { hash.AppendData(file.UnsavedFileContents); }
+            }
+
+            return new ConstantEvaluationCache(ConstantEvaluationCachePath, Convert.ToHexString(hash.GetHashAndReset()));
+        }
     }
 }
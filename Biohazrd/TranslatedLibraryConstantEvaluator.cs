@@ -1,12 +1,16 @@
 ﻿using Biohazrd.Expressions;
 using ClangSharp.Interop;
 using System;
+using System.Buffers;
 using System.Collections.Generic;
 using System.Collections.Immutable;
 using System.Diagnostics;
+using System.IO;
 using System.Runtime.CompilerServices;
 using System.Runtime.InteropServices;
 using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
 
 namespace Biohazrd
 {
@@ -22,6 +26,9 @@ namespace Biohazrd
          *
          *  Additionally, it isn't really expected that a macro will be evaluated more than once. A typical Biohazrd generator is expected to probably only have one
          *  transformation which has to process macros, or multiple transformations which process unrelated macros. As such, caching probably wouldn't even be helpful here.
+         *
+         *  The exception to this is across runs of a generator, where the same macros are evaluated every time. This is handled by the opt-in ConstantEvaluationCache,
+         *  which accepts the above caveat about broken expressions in exchange for skipping reparsing entirely on warm runs.
          */
 
         // This class uses translation unit reparsing, which does not play nice with ClangSharp's internal caching.
@@ -29,17 +36,95 @@ namespace Biohazrd
         private readonly CXIndex ClangIndex;
         private readonly CXTranslationUnit UnitHandle;
 
-        private readonly SourceFile IndexFileBase;
+        /// <summary>The file used as the basis for the main file of each evaluation.</summary>
+        private readonly SourceFile EvaluationFileBase;
+        /// <summary>The index of the evaluation file within <see cref="UnsavedFiles"/>.</summary>
+        private readonly int EvaluationFileIndex;
         private readonly ImmutableArray<SourceFileInternal> SourceFiles; // This is primarily to ensure the buffers behind the unsaved files are not garbage collected
+        private readonly SourceFileInternal? IndexFile; // Only used (and kept alive) when using a precompiled header
         private readonly List<CXUnsavedFile> UnsavedFiles;
 
         private readonly object ConcurrencyLock = new();
-
-        internal TranslatedLibraryConstantEvaluator(SourceFile indexFileBase, ImmutableArray<SourceFileInternal> sourceFiles, List<CXUnsavedFile> unsavedFiles, ReadOnlySpan<string> commandLineArguments)
+        private readonly ConstantEvaluationCache? Cache;
+        /// <summary>The cache which is informed of the files read by each parse of <see cref="UnitHandle"/>, usually the same as <see cref="Cache"/>.</summary>
+        /// <remarks>This differs from <see cref="Cache"/> for evaluators owned by a <see cref="TranslatedLibraryConstantEvaluatorPool"/>, which handles cache lookups itself.</remarks>
+        private readonly ConstantEvaluationCache? InputTracker;
+        /// <summary>The names of the in-memory files used by this evaluator, which are covered by the cache key rather than tracked as inputs.</summary>
+        private readonly HashSet<string>? InMemoryFileNames;
+
+        /// <summary>True if this evaluator was created from a precompiled header saved by <see cref="TranslatedLibraryBuilder.Create"/> rather than by reparsing the library.</summary>
+        public bool IsUsingPrecompiledHeader { get; }
+
+        internal TranslatedLibraryConstantEvaluator
+        (
+            SourceFile indexFileBase,
+            ImmutableArray<SourceFileInternal> sourceFiles,
+            List<CXUnsavedFile> unsavedFiles,
+            ReadOnlySpan<string> commandLineArguments,
+            string? precompiledHeaderPath = null,
+            ConstantEvaluationCache? cache = null,
+            ConstantEvaluationCache? inputTracker = null
+        )
         {
-            IndexFileBase = indexFileBase;
             SourceFiles = sourceFiles;
+            Cache = cache;
+            InputTracker = inputTracker ?? cache;
             UnsavedFiles = unsavedFiles;
+            ClangIndex = CXIndex.Create();
+
+            // If we have a precompiled header of the library, try to start from it
+            // In this mode the index file is not the main file. Instead each evaluation is parsed in its own tiny main file which uses the precompiled header as a prefix.
+            // The index file is still provided as an unsaved file since it's an input of the precompiled header and Clang will validate it hasn't changed.
+            if (precompiledHeaderPath is not null && File.Exists(precompiledHeaderPath))
+            {
+                IndexFile = new SourceFileInternal(indexFileBase);
+                UnsavedFiles[0] = IndexFile.UnsavedFile;
+
+                EvaluationFileBase = new SourceFile(EvaluationFilePath)
+                {
+                    IsInScope = false,
+                    IndexDirectly = false,
+                    Contents = ""
+                };
+                EvaluationFileIndex = UnsavedFiles.Count;
+                SourceFileInternal initialEvaluationFile = new(EvaluationFileBase);
+                UnsavedFiles.Add(initialEvaluationFile.UnsavedFile);
+
+                string[] precompiledHeaderArguments = new string[commandLineArguments.Length + 2];
+                commandLineArguments.CopyTo(precompiledHeaderArguments);
+                precompiledHeaderArguments[^2] = "-include-pch";
+                precompiledHeaderArguments[^1] = precompiledHeaderPath;
+
+                CXErrorCode precompiledHeaderStatus = CXTranslationUnit.TryParse
+                (
+                    ClangIndex,
+                    EvaluationFileBase.FilePath,
+                    precompiledHeaderArguments,
+                    CollectionsMarshal.AsSpan(UnsavedFiles),
+                    CXTranslationUnit_Flags.CXTranslationUnit_IgnoreNonErrorsFromIncludedFiles | CXTranslationUnit_Flags.CXTranslationUnit_SkipFunctionBodies,
+                    out UnitHandle
+                );
+
+                GC.KeepAlive(initialEvaluationFile);
+
+                // If the precompiled header is stale or otherwise could not be loaded Clang will report a fatal error, in which case we fall back to parsing the library
+                if (precompiledHeaderStatus == CXErrorCode.CXError_Success && !HasFatalDiagnostics(UnitHandle))
+                {
+                    IsUsingPrecompiledHeader = true;
+                    InMemoryFileNames = GetInMemoryFileNames();
+                    ObserveInputs();
+                    return;
+                }
+
+                if (UnitHandle.Handle != default)
+                { UnitHandle.Dispose(); }
+
+                UnsavedFiles.RemoveAt(EvaluationFileIndex);
+                IndexFile = null;
+            }
+
+            EvaluationFileBase = indexFileBase;
+            EvaluationFileIndex = 0;
 
             // Create the initial parsing
             // We can't reuse the parsing from an existing TranslatedLibrary because when we reparse later we end up invalidating all of the memory associated with the original translation unit.
@@ -47,7 +132,6 @@ namespace Biohazrd
             SourceFileInternal initialIndexFile = new(indexFileBase);
             UnsavedFiles[0] = initialIndexFile.UnsavedFile;
 
-            ClangIndex = CXIndex.Create();
             CXErrorCode translationUnitStatus = CXTranslationUnit.TryParse
             (
                 ClangIndex,
@@ -79,6 +163,51 @@ namespace Biohazrd
             // ClangSharp does not properly handle a CXTranslationUnit and its associated memory
             // becoming invalid when the reparse occurs!
             //!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+
+            InMemoryFileNames = GetInMemoryFileNames();
+            ObserveInputs();
+        }
+
+        private unsafe HashSet<string>? GetInMemoryFileNames()
+        {
+            if (InputTracker is null)
+            { return null; }
+
+            HashSet<string> result = new();
+            foreach (CXUnsavedFile unsavedFile in UnsavedFiles)
+            {
+                string? fileName = Marshal.PtrToStringUTF8((IntPtr)unsavedFile.Filename);
+
+                if (fileName is not null)
+                { result.Add(fileName); }
+            }
+
+            return result;
+        }
+
+        /// <summary>Reports the files read by the most recent parse of <see cref="UnitHandle"/> to <see cref="InputTracker"/>.</summary>
+        /// <remarks>This is done after every parse since Clang will pick up modified headers when it reparses.</remarks>
+        private void ObserveInputs()
+        {
+            if (InputTracker is null)
+            { return; }
+
+            Debug.Assert(InMemoryFileNames is not null);
+            InputTracker.ObserveInputs(ConstantEvaluationCache.CollectInputs(UnitHandle, InMemoryFileNames));
+        }
+
+        // Like the index file, we intentionally use a file name that's illegal (on Windows) so it's unlikely we conflict with any real files.
+        private const string EvaluationFilePath = "<>BiohazrdEvaluationFile.cpp";
+
+        private static bool HasFatalDiagnostics(CXTranslationUnit unit)
+        {
+            foreach (CXDiagnostic diagnostic in unit.DiagnosticSet)
+            {
+                if (diagnostic.Severity >= CXDiagnosticSeverity.CXDiagnostic_Fatal)
+                { return true; }
+            }
+
+            return false;
         }
 
         public ConstantEvaluationResult Evaluate(TranslatedMacro macro)
@@ -139,12 +268,47 @@ namespace Biohazrd
 
         public ConstantEvaluationResult Evaluate(string expression)
         {
-            ImmutableArray<ConstantEvaluationResult> results = EvaluateBatch(new[] { expression });
+            ImmutableArray<ConstantEvaluationResult> results = EvaluateBatch(new[] { expression }, out ImmutableArray<TranslationDiagnostic> batchDiagnostics);
             Debug.Assert(results.Length == 1);
-            return results[0];
+            ConstantEvaluationResult result = results[0];
+
+            // A lone evaluation is its own batch, so the batch diagnostics belong to it
+            if (!batchDiagnostics.IsEmpty)
+            { result = new ConstantEvaluationResult(result.Expression, result.Value, batchDiagnostics.AddRange(result.Diagnostics)); }
+
+            return result;
+        }
+
+        /// <inheritdoc cref="EvaluateBatch(IReadOnlyList{string}, CancellationToken, IProgress{TranslationProgress}?)"/>
+        public ConstantEvaluationBatchResult EvaluateBatch
+        (
+            IEnumerable<TranslatedMacro> macros,
+            CancellationToken cancellationToken = default,
+            IProgress<TranslationProgress>? progress = null
+        )
+        {
+            ImmutableArray<ConstantEvaluationResult> results = EvaluateBatch(macros, out ImmutableArray<TranslationDiagnostic> batchDiagnostics, cancellationToken, progress);
+            return new ConstantEvaluationBatchResult(results, batchDiagnostics);
+        }
+
+        /// <inheritdoc cref="EvaluateBatch(IReadOnlyList{string}, out ImmutableArray{TranslationDiagnostic}, CancellationToken, IProgress{TranslationProgress}?)"/>
+        public ImmutableArray<ConstantEvaluationResult> EvaluateBatch
+        (
+            IEnumerable<TranslatedMacro> macros,
+            out ImmutableArray<TranslationDiagnostic> batchDiagnostics,
+            CancellationToken cancellationToken = default,
+            IProgress<TranslationProgress>? progress = null
+        )
+        {
+            List<string> macroExpressions = GetMacroExpressions(macros);
+            return EvaluateBatch(macroExpressions, out batchDiagnostics, cancellationToken, progress);
         }
 
-        public ImmutableArray<ConstantEvaluationResult> EvaluateBatch(IEnumerable<TranslatedMacro> macros)
+        /// <summary>Gets the placeholder file name used for the locations of diagnostics which came from evaluating the specified expression.</summary>
+        internal static string GetEvaluationSourceFileName(string expression)
+            => $"Evaluation of `{expression}`";
+
+        internal static List<string> GetMacroExpressions(IEnumerable<TranslatedMacro> macros)
         {
             List<string> macroExpressions = macros is ICollection<TranslatedMacro> collection ? new(collection.Count) : new();
 
@@ -170,23 +334,230 @@ namespace Biohazrd
                 { macroExpressions.Add(macro.Name); }
             }
 
-            return EvaluateBatch(macroExpressions);
+            return macroExpressions;
         }
 
-        public unsafe ImmutableArray<ConstantEvaluationResult> EvaluateBatch(IReadOnlyList<string> expressions)
+        /// <summary>Evaluates a batch of expressions.</summary>
+        /// <returns>The results of the evaluations along with the diagnostics which belong to the batch as a whole.</returns>
+        /// <inheritdoc cref="EvaluateBatch(IReadOnlyList{string}, out ImmutableArray{TranslationDiagnostic}, CancellationToken, IProgress{TranslationProgress}?)"/>
+        public ConstantEvaluationBatchResult EvaluateBatch
+        (
+            IReadOnlyList<string> expressions,
+            CancellationToken cancellationToken = default,
+            IProgress<TranslationProgress>? progress = null
+        )
+        {
+            ImmutableArray<ConstantEvaluationResult> results = EvaluateBatch(expressions, out ImmutableArray<TranslationDiagnostic> batchDiagnostics, cancellationToken, progress);
+            return new ConstantEvaluationBatchResult(results, batchDiagnostics);
+        }
+
+        /// <summary>Evaluates a batch of expressions.</summary>
+        /// <param name="batchDiagnostics">
+        /// Receives diagnostics which aren't associated with any particular evaluation, such as errors from the library's headers.
+        /// Each unique diagnostic is reported once for the entire batch rather than once for every evaluation.
+        /// </param>
+        /// <param name="cancellationToken">A token used to cancel the evaluation.</param>
+        /// <param name="progress">If specified, receives the number of expressions evaluated out of the total.</param>
+        /// <remarks>
+        /// Large batches are automatically split into chunks which are evaluated one after another, see <see cref="MaximumChunkSize"/> for details.
+        ///
+        /// Reparsing the translation unit cannot be interrupted, so cancellation is only observed between reparses and while the results are being tabulated.
+        /// </remarks>
+        public ImmutableArray<ConstantEvaluationResult> EvaluateBatch
+        (
+            IReadOnlyList<string> expressions,
+            out ImmutableArray<TranslationDiagnostic> batchDiagnostics,
+            CancellationToken cancellationToken = default,
+            IProgress<TranslationProgress>? progress = null
+        )
+            => Cache is null
+                ? EvaluateBatchCore(expressions, out batchDiagnostics, cancellationToken, progress)
+                : Cache.EvaluateBatch(expressions, out batchDiagnostics, EvaluateBatchCore, cancellationToken, progress);
+
+        /// <summary>Evaluates a batch of expressions on a dedicated background thread.</summary>
+        /// <remarks>
+        /// The evaluator uses its own translation unit, so it's safe to continue processing (and transforming) the corresponding <see cref="TranslatedLibrary"/> while the evaluation runs.
+        /// </remarks>
+        public Task<ConstantEvaluationBatchResult> EvaluateBatchAsync
+        (
+            IReadOnlyList<string> expressions,
+            CancellationToken cancellationToken = default,
+            IProgress<TranslationProgress>? progress = null
+        )
         {
             CheckDisposed();
+
+            // Reparsing takes a long time and blocks the entire time, so we don't want to tie up a thread pool thread with it
+            return Task.Factory.StartNew
+            (
+                () => EvaluateBatch(expressions, cancellationToken, progress),
+                cancellationToken,
+                TaskCreationOptions.LongRunning,
+                TaskScheduler.Default
+            );
+        }
+
+        /// <inheritdoc cref="EvaluateBatchAsync(IReadOnlyList{string}, CancellationToken, IProgress{TranslationProgress}?)"/>
+        public Task<ConstantEvaluationBatchResult> EvaluateBatchAsync
+        (
+            IEnumerable<TranslatedMacro> macros,
+            CancellationToken cancellationToken = default,
+            IProgress<TranslationProgress>? progress = null
+        )
+            // The macros are converted to expressions eagerly so that invalid macros are reported to the caller immediately
+            => EvaluateBatchAsync(TranslatedLibraryConstantEvaluator.GetMacroExpressions(macros), cancellationToken, progress);
+
+        /// <summary>The maximum number of expressions evaluated by a single reparse of the evaluation translation unit.</summary>
+        /// <remarks>
+        /// Batches are evaluated in chunks to bound the memory used by Clang and so that a single expression which causes a fatal error can't poison an entire batch.
+        /// The actual chunk size is tuned automatically based on the measured cost of reparsing, this property only puts an upper bound on it.
+        ///
+        /// When an expression in a chunk causes a fatal error, the expressions before it are unaffected (Clang processes the evaluations in order) and the expressions
+        /// after it are automatically reevaluated in a new chunk.
+        /// </remarks>
+        public int MaximumChunkSize
+        {
+            get => _MaximumChunkSize;
+            set
+            {
+                if (value < 1)
+                { throw new ArgumentOutOfRangeException(nameof(value)); }
+
+                _MaximumChunkSize = value;
+            }
+        }
+        private int _MaximumChunkSize = 8192;
+
+        private const int MinimumChunkSize = 64;
+        private const int InitialChunkSize = 512;
+        // The fraction of each reparse we're willing to spend on the fixed overhead of reparsing (IE: the parts which don't depend on the number of expressions.)
+        private const double TargetReparseOverhead = 0.1;
+
+        // Chunk size tuning state, protected by ConcurrencyLock
+        private int ChunkSize = InitialChunkSize;
+        private (int Count, double Seconds) PreviousChunkMeasurement;
+
+        private ImmutableArray<ConstantEvaluationResult> EvaluateBatchCore
+        (
+            IReadOnlyList<string> expressions,
+            out ImmutableArray<TranslationDiagnostic> batchDiagnostics,
+            CancellationToken cancellationToken,
+            IProgress<TranslationProgress>? progress
+        )
+        {
+            CheckDisposed();
+            cancellationToken.ThrowIfCancellationRequested();
+
+            ImmutableArray<ConstantEvaluationResult>.Builder results = ImmutableArray.CreateBuilder<ConstantEvaluationResult>(expressions.Count);
+            BatchDiagnosticsBuilder batchDiagnosticsBuilder = new();
+
+            // At this point until completion, this thread owns the translation unit
+            lock (ConcurrencyLock)
+            {
+                int start = 0;
+                while (start < expressions.Count)
+                {
+                    cancellationToken.ThrowIfCancellationRequested();
+                    int count = Math.Min(Math.Min(ChunkSize, MaximumChunkSize), expressions.Count - start);
+
+                    Stopwatch stopwatch = Stopwatch.StartNew();
+                    int evaluatedCount = EvaluateChunk(expressions, start, count, results, batchDiagnosticsBuilder, cancellationToken);
+                    stopwatch.Stop();
+                    ObserveInputs();
+
+                    // Chunks which ended in a fatal error didn't reparse everything, so they aren't representative
+                    if (evaluatedCount == count)
+                    { TuneChunkSize(count, stopwatch.Elapsed.TotalSeconds); }
+
+                    start += evaluatedCount;
+                    progress?.Report(new TranslationProgress(start, expressions.Count));
+                }
+            }
+
+            batchDiagnostics = batchDiagnosticsBuilder.ToImmutable();
+            return results.MoveToImmutable();
+        }
+
+        /// <summary>Collects diagnostics which aren't associated with a specific evaluation, removing duplicates.</summary>
+        /// <remarks>The same diagnostics from the library's headers will be reported by every reparse, so we only keep one of each.</remarks>
+        internal sealed class BatchDiagnosticsBuilder
+        {
+            private readonly ImmutableArray<TranslationDiagnostic>.Builder Diagnostics = ImmutableArray.CreateBuilder<TranslationDiagnostic>();
+            private readonly HashSet<(Severity, string, string?, int, int)> SeenDiagnostics = new();
+
+            public void Add(TranslationDiagnostic diagnostic)
+            {
+                if (SeenDiagnostics.Add((diagnostic.Severity, diagnostic.Message, diagnostic.Location.SourceFile, diagnostic.Location.Line, diagnostic.Location.Column)))
+                { Diagnostics.Add(diagnostic); }
+            }
+
+            public void AddRange(ImmutableArray<TranslationDiagnostic> diagnostics)
+            {
+                foreach (TranslationDiagnostic diagnostic in diagnostics)
+                { Add(diagnostic); }
+            }
+
+            public ImmutableArray<TranslationDiagnostic> ToImmutable()
+                => Diagnostics.MoveToImmutableSafe();
+        }
+
+        /// <summary>Adjusts <see cref="ChunkSize"/> based on the time it took to evaluate a chunk.</summary>
+        /// <remarks>
+        /// We model the cost of a reparse as a fixed overhead plus a per-expression cost and estimate both from the two most recent chunks of differing sizes.
+        /// The chunk size is then chosen such that the fixed overhead is <see cref="TargetReparseOverhead"/> of the total.
+        /// </remarks>
+        private void TuneChunkSize(int count, double seconds)
+        {
+            (int previousCount, double previousSeconds) = PreviousChunkMeasurement;
+            PreviousChunkMeasurement = (count, seconds);
+
+            if (previousCount == 0 || previousCount == count)
+            {
+                // We don't have enough information to estimate the costs yet, so we just try a different size to get a second data point
+                // (Chunks which are smaller than the chunk size are the tail end of a batch and shouldn't cause us to shrink.)
+                if (count == ChunkSize)
+                { ChunkSize = ClampChunkSize(ChunkSize * 2.0); }
+
+                return;
+            }
+
+            double perExpressionSeconds = (seconds - previousSeconds) / (count - previousCount);
+            double fixedSeconds = seconds - (perExpressionSeconds * count);
+
+            // If the measurements are too noisy to make sense of, leave the chunk size alone
+            if (perExpressionSeconds <= 0.0 || fixedSeconds <= 0.0)
+            { return; }
+
+            double idealChunkSize = fixedSeconds * (1.0 - TargetReparseOverhead) / (TargetReparseOverhead * perExpressionSeconds);
+            ChunkSize = ClampChunkSize(idealChunkSize);
+        }
+
+        private int ClampChunkSize(double chunkSize)
+            => (int)Math.Min(Math.Max(chunkSize, MinimumChunkSize), MaximumChunkSize);
+
+        /// <summary>Evaluates a single chunk of expressions, adding them to <paramref name="results"/>.</summary>
+        /// <returns>The number of expressions which were evaluated. This will be less than <paramref name="count"/> if an expression caused a fatal error.</returns>
+        private unsafe int EvaluateChunk
+        (
+            IReadOnlyList<string> expressions,
+            int start,
+            int count,
+            ImmutableArray<ConstantEvaluationResult>.Builder results,
+            BatchDiagnosticsBuilder batchDiagnostics,
+            CancellationToken cancellationToken
+        )
+        {
             const string evaluationPrefix = "__BIOHAZRD_EXPRESSION_EVALUATION__";
 
             //-------------------------------------------------------------------------------------
             // Build the evaluation index file
             //-------------------------------------------------------------------------------------
-            StringBuilder evaluationIndexFileContents = new(IndexFileBase.Contents);
-            for (int i = 0; i < expressions.Count; i++)
+            StringBuilder evaluationIndexFileContents = new(EvaluationFileBase.Contents);
+            for (int i = 0; i < count; i++)
             {
                 string evaluationId = $"{evaluationPrefix}{i}";
                 evaluationIndexFileContents.AppendLine($"#line 1 \"{evaluationId}\"");
-                evaluationIndexFileContents.AppendLine($"auto {evaluationId} = {expressions[i]};");
+                evaluationIndexFileContents.AppendLine($"auto {evaluationId} = {expressions[start + i]};");
             }
 
             //-------------------------------------------------------------------------------------
@@ -194,165 +565,169 @@ namespace Biohazrd
             //-------------------------------------------------------------------------------------
             SourceFileInternal evaluationIndexFile = new
             (
-                IndexFileBase with
+                EvaluationFileBase with
                 {
                     Contents = evaluationIndexFileContents.ToString()
                 }
             );
 
-            // At this point until completion, this thread owns the translation unit
-            lock (ConcurrencyLock)
-            {
-                UnsavedFiles[0] = evaluationIndexFile.UnsavedFile;
+            UnsavedFiles[EvaluationFileIndex] = evaluationIndexFile.UnsavedFile;
 
-                CXErrorCode unitStatus = UnitHandle.Reparse
-                (
-                    CollectionsMarshal.AsSpan(UnsavedFiles),
-                    UnitHandle.DefaultReparseOptions
-                );
+            CXErrorCode unitStatus = UnitHandle.Reparse
+            (
+                CollectionsMarshal.AsSpan(UnsavedFiles),
+                UnitHandle.DefaultReparseOptions
+            );
 
-                // In the event reparsing fails, we throw an exception
-                // This generally never happens since Clang usually emits diagnostics in a healthy manner.
-                // libclang uses the status code to report things like internal programming errors or invalid arguments.
-                if (unitStatus != CXErrorCode.CXError_Success)
-                { throw new InvalidOperationException($"Failed to parse the Biohazrd evaluation index file due to a fatal Clang error {unitStatus}."); }
+            // In the event reparsing fails, we throw an exception
+            // This generally never happens since Clang usually emits diagnostics in a healthy manner.
+            // libclang uses the status code to report things like internal programming errors or invalid arguments.
+            if (unitStatus != CXErrorCode.CXError_Success)
+            { throw new InvalidOperationException($"Failed to parse the Biohazrd evaluation index file due to a fatal Clang error {unitStatus}."); }
 
-                //-------------------------------------------------------------------------------------
-                // Separate the diagnostics
-                //-------------------------------------------------------------------------------------
-                List<TranslationDiagnostic> looseDiagnostics = new();
-                Dictionary<int, List<TranslationDiagnostic>> compilerDiagnostics = new();
-                foreach (CXDiagnostic diagnostic in UnitHandle.DiagnosticSet)
+            cancellationToken.ThrowIfCancellationRequested();
+
+            //-------------------------------------------------------------------------------------
+            // Separate the diagnostics
+            //-------------------------------------------------------------------------------------
+            // Diagnostics for each evaluation are bucketed by evaluation ID
+            List<TranslationDiagnostic>?[] evaluationDiagnostics = new List<TranslationDiagnostic>?[count];
+            int firstFatalEvaluationId = -1;
+            foreach (CXDiagnostic diagnostic in UnitHandle.DiagnosticSet)
+            {
+                // Figure out which evaluation this diagnostic belongs to using the presumed location
+                // (The presumed location is the one which is affected by #line directives.)
+                CXString presumedFile;
+                uint lineNumber;
+                uint columnNumber;
+                diagnostic.Location.GetPresumedLocation(out presumedFile, out lineNumber, out columnNumber);
+
+                string presumedFileString = presumedFile.ToString();
+
+                // Handle diagnostics that aren't from an evaluation, generally these are diagnostics from the indexed files.
+                // In theory these could be diagnostics after a macro uses a #line directive, but we don't really expect this to ever actually happen considering
+                // the #line directive doesn't have much real use outside of preprocessor output or very special generated output.
+                // These are reported once for the entire batch rather than being associated with every evaluation.
+                // (We don't need to worry about warnings from included files here because we instructed Clang to ignore them.)
+                if (!presumedFileString.StartsWith(evaluationPrefix))
                 {
-                    // Figure out which evaluation this diagnostic belongs to using the presumed location
-                    // (The presumed location is the one which is affected by #line directives.)
-                    CXString presumedFile;
-                    uint lineNumber;
-                    uint columnNumber;
-                    diagnostic.Location.GetPresumedLocation(out presumedFile, out lineNumber, out columnNumber);
-
-                    string presumedFileString = presumedFile.ToString();
-
-                    // Handle diagnostics that aren't from an evaluation, generally these are diagnostics from the indexed files.
-                    // In theory these could be diagnostics after a macro uses a #line directive, but we don't really expect this to ever actually happen considering
-                    // the #line directive doesn't have much real use outside of preprocessor output or very special generated output.
-                    if (!presumedFileString.StartsWith(evaluationPrefix))
-                    {
-                        //TODO: Decide on a better way to handle this.
-                        // Currently we just associate any diagnostics with every single evaluation.
-                        // (We don't need to worry about warnings from included files here because we instructed Clang to ignore them.)
-                        looseDiagnostics.Add(new TranslationDiagnostic(diagnostic));
-                        continue;
-                    }
+                    batchDiagnostics.Add(new TranslationDiagnostic(diagnostic));
+                    continue;
+                }
 
-                    int evaluationId = Int32.Parse(presumedFileString.AsSpan().Slice(evaluationPrefix.Length));
+                int evaluationId = Int32.Parse(presumedFileString.AsSpan().Slice(evaluationPrefix.Length));
 
-                    // This really shouldn't even happen unless someone's being intentionally malicious.
-                    if (evaluationId < 0 || evaluationId >= expressions.Count)
-                    { throw new InvalidOperationException($"The evaluation index is malformed. Unknown evlauation id: {evaluationId}"); }
+                // This really shouldn't even happen unless someone's being intentionally malicious.
+                if (evaluationId < 0 || evaluationId >= count)
+                { throw new InvalidOperationException($"The evaluation index is malformed. Unknown evlauation id: {evaluationId}"); }
 
-                    List<TranslationDiagnostic>? evaluationDiagnostics;
-                    if (!compilerDiagnostics.TryGetValue(evaluationId, out evaluationDiagnostics))
-                    {
-                        evaluationDiagnostics = new List<TranslationDiagnostic>();
-                        compilerDiagnostics.Add(evaluationId, evaluationDiagnostics);
-                    }
+                // Clang stops processing the evaluation index after a fatal error, so the evaluations after this one have to be retried
+                if (diagnostic.Severity == CXDiagnosticSeverity.CXDiagnostic_Fatal && (firstFatalEvaluationId == -1 || evaluationId < firstFatalEvaluationId))
+                { firstFatalEvaluationId = evaluationId; }
 
-                    TranslationDiagnostic evaluationDiagnostic = new
-                    (
-                        new SourceLocation($"Evaluation of `{expressions[evaluationId]}`", checked((int)lineNumber), checked((int)columnNumber)),
-                        diagnostic
-                    );
-                    evaluationDiagnostics.Add(evaluationDiagnostic);
+                TranslationDiagnostic evaluationDiagnostic = new
+                (
+                    new SourceLocation(GetEvaluationSourceFileName(expressions[start + evaluationId]), checked((int)lineNumber), checked((int)columnNumber)),
+                    diagnostic
+                );
+                (evaluationDiagnostics[evaluationId] ??= new List<TranslationDiagnostic>()).Add(evaluationDiagnostic);
+            }
+
+            int evaluatedCount = firstFatalEvaluationId == -1 ? count : firstFatalEvaluationId + 1;
+
+            //-------------------------------------------------------------------------------------
+            // Enumerate the expression cursors
+            //-------------------------------------------------------------------------------------
+            // Chunks are bounded, but they might still be too large for the stack so we rent from the pool in that case.
+            int maxOnStack = 1024 / sizeof(CXCursor);
+            CXCursor[]? rentedCursors = count <= maxOnStack ? null : ArrayPool<CXCursor>.Shared.Rent(count);
+            try
+            {
+                Span<CXCursor> cursors = rentedCursors is null ? stackalloc CXCursor[count] : rentedCursors.AsSpan(0, count);
+
+                // Clear all of the cursors (We have to do this because default(CXCursor) != CXCursor.Null)
+                // (Also we don't want to rely on locals being initialized to 0 for the stackalloc case.)
+                cursors.Fill(CXCursor.Null);
+
+                fixed (CXCursor* cursorsPointer = cursors)
+                {
+                    (IntPtr, int) clientData = ((IntPtr)cursorsPointer, count);
+                    delegate* unmanaged[Cdecl]<CXCursor, CXCursor, (IntPtr, int)*, CXChildVisitResult> enumeratorPtr = &Enumerator;
+                    clang.visitChildren(UnitHandle.Cursor, (IntPtr)enumeratorPtr, &clientData);
                 }
 
-                //-------------------------------------------------------------------------------------
-                // Enumerate the expression cursors
-                //-------------------------------------------------------------------------------------
-                int maxOnStack = 1024 / sizeof(CXCursor);
-                Span<CXCursor> cursors = expressions.Count <= maxOnStack ? stackalloc CXCursor[expressions.Count] : GC.AllocateUninitializedArray<CXCursor>(expressions.Count, pinned: true);
+                [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) })]
+                static CXChildVisitResult Enumerator(CXCursor cursor, CXCursor parent, (IntPtr Cursors, int ExpressionCount)* clientData)
                 {
-                    // Clear all of the cursors (We have to do this because default(CXCursor) != CXCursor.Null)
-                    // (Also we don't want to rely on locals being initialized to 0 for the stackalloc case.)
+                    // Skip cursors not from the main file
+                    if (!cursor.Location.IsFromMainFile)
+                    { return CXChildVisitResult.CXChildVisit_Continue; }
+
+                    // Skip cursors which are not globals
+                    if (cursor.Kind != CXCursorKind.CXCursor_VarDecl)
+                    { return CXChildVisitResult.CXChildVisit_Continue; }
+
+                    // Skip variables which are not one of our expression evaluators
+                    string name = cursor.Spelling.ToString();
+                    if (!name.StartsWith(evaluationPrefix))
+                    { return CXChildVisitResult.CXChildVisit_Continue; }
+
+                    // Determine which expression evaluator this is
+                    int expressionId;
+                    if (!Int32.TryParse(name.AsSpan().Slice(evaluationPrefix.Length), out expressionId))
                     {
-                        CXCursor nullCursor = CXCursor.Null;
-                        for (int i = 0; i < expressions.Count; i++)
-                        { cursors[i] = nullCursor; }
+                        Debug.Assert(false, "Parsing the ID portion of an expression evaluator variable's name should always succeed.");
+                        return CXChildVisitResult.CXChildVisit_Continue;
                     }
 
-                    (IntPtr, int) clientData = ((IntPtr)Unsafe.AsPointer(ref cursors[0]), expressions.Count);
-                    delegate* unmanaged[Cdecl]<CXCursor, CXCursor, (IntPtr, int) *, CXChildVisitResult> enumeratorPtr = &Enumerator;
-                    clang.visitChildren(UnitHandle.Cursor, (IntPtr)enumeratorPtr, &clientData);
-
-                    [UnmanagedCallersOnly(CallConvs = new[] { typeof(CallConvCdecl) })]
-                    static CXChildVisitResult Enumerator(CXCursor cursor, CXCursor parent, (IntPtr Cursors, int ExpressionCount)* clientData)
+                    // Skip if the expression ID is out of bounds
+                    if (expressionId < 0 || expressionId >= clientData->ExpressionCount)
                     {
-                        // Skip cursors not from the main file
-                        if (!cursor.Location.IsFromMainFile)
-                        { return CXChildVisitResult.CXChildVisit_Continue; }
-
-                        // Skip cursors which are not globals
-                        if (cursor.Kind != CXCursorKind.CXCursor_VarDecl)
-                        { return CXChildVisitResult.CXChildVisit_Continue; }
-
-                        // Skip variables which are not one of our expression evaluators
-                        string name = cursor.Spelling.ToString();
-                        if (!name.StartsWith(evaluationPrefix))
-                        { return CXChildVisitResult.CXChildVisit_Continue; }
-
-                        // Determine which expression evaluator this is
-                        int expressionId;
-                        if (!Int32.TryParse(name.AsSpan().Slice(evaluationPrefix.Length), out expressionId))
-                        {
-                            Debug.Assert(false, "Parsing the ID portion of an expression evaluator variable's name should always succeed.");
-                            return CXChildVisitResult.CXChildVisit_Continue;
-                        }
-
-                        // Skip if the expression ID is out of bounds
-                        if (expressionId < 0 || expressionId >= clientData->ExpressionCount)
-                        {
-                            Debug.Assert(false, "The expression ID should never be invalid.");
-                            return CXChildVisitResult.CXChildVisit_Continue;
-                        }
-
-                        // Save the cursor
-                        CXCursor* cursors = (CXCursor*)clientData->Cursors;
-                        Debug.Assert(cursors[expressionId].IsNull, "An expression ID should never appear more than once.");
-                        cursors[expressionId] = cursor;
+                        Debug.Assert(false, "The expression ID should never be invalid.");
                         return CXChildVisitResult.CXChildVisit_Continue;
                     }
+
+                    // Save the cursor
+                    CXCursor* cursors = (CXCursor*)clientData->Cursors;
+                    Debug.Assert(cursors[expressionId].IsNull, "An expression ID should never appear more than once.");
+                    cursors[expressionId] = cursor;
+                    return CXChildVisitResult.CXChildVisit_Continue;
                 }
 
                 //-------------------------------------------------------------------------------------
                 // Evaluate the constants and tabulate the results
                 //-------------------------------------------------------------------------------------
-                ImmutableArray<ConstantEvaluationResult>.Builder results = ImmutableArray.CreateBuilder<ConstantEvaluationResult>(expressions.Count);
-                for (int i = 0; i < expressions.Count; i++)
+                for (int i = 0; i < evaluatedCount; i++)
                 {
-                    string expression = expressions[i];
+                    cancellationToken.ThrowIfCancellationRequested();
+                    string expression = expressions[start + i];
                     ConstantValue? value = null;
-                    ImmutableArray<TranslationDiagnostic> diagnostics = ImmutableArray<TranslationDiagnostic>.Empty;
+                    List<TranslationDiagnostic>? diagnostics = evaluationDiagnostics[i];
                     CXCursor cursor = cursors[i];
 
-                    if (compilerDiagnostics.TryGetValue(i, out List<TranslationDiagnostic>? expressionCompilerDiagnostics))
-                    { diagnostics = diagnostics.AddRange(expressionCompilerDiagnostics); }
-
                     if (cursor.IsNull)
-                    { diagnostics = diagnostics.Add(new TranslationDiagnostic(Severity.Error, "Expression did not appear in the compiler cursor tree.")); }
+                    { (diagnostics ??= new()).Add(new TranslationDiagnostic(Severity.Error, "Expression did not appear in the compiler cursor tree.")); }
                     else
                     {
                         TranslationDiagnostic? evaluationDiagnostic;
                         value = cursor.TryComputeConstantValue(out evaluationDiagnostic);
 
                         if (evaluationDiagnostic.HasValue)
-                        { diagnostics = diagnostics.Add(evaluationDiagnostic.Value); }
+                        { (diagnostics ??= new()).Add(evaluationDiagnostic.Value); }
                     }
 
-                    results.Add(new ConstantEvaluationResult(expression, value, diagnostics));
+                    results.Add(new ConstantEvaluationResult(expression, value, diagnostics is null ? ImmutableArray<TranslationDiagnostic>.Empty : diagnostics.ToImmutableArray()));
                 }
-
-                return results.MoveToImmutable();
             }
+            finally
+            {
+                if (rentedCursors is not null)
+                { ArrayPool<CXCursor>.Shared.Return(rentedCursors); }
+            }
+
+            // Ensure the evaluation file is valid until we're done with the translation unit
+            GC.KeepAlive(evaluationIndexFile);
+            return evaluatedCount;
         }
 
         private void CheckDisposed()
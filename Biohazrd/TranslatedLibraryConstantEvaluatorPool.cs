@@ -0,0 +1,243 @@
+﻿using Biohazrd.Expressions;
+using System;
+using System.Collections.Generic;
+using System.Collections.Immutable;
+using System.Diagnostics;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace Biohazrd
+{
+    /// <summary>A pool of <see cref="TranslatedLibraryConstantEvaluator"/>s used to evaluate large batches of expressions concurrently.</summary>
+    /// <remarks>
+    /// A single <see cref="TranslatedLibraryConstantEvaluator"/> owns a single Clang translation unit, so evaluations against it are serialized.
+    /// This pool owns several evaluators and shards each batch across them, merging the results back together in input order.
+    ///
+    /// Note that batches are split into contiguous shards, so an expression is only evaluated alongside its neighbors rather than the entire batch.
+    /// This is generally only observable when the batch contains broken expressions which affect the evaluation of subsequent ones.
+    /// </remarks>
+    public sealed class TranslatedLibraryConstantEvaluatorPool : IDisposable
+    {
+        private readonly ImmutableArray<TranslatedLibraryConstantEvaluator> Evaluators;
+        private readonly ConstantEvaluationCache? Cache;
+
+        /// <summary>The number of evaluators in this pool, which is the maximum number of concurrent evaluations.</summary>
+        public int DegreeOfParallelism => Evaluators.Length;
+
+        /// <summary>The minimum number of expressions assigned to each evaluator when a batch is sharded.</summary>
+        /// <remarks>Every evaluation has a fixed overhead from reparsing the evaluation translation unit, so it isn't worth sharding small batches across every evaluator.</remarks>
+        public int MinimumShardSize { get; set; } = 64;
+
+        internal TranslatedLibraryConstantEvaluatorPool(int degreeOfParallelism, Func<TranslatedLibraryConstantEvaluator> createEvaluator, ConstantEvaluationCache? cache = null)
+        {
+            Cache = cache;
+
+            if (degreeOfParallelism < 1)
+            { throw new ArgumentOutOfRangeException(nameof(degreeOfParallelism)); }
+
+            TranslatedLibraryConstantEvaluator[] evaluators = new TranslatedLibraryConstantEvaluator[degreeOfParallelism];
+
+            try
+            {
+                // Creating an evaluator involves parsing the entire library, so we create them concurrently
+                Parallel.For(0, evaluators.Length, i => evaluators[i] = createEvaluator());
+            }
+            catch
+            {
+                foreach (TranslatedLibraryConstantEvaluator? evaluator in evaluators)
+                { evaluator?.Dispose(); }
+
+                throw;
+            }
+
+            Evaluators = evaluators.ToImmutableArray();
+        }
+
+        public ConstantEvaluationBatchResult EvaluateBatch
+        (
+            IEnumerable<TranslatedMacro> macros,
+            CancellationToken cancellationToken = default,
+            IProgress<TranslationProgress>? progress = null
+        )
+        {
+            ImmutableArray<ConstantEvaluationResult> results = EvaluateBatch(macros, out ImmutableArray<TranslationDiagnostic> batchDiagnostics, cancellationToken, progress);
+            return new ConstantEvaluationBatchResult(results, batchDiagnostics);
+        }
+
+        public ImmutableArray<ConstantEvaluationResult> EvaluateBatch
+        (
+            IEnumerable<TranslatedMacro> macros,
+            out ImmutableArray<TranslationDiagnostic> batchDiagnostics,
+            CancellationToken cancellationToken = default,
+            IProgress<TranslationProgress>? progress = null
+        )
+            => EvaluateBatch(TranslatedLibraryConstantEvaluator.GetMacroExpressions(macros), out batchDiagnostics, cancellationToken, progress);
+
+        public ConstantEvaluationBatchResult EvaluateBatch
+        (
+            IReadOnlyList<string> expressions,
+            CancellationToken cancellationToken = default,
+            IProgress<TranslationProgress>? progress = null
+        )
+        {
+            ImmutableArray<ConstantEvaluationResult> results = EvaluateBatch(expressions, out ImmutableArray<TranslationDiagnostic> batchDiagnostics, cancellationToken, progress);
+            return new ConstantEvaluationBatchResult(results, batchDiagnostics);
+        }
+
+        /// <summary>Evaluates a batch of expressions, sharding them across the evaluators in this pool.</summary>
+        /// <param name="batchDiagnostics">Receives the unique diagnostics which aren't associated with any particular evaluation from all shards.</param>
+        /// <returns>The results of the evaluations, in the same order as <paramref name="expressions"/>.</returns>
+        public ImmutableArray<ConstantEvaluationResult> EvaluateBatch
+        (
+            IReadOnlyList<string> expressions,
+            out ImmutableArray<TranslationDiagnostic> batchDiagnostics,
+            CancellationToken cancellationToken = default,
+            IProgress<TranslationProgress>? progress = null
+        )
+        {
+            CheckDisposed();
+            return Cache is null
+                ? EvaluateBatchCore(expressions, out batchDiagnostics, cancellationToken, progress)
+                : Cache.EvaluateBatch(expressions, out batchDiagnostics, EvaluateBatchCore, cancellationToken, progress);
+        }
+
+        /// <summary>Evaluates a batch of expressions from a dedicated background thread, sharding them across the evaluators in this pool as usual.</summary>
+        /// <remarks>
+        /// The evaluators use their own translation units, so it's safe to continue processing (and transforming) the corresponding <see cref="TranslatedLibrary"/> while the evaluation runs.
+        /// </remarks>
+        public Task<ConstantEvaluationBatchResult> EvaluateBatchAsync
+        (
+            IReadOnlyList<string> expressions,
+            CancellationToken cancellationToken = default,
+            IProgress<TranslationProgress>? progress = null
+        )
+        {
+            CheckDisposed();
+
+            // Reparsing takes a long time and blocks the entire time, so we don't want to tie up a thread pool thread with it
+            return Task.Factory.StartNew
+            (
+                () => EvaluateBatch(expressions, cancellationToken, progress),
+                cancellationToken,
+                TaskCreationOptions.LongRunning,
+                TaskScheduler.Default
+            );
+        }
+
+        /// <inheritdoc cref="EvaluateBatchAsync(IReadOnlyList{string}, CancellationToken, IProgress{TranslationProgress}?)"/>
+        public Task<ConstantEvaluationBatchResult> EvaluateBatchAsync
+        (
+            IEnumerable<TranslatedMacro> macros,
+            CancellationToken cancellationToken = default,
+            IProgress<TranslationProgress>? progress = null
+        )
+            // The macros are converted to expressions eagerly so that invalid macros are reported to the caller immediately
+            => EvaluateBatchAsync(TranslatedLibraryConstantEvaluator.GetMacroExpressions(macros), cancellationToken, progress);
+
+        private ImmutableArray<ConstantEvaluationResult> EvaluateBatchCore
+        (
+            IReadOnlyList<string> expressions,
+            out ImmutableArray<TranslationDiagnostic> batchDiagnostics,
+            CancellationToken cancellationToken,
+            IProgress<TranslationProgress>? progress
+        )
+        {
+            int shardCount = Math.Clamp(expressions.Count / Math.Max(1, MinimumShardSize), 1, Evaluators.Length);
+
+            // Don't bother with the parallel machinery when there's only one shard
+            if (shardCount == 1)
+            { return Evaluators[0].EvaluateBatch(expressions, out batchDiagnostics, cancellationToken, progress); }
+
+            int shardSize = (expressions.Count + shardCount - 1) / shardCount;
+            ImmutableArray<ConstantEvaluationResult>[] shardResults = new ImmutableArray<ConstantEvaluationResult>[shardCount];
+            ImmutableArray<TranslationDiagnostic>[] shardDiagnostics = new ImmutableArray<TranslationDiagnostic>[shardCount];
+            BatchProgress? batchProgress = progress is null ? null : new BatchProgress(progress, expressions.Count);
+
+            ParallelOptions parallelOptions = new()
+            {
+                CancellationToken = cancellationToken,
+                MaxDegreeOfParallelism = shardCount
+            };
+
+            Parallel.For(0, shardCount, parallelOptions, shardIndex =>
+            {
+                int start = shardIndex * shardSize;
+                int count = Math.Min(shardSize, expressions.Count - start);
+
+                string[] shard = new string[count];
+                for (int i = 0; i < count; i++)
+                { shard[i] = expressions[start + i]; }
+
+                shardResults[shardIndex] = Evaluators[shardIndex].EvaluateBatch(shard, out shardDiagnostics[shardIndex], cancellationToken, batchProgress?.CreateShardProgress());
+            });
+
+            // Merge the results back together in input order
+            ImmutableArray<ConstantEvaluationResult>.Builder results = ImmutableArray.CreateBuilder<ConstantEvaluationResult>(expressions.Count);
+            foreach (ImmutableArray<ConstantEvaluationResult> shardResult in shardResults)
+            { results.AddRange(shardResult); }
+
+            // Every shard sees the same library headers, so their batch diagnostics are mostly duplicates of each other
+            TranslatedLibraryConstantEvaluator.BatchDiagnosticsBuilder diagnostics = new();
+            foreach (ImmutableArray<TranslationDiagnostic> shardDiagnostic in shardDiagnostics)
+            { diagnostics.AddRange(shardDiagnostic); }
+            batchDiagnostics = diagnostics.ToImmutable();
+
+            Debug.Assert(results.Count == expressions.Count);
+            return results.MoveToImmutable();
+        }
+
+        /// <summary>Aggregates the progress reported by each shard into progress for the entire batch.</summary>
+        private sealed class BatchProgress
+        {
+            private readonly IProgress<TranslationProgress> Progress;
+            private readonly int Total;
+            private int Completed;
+
+            public BatchProgress(IProgress<TranslationProgress> progress, int total)
+            {
+                Progress = progress;
+                Total = total;
+            }
+
+            private void Add(int count)
+                => Progress.Report(new TranslationProgress(Interlocked.Add(ref Completed, count), Total));
+
+            public IProgress<TranslationProgress> CreateShardProgress()
+                => new ShardProgress(this);
+
+            private sealed class ShardProgress : IProgress<TranslationProgress>
+            {
+                private readonly BatchProgress BatchProgress;
+                private int PreviousCompleted;
+
+                public ShardProgress(BatchProgress batchProgress)
+                    => BatchProgress = batchProgress;
+
+                // Each shard is only evaluated by a single thread, so we don't need to synchronize access to PreviousCompleted
+                public void Report(TranslationProgress value)
+                {
+                    int newlyCompleted = value.Completed - PreviousCompleted;
+                    PreviousCompleted = value.Completed;
+                    BatchProgress.Add(newlyCompleted);
+                }
+            }
+        }
+
+        private void CheckDisposed()
+        {
+            if (Disposed)
+            { throw new ObjectDisposedException(nameof(TranslatedLibraryConstantEvaluatorPool)); }
+        }
+
+        private bool Disposed = false;
+        public void Dispose()
+        {
+            CheckDisposed();
+
+            foreach (TranslatedLibraryConstantEvaluator evaluator in Evaluators)
+            { evaluator.Dispose(); }
+
+            Disposed = true;
+        }
+    }
+}
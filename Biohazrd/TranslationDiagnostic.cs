@@ -14,10 +14,14 @@ namespace Biohazrd
         public bool IsError => Severity == Severity.Error || Severity == Severity.Fatal;
 
         internal TranslationDiagnostic(SourceLocation location, Severity severity, string message)
+            : this(location, severity, isFromClang: false, message)
+        { }
+
+        internal TranslationDiagnostic(SourceLocation location, Severity severity, bool isFromClang, string message)
         {
             Location = location;
             Severity = severity;
-            IsFromClang = false;
+            IsFromClang = isFromClang;
             Message = message;
         }
 
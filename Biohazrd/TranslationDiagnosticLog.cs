@@ -0,0 +1,108 @@
+﻿using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Collections.Immutable;
+
+namespace Biohazrd
+{
+    /// <summary>An immutable log of diagnostics keyed by <see cref="DeclarationId"/>.</summary>
+    /// <remarks>
+    /// When a <see cref="TranslatedLibrary"/> has a <see cref="TranslatedLibrary.DiagnosticLog"/>, transformations may record diagnostics in it instead of
+    /// appending them to <see cref="TranslatedDeclaration.Diagnostics"/>. This avoids cloning the declaration (and rebuilding the spine of the declaration tree leading to it)
+    /// when a transformation would otherwise not modify the declaration.
+    ///
+    /// Like the rest of <see cref="TranslatedLibrary"/>, this log is immutable. Adding diagnostics produces a new log which shares its unmodified entries with the old one,
+    /// so libraries which branch from a common library never see each other's diagnostics.
+    ///
+    /// Use <see cref="TranslatedLibrary.GetDiagnostics(TranslatedDeclaration)"/> to get a view of all diagnostics associated with a declaration.
+    /// </remarks>
+    public sealed class TranslationDiagnosticLog
+    {
+        public static readonly TranslationDiagnosticLog Empty = new(ImmutableDictionary<DeclarationId, ImmutableArray<TranslationDiagnostic>>.Empty);
+
+        private readonly ImmutableDictionary<DeclarationId, ImmutableArray<TranslationDiagnostic>> Diagnostics;
+
+        /// <summary>The number of declarations which have diagnostics in this log.</summary>
+        public int DeclarationCount => Diagnostics.Count;
+
+        private TranslationDiagnosticLog(ImmutableDictionary<DeclarationId, ImmutableArray<TranslationDiagnostic>> diagnostics)
+            => Diagnostics = diagnostics;
+
+        /// <summary>Returns a new log with the specified diagnostic added for the specified declaration.</summary>
+        public TranslationDiagnosticLog Add(DeclarationId id, TranslationDiagnostic diagnostic)
+            => AddRange(id, ImmutableArray.Create(diagnostic));
+
+        /// <summary>Returns a new log with the specified diagnostics added for the specified declaration.</summary>
+        public TranslationDiagnosticLog AddRange(DeclarationId id, ImmutableArray<TranslationDiagnostic> diagnostics)
+        {
+            if (diagnostics.IsDefaultOrEmpty)
+            { return this; }
+
+            if (Diagnostics.TryGetValue(id, out ImmutableArray<TranslationDiagnostic> existing))
+            { diagnostics = existing.AddRange(diagnostics); }
+
+            return new TranslationDiagnosticLog(Diagnostics.SetItem(id, diagnostics));
+        }
+
+        /// <summary>Gets the diagnostics logged for the specified declaration in the order they were logged.</summary>
+        public ImmutableArray<TranslationDiagnostic> Get(DeclarationId id)
+            => Diagnostics.TryGetValue(id, out ImmutableArray<TranslationDiagnostic> diagnostics) ? diagnostics : ImmutableArray<TranslationDiagnostic>.Empty;
+
+        /// <summary>Creates a builder which can be used to efficiently record many diagnostics on top of this log.</summary>
+        public Builder ToBuilder()
+            => new Builder(this);
+
+        /// <summary>A thread-safe builder used to record many diagnostics before producing a new <see cref="TranslationDiagnosticLog"/>.</summary>
+        /// <remarks>The log the builder was created from is never modified.</remarks>
+        public sealed class Builder
+        {
+            private readonly TranslationDiagnosticLog Original;
+            private readonly ConcurrentDictionary<DeclarationId, ImmutableArray<TranslationDiagnostic>> NewDiagnostics = new();
+
+            /// <summary>True if any diagnostics have been added to this builder.</summary>
+            public bool HasChanges => !NewDiagnostics.IsEmpty;
+
+            internal Builder(TranslationDiagnosticLog original)
+                => Original = original;
+
+            public void Add(DeclarationId id, TranslationDiagnostic diagnostic)
+                => NewDiagnostics.AddOrUpdate(id, (_, diagnostic) => ImmutableArray.Create(diagnostic), (_, existing, diagnostic) => existing.Add(diagnostic), diagnostic);
+
+            public void AddRange(DeclarationId id, ImmutableArray<TranslationDiagnostic> diagnostics)
+            {
+                if (diagnostics.IsDefaultOrEmpty)
+                { return; }
+
+                NewDiagnostics.AddOrUpdate(id, (_, diagnostics) => diagnostics, (_, existing, diagnostics) => existing.AddRange(diagnostics), diagnostics);
+            }
+
+            /// <summary>Gets all diagnostics for the specified declaration, including those in the original log.</summary>
+            public ImmutableArray<TranslationDiagnostic> Get(DeclarationId id)
+            {
+                ImmutableArray<TranslationDiagnostic> originalDiagnostics = Original.Get(id);
+
+                if (!NewDiagnostics.TryGetValue(id, out ImmutableArray<TranslationDiagnostic> newDiagnostics))
+                { return originalDiagnostics; }
+
+                return originalDiagnostics.IsEmpty ? newDiagnostics : originalDiagnostics.AddRange(newDiagnostics);
+            }
+
+            /// <summary>Creates a new log containing the original log's diagnostics followed by the diagnostics added to this builder.</summary>
+            public TranslationDiagnosticLog ToImmutable()
+            {
+                if (NewDiagnostics.IsEmpty)
+                { return Original; }
+
+                ImmutableDictionary<DeclarationId, ImmutableArray<TranslationDiagnostic>>.Builder builder = Original.Diagnostics.ToBuilder();
+                foreach (KeyValuePair<DeclarationId, ImmutableArray<TranslationDiagnostic>> entry in NewDiagnostics)
+                {
+                    if (builder.TryGetValue(entry.Key, out ImmutableArray<TranslationDiagnostic> existing))
+                    { builder[entry.Key] = existing.AddRange(entry.Value); }
+                    else
+                    { builder.Add(entry.Key, entry.Value); }
+                }
+
+                return new TranslationDiagnosticLog(builder.ToImmutable());
+            }
+        }
+    }
+}
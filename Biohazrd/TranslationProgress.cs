@@ -0,0 +1,36 @@
+﻿using System;
+
+namespace Biohazrd
+{
+    /// <summary>Describes how far along a long-running operation (such as parsing, transforming, or emitting a library) is.</summary>
+    /// <remarks>
+    /// <see cref="Completed"/> and <see cref="Total"/> are measured in the natural unit of the operation reporting progress.
+    /// For the parser, transformations, and the C# generator this is top-level declarations. For the constant evaluator it is expressions.
+    /// </remarks>
+    public readonly struct TranslationProgress
+    {
+        /// <summary>The number of items which have been processed so far.</summary>
+        public int Completed { get; }
+
+        /// <summary>The total number of items the operation will process.</summary>
+        public int Total { get; }
+
+        /// <summary>The fraction of the operation which has been completed, from 0 to 1.</summary>
+        public double Fraction => Total == 0 ? 1.0 : (double)Completed / Total;
+
+        public TranslationProgress(int completed, int total)
+        {
+            if (total < 0)
+            { throw new ArgumentOutOfRangeException(nameof(total)); }
+
+            if (completed < 0 || completed > total)
+            { throw new ArgumentOutOfRangeException(nameof(completed)); }
+
+            Completed = completed;
+            Total = total;
+        }
+
+        public override string ToString()
+            => $"{Completed}/{Total}";
+    }
+}
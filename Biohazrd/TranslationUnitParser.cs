@@ -9,6 +9,8 @@ using System.IO;
 using System.Linq;
 using System.Runtime.CompilerServices;
 using System.Runtime.InteropServices;
+using System.Text;
+using System.Threading;
 using static Biohazrd.TranslationUnitParser.CreateDeclarationsEnumerator;
 using ClangType = ClangSharp.Type;
 
@@ -35,10 +37,22 @@ namespace Biohazrd
 
         private readonly bool ParsingComplete = false;
 
-        internal TranslationUnitParser(List<SourceFileInternal> sourceFiles, TranslationOptions options, TranslationUnit translationUnit)
+        private readonly CancellationToken CancellationToken;
+        private readonly IProgress<TranslationProgress>? Progress;
+
+        internal TranslationUnitParser
+        (
+            List<SourceFileInternal> sourceFiles,
+            TranslationOptions options,
+            TranslationUnit translationUnit,
+            CancellationToken cancellationToken = default,
+            IProgress<TranslationProgress>? progress = null
+        )
         {
             TranslationUnit = translationUnit;
             Options = options;
+            CancellationToken = cancellationToken;
+            Progress = progress;
 
             // We treat file paths are case-insensitive (see https://github.com/InfectedLibraries/Biohazrd/issues/1)
             // This is technically only valid on case-insensitive file systems, but in practice it's uncommon for two files to have the same case-insensitive name even on systems which support it.
@@ -58,6 +72,7 @@ namespace Biohazrd
 
             // Process the translation unit
             ProcessTranslationUnit();
+            CancellationToken.ThrowIfCancellationRequested();
 
             // Process macros
             unsafe
@@ -120,8 +135,13 @@ namespace Biohazrd
             { return; }
 
             // Process cursors
-            foreach (Cursor cursor in TranslationUnit.TranslationUnitDecl.CursorChildren)
-            { ProcessCursor(cursor); }
+            IReadOnlyList<Cursor> cursors = TranslationUnit.TranslationUnitDecl.CursorChildren;
+            for (int i = 0; i < cursors.Count; i++)
+            {
+                CancellationToken.ThrowIfCancellationRequested();
+                ProcessCursor(cursors[i]);
+                Progress?.Report(new TranslationProgress(i + 1, cursors.Count));
+            }
         }
 
         private TranslatedFile GetTranslatedFile(CXFile clangFile)
@@ -252,6 +272,7 @@ namespace Biohazrd
                         case CX_AttrKind.CX_AttrKind_DLLImport:
                         case CX_AttrKind.CX_AttrKind_MSNoVTable:
                         case CX_AttrKind.CX_AttrKind_Uuid:
+                        case CX_AttrKind.CX_AttrKind_Final: // Handled by TranslatedRecord and TranslatedFunction
                         //TODO: Alignment could impact the translation if types are allocated client-side.
                         case CX_AttrKind.CX_AttrKind_Aligned:
                             return None;
@@ -459,7 +480,60 @@ namespace Biohazrd
             if (!isSynthesized && !Options.IncludeMacrosDefinedOutOfScope && !file.WasInScope)
             { return; }
 
-            MacrosBuilder.Add(new TranslatedMacro(file, macroInfo));
+            string? replacementText = isSynthesized || macroInfo->WasUndefined ? null : GetMacroReplacementText(macroInfo, fileHandle);
+            MacrosBuilder.Add(new TranslatedMacro(file, macroInfo, replacementText));
+        }
+
+        /// <summary>Extracts the raw text of a macro's replacement list from the source file it was defined in.</summary>
+        /// <remarks>The macro's location refers to its name, so we skip the name and parameter list and read until the end of the (possibly continued) line.</remarks>
+        private unsafe string? GetMacroReplacementText(PathogenMacroInformation* macroInfo, CXFile fileHandle)
+        {
+            macroInfo->Location.GetFileLocation(out _, out _, out _, out uint offset);
+
+            nuint fileSize;
+            sbyte* fileContents = clang.getFileContents(TranslationUnit.Handle, fileHandle, &fileSize);
+
+            if (fileContents is null || offset >= fileSize)
+            { return null; }
+
+            ReadOnlySpan<byte> text = new ReadOnlySpan<byte>(fileContents, checked((int)fileSize)).Slice((int)offset);
+
+            // Skip the macro's name
+            int i = 0;
+            while (i < text.Length && (text[i] == '_' || Char.IsLetterOrDigit((char)text[i])))
+            { i++; }
+
+            // Skip the parameter list
+            if (macroInfo->IsFunctionLike)
+            {
+                if (i >= text.Length || text[i] != '(')
+                { return null; }
+
+                int parameterListEnd = text.Slice(i).IndexOf((byte)')');
+                if (parameterListEnd < 0)
+                { return null; }
+
+                i += parameterListEnd + 1;
+            }
+
+            // Read until the end of the line, allowing for line continuations
+            int start = i;
+            for (; i < text.Length; i++)
+            {
+                if (text[i] != '\n')
+                { continue; }
+
+                // Find the last non-carriage return character before the newline to see if it's a continuation
+                int j = i - 1;
+                if (j >= start && text[j] == '\r')
+                { j--; }
+
+                if (j < start || text[j] != '\\')
+                { break; }
+            }
+
+            string replacementText = Encoding.UTF8.GetString(text.Slice(start, i - start));
+            return replacementText.Replace("\\\r\n", " ").Replace("\\\n", " ").Trim();
         }
 
         private bool ResultsFetched = false;
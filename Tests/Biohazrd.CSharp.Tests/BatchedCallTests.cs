@@ -0,0 +1,116 @@
+﻿using Biohazrd.CSharp.Metadata;
+using Biohazrd.Tests.Common;
+using Biohazrd.Transformation;
+using System.Linq;
+using Xunit;
+
+namespace Biohazrd.CSharp.Tests
+{
+    public sealed class BatchedCallTests : BiohazrdTestBase
+    {
+        private sealed class MarkBatchableTransformation : TransformationBase
+        {
+            protected override TransformationResult TransformFunction(TransformationContext context, TranslatedFunction declaration)
+                => declaration.Name == "Unmarked" ? declaration : declaration with { Metadata = declaration.Metadata.Add<BatchableFunction>() };
+        }
+
+        private TranslatedLibrary CreateTransformedLibrary()
+        {
+            TranslatedLibrary library = CreateLibrary
+            (@"
+class Vector
+{
+public:
+    float Dot(const Vector& other);
+    Vector();
+};
+
+int Add(int a, int b);
+int Scale(int count, int results);
+void Touch(int* pointer);
+void NothingToBatch();
+int Unmarked(int value);
+void Overloaded(int* pointer);
+void Overloaded(float* pointer);
+void Overloaded(int value);
+"
+            );
+
+            library = new MarkBatchableTransformation().Transform(library);
+            library = new CSharpTypeReductionTransformation().Transform(library);
+            library = new MoveLooseDeclarationsIntoTypesTransformation().Transform(library);
+            return library;
+        }
+
+        private string GenerateCSharp()
+        {
+            TranslatedLibrary library = new CSharpTranslationVerifier().Transform(CreateTransformedLibrary());
+            InMemoryOutput output = GenerateInMemory(session => CSharpLibraryGenerator.Generate(new CSharpGenerationOptions() { DumpClangInfo = false }, session, library, LibraryTranslationMode.OneFile));
+            output.AssertCompiles();
+            return output.GetFile("TranslatedLibrary.cs");
+        }
+
+        [Fact]
+        public void VerifierWarnsAboutUnbatchableFunctions()
+        {
+            TranslatedLibrary library = new CSharpTranslationVerifier().Transform(CreateTransformedLibrary());
+            Assert.DoesNotContain(library.EnumerateRecursively().FindDeclaration<TranslatedFunction>("Add").Diagnostics, d => d.Message.Contains("batched"));
+            Assert.Contains(library.EnumerateRecursively().FindDeclaration<TranslatedFunction>("NothingToBatch").Diagnostics, d => d.Severity == Severity.Warning && d.Message.Contains("batched"));
+            Assert.Contains(library.EnumerateRecursively().FindDeclaration<TranslatedFunction>("Constructor").Diagnostics, d => d.Severity == Severity.Warning && d.Message.Contains("batched"));
+        }
+
+        [Fact]
+        public void BatchedOverloadsAreGenerated()
+        {
+            string code = GenerateCSharp();
+            Assert.Contains("static unsafe void Add(ReadOnlySpan<int> a, ReadOnlySpan<int> b, Span<int> results)", code);
+            Assert.Contains("EntryPoint = \"__batch_", code);
+            Assert.Contains("static unsafe void Touch(ReadOnlySpan<IntPtr> pointer)", code);
+            Assert.Contains("static unsafe void Dot(ReadOnlySpan<IntPtr> instances, ReadOnlySpan<IntPtr> other, Span<float> results)", code);
+            Assert.DoesNotContain("Unmarked(ReadOnlySpan", code);
+            Assert.DoesNotMatch("__batch_[A-Za-z0-9_]*NothingToBatch", code);
+        }
+
+        [Fact]
+        public void ConflictingOverloadsAreSkipped()
+        {
+            TranslatedLibrary library = new CSharpTranslationVerifier().Transform(CreateTransformedLibrary());
+            TranslatedFunction[] overloads = library.EnumerateRecursively().OfType<TranslatedFunction>().Where(f => f.Name == "Overloaded").ToArray();
+            Assert.Equal(3, overloads.Length);
+
+            foreach (TranslatedFunction overload in overloads)
+            {
+                bool isPointerOverload = overload.Parameters[0].Type is PointerTypeReference;
+                Assert.Equal(!isPointerOverload, overload.Metadata.Has<BatchableFunction>());
+                Assert.Equal(isPointerOverload, overload.Diagnostics.Any(d => d.Severity == Severity.Warning && d.Message.Contains("same signature")));
+            }
+
+            // The pointer overloads would both be batched as ReadOnlySpan<IntPtr>
+            string code = GenerateCSharp();
+            Assert.Contains("static unsafe void Overloaded(ReadOnlySpan<int> value)", code);
+            Assert.DoesNotContain("static unsafe void Overloaded(ReadOnlySpan<IntPtr> pointer)", code);
+        }
+
+        [Fact]
+        public void ParameterNamesDoNotConflictWithExtraSpans()
+        {
+            string code = GenerateCSharp();
+            Assert.Matches(@"static extern void __batch_\w*Scale\w*\(nuint _count, int\* count, int\* results, int\* _results\);", code);
+            Assert.Contains("static unsafe void Scale(ReadOnlySpan<int> count, ReadOnlySpan<int> results, Span<int> _results)", code);
+            Assert.Contains("int _count = count.Length;", code);
+        }
+
+        [Fact]
+        public void ShimsAreEmittedAndExported()
+        {
+            TranslatedLibrary library = CreateTransformedLibrary();
+
+            string inlineReferences = GenerateInMemory(session => InlineReferenceFileGenerator.Generate(session, "InlineReferences.cpp", library)).GetFile("InlineReferences.cpp");
+            Assert.Contains("extern \"C\" void __batch_", inlineReferences);
+            Assert.Contains("->Dot(", inlineReferences);
+
+            string moduleDefinition = GenerateInMemory(session => ModuleDefinitionGenerator.Generate(session, "Exports.def", library)).GetFile("Exports.def");
+            Assert.Contains("__batch_", moduleDefinition);
+        }
+    }
+}
@@ -0,0 +1,89 @@
+﻿using Biohazrd.OutputGeneration;
+using System;
+using System.IO;
+using Xunit;
+
+namespace Biohazrd.CSharp.Tests
+{
+    public sealed class CSharpCodeWriterTests
+    {
+        private static string WriteCode(Action<CSharpCodeWriter> write)
+        {
+            string outputDirectory = Path.Combine(Path.GetTempPath(), $"{nameof(CSharpCodeWriterTests)}_{Guid.NewGuid():N}");
+            try
+            {
+                string filePath;
+                using (OutputSession session = new() { BaseOutputDirectory = outputDirectory, GeneratedFileHeader = null })
+                {
+                    CSharpCodeWriter writer = session.Open<CSharpCodeWriter>("Test.cs");
+                    writer.NewLine = "\n";
+                    write(writer);
+                    writer.Finish();
+                    filePath = Path.Combine(outputDirectory, "Test.cs");
+                }
+
+                return File.ReadAllText(filePath).Replace("\r\n", "\n");
+            }
+            finally
+            {
+                if (Directory.Exists(outputDirectory))
+                { Directory.Delete(outputDirectory, recursive: true); }
+            }
+        }
+
+        private const string ExpectedHeader = "// <auto-generated>\n// </auto-generated>\n#nullable enable\n";
+
+        [Fact]
+        public void IndentsOnlyNonEmptyLines()
+        {
+            string code = WriteCode(writer =>
+            {
+                writer.WriteLine("struct Test");
+                using (writer.Block())
+                {
+                    writer.Write("int A;\n\nint B;\n");
+                    writer.Write("int ");
+                    writer.Write('C');
+                    writer.WriteLine(';');
+                }
+            });
+
+            Assert.Equal(ExpectedHeader + "struct Test\n{\n    int A;\n\n    int B;\n    int C;\n}\n", code);
+        }
+
+        [Fact]
+        public void PrefixAppliedToEveryLine()
+        {
+            string code = WriteCode(writer =>
+            {
+                using (writer.Indent())
+                using (writer.Prefix("// "))
+                { writer.Write("First\nSecond\n".AsSpan()); }
+            });
+
+            Assert.Equal(ExpectedHeader + "    // First\n    // Second\n", code);
+        }
+
+        [Fact]
+        public void LargeOutput()
+        {
+            const int lineCount = 100_000;
+            string code = WriteCode(writer =>
+            {
+                using (writer.Block())
+                {
+                    for (int i = 0; i < lineCount; i++)
+                    { writer.WriteLine($"public int Field{i};"); }
+                }
+            });
+
+            string[] lines = code.Substring(ExpectedHeader.Length).Split('\n');
+            Assert.Equal(lineCount + 3, lines.Length);
+            Assert.Equal("{", lines[0]);
+            Assert.Equal("    public int Field0;", lines[1]);
+            Assert.Equal($"    public int Field{lineCount - 1};", lines[lineCount]);
+            Assert.Equal("}", lines[lineCount + 1]);
+            Assert.Equal("", lines[lineCount + 2]);
+        }
+    }
+}
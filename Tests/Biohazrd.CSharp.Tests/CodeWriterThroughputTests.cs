@@ -0,0 +1,147 @@
+﻿using Biohazrd.OutputGeneration;
+using System;
+using System.Diagnostics;
+using System.IO;
+using Xunit;
+using Xunit.Abstractions;
+
+namespace Biohazrd.CSharp.Tests
+{
+    /// <summary>Measures the throughput of the code writers by generating a large synthetic file with each of them.</summary>
+    /// <remarks>
+    /// The measurements are reported through the test output rather than asserted on since they depend heavily on the machine running the tests.
+    /// These are benchmarks rather than tests, so they're skipped by default. Remove the skip locally to take measurements.
+    /// Only long-standing public writer APIs are used so that the same test can be run against older revisions for before/after comparisons.
+    /// </remarks>
+    public sealed class CodeWriterThroughputTests
+    {
+        private readonly ITestOutputHelper Output;
+
+        public CodeWriterThroughputTests(ITestOutputHelper output)
+            => Output = output;
+
+        private const int TypeCount = 20_000;
+        private const int MembersPerType = 10;
+        private const int IterationCount = 3;
+
+        private static void WriteSyntheticCSharp(CSharpCodeWriter writer)
+        {
+            writer.Using("System");
+            writer.Using("System.Runtime.InteropServices");
+
+            writer.WriteLine("namespace Synthetic");
+            using (writer.Block())
+            {
+                for (int i = 0; i < TypeCount; i++)
+                {
+                    writer.EnsureSeparation();
+                    writer.WriteLine("[StructLayout(LayoutKind.Explicit, Size = 80)]");
+                    writer.Write("public unsafe partial struct Type");
+                    writer.WriteLine(i.ToString());
+                    using (writer.Block())
+                    {
+                        for (int j = 0; j < MembersPerType; j++)
+                        {
+                            writer.Write("[FieldOffset(");
+                            writer.Write((j * 8).ToString());
+                            writer.Write(")] public ");
+                            writer.Write(j % 2 == 0 ? "int" : "void*");
+                            writer.Write(' ');
+                            writer.WriteIdentifier($"Field{j}");
+                            writer.WriteLine(';');
+                        }
+
+                        writer.EnsureSeparation();
+                        writer.WriteLine("[DllImport(\"Synthetic.dll\", CallingConvention = CallingConvention.Cdecl)]");
+                        writer.Write("public static extern int Method");
+                        writer.Write(i.ToString());
+                        writer.WriteLine("(Type0* @this, int a, int b);");
+                    }
+                }
+            }
+        }
+
+        private static void WriteSyntheticCpp(CppCodeWriter writer)
+        {
+            writer.Include("Synthetic.h");
+
+            for (int i = 0; i < TypeCount; i++)
+            {
+                writer.EnsureSeparation();
+                writer.Write("struct Type");
+                writer.WriteLine(i.ToString());
+                using (writer.Block())
+                {
+                    for (int j = 0; j < MembersPerType; j++)
+                    {
+                        writer.Write(j % 2 == 0 ? "int" : "void*");
+                        writer.Write(" Field");
+                        writer.Write(j.ToString());
+                        writer.WriteLine(';');
+                    }
+                }
+                writer.WriteLine(';');
+
+                writer.EnsureSeparation();
+                writer.Write("extern \"C\" __declspec(dllexport) int Method");
+                writer.Write(i.ToString());
+                writer.WriteLine("(Type0* _this, int a, int b)");
+                using (writer.Block())
+                { writer.WriteLine("return _this->Field0 + a + b;"); }
+            }
+        }
+
+        private (double Seconds, long Bytes) Measure<TWriter>(Action<TWriter> write, string fileName)
+            where TWriter : CodeWriter
+        {
+            string outputDirectory = Path.Combine(Path.GetTempPath(), $"{nameof(CodeWriterThroughputTests)}_{Guid.NewGuid():N}");
+            try
+            {
+                Stopwatch stopwatch = Stopwatch.StartNew();
+                using (OutputSession session = new() { BaseOutputDirectory = outputDirectory })
+                {
+                    TWriter writer = session.Open<TWriter>(fileName);
+                    write(writer);
+                    writer.Finish();
+                }
+                stopwatch.Stop();
+
+                return (stopwatch.Elapsed.TotalSeconds, new FileInfo(Path.Combine(outputDirectory, fileName)).Length);
+            }
+            finally
+            {
+                if (Directory.Exists(outputDirectory))
+                { Directory.Delete(outputDirectory, recursive: true); }
+            }
+        }
+
+        private void MeasureThroughput<TWriter>(Action<TWriter> write, string fileName)
+            where TWriter : CodeWriter
+        {
+            // Warm up so that JIT time isn't included in the measurements
+            (_, long expectedBytes) = Measure(write, fileName);
+            Assert.True(expectedBytes > 0);
+
+            double bestSeconds = Double.PositiveInfinity;
+            for (int i = 0; i < IterationCount; i++)
+            {
+                (double seconds, long bytes) = Measure(write, fileName);
+                Assert.Equal(expectedBytes, bytes);
+                bestSeconds = Math.Min(bestSeconds, seconds);
+            }
+
+            double megabytes = expectedBytes / (1024.0 * 1024.0);
+            Output.WriteLine($"{typeof(TWriter).Name}: {megabytes:0.00} MB in {bestSeconds * 1000.0:0.0} ms ({megabytes / bestSeconds:0.0} MB/s, best of {IterationCount})");
+        }
+
+        private const string SkipReason = "Benchmark, run manually to measure code writer throughput.";
+
+        [Fact(Skip = SkipReason)]
+        public void CSharpCodeWriterThroughput()
+            => MeasureThroughput<CSharpCodeWriter>(WriteSyntheticCSharp, "Synthetic.cs");
+
+        [Fact(Skip = SkipReason)]
+        public void CppCodeWriterThroughput()
+            => MeasureThroughput<CppCodeWriter>(WriteSyntheticCpp, "Synthetic.cpp");
+    }
+}
@@ -0,0 +1,171 @@
+﻿using Biohazrd.Tests.Common;
+using Biohazrd.Transformation.Common;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.Threading;
+using Xunit;
+
+namespace Biohazrd.CSharp.Tests
+{
+    /// <summary>Verifies the transformations which analyze the library in parallel produce the same results as doing the analysis serially.</summary>
+    /// <remarks>
+    /// The serial results are computed by the tests themselves by walking the library in transform order.
+    /// Each transformation is run several times since a scheduling-dependent result wouldn't necessarily show up on the first run.
+    /// </remarks>
+    public sealed class ConcurrentTransformationTests : BiohazrdTestBase
+    {
+        private const int DeclarationCount = 200;
+        private const int RunCount = 8;
+
+        [Fact]
+        public void DeduplicateNamesMatchesSerial()
+        {
+            // Namespaces are flattened, so every Duplicate* struct and Function is a sibling of the others with the same name
+            StringBuilder cppCode = new();
+            for (int i = 0; i < DeclarationCount; i++)
+            { cppCode.AppendLine($"namespace N{i} {{ struct Duplicate{i % 7} {{ int x; }}; void Function(); }}"); }
+
+            TranslatedLibrary library = CreateLibrary(cppCode.ToString());
+
+            // Suffixes are assigned in transform order to every non-function declaration whose name is duplicated
+            Dictionary<string, int> nameCounts = new();
+            foreach (TranslatedDeclaration declaration in library)
+            {
+                nameCounts.TryGetValue(declaration.Name, out int count);
+                nameCounts[declaration.Name] = count + 1;
+            }
+
+            Dictionary<string, int> nextSuffixNumber = new();
+            List<string> expectedNames = new();
+            foreach (TranslatedDeclaration declaration in library)
+            {
+                if (declaration is TranslatedFunction || nameCounts[declaration.Name] < 2)
+                {
+                    expectedNames.Add(declaration.Name);
+                    continue;
+                }
+
+                nextSuffixNumber.TryGetValue(declaration.Name, out int suffixNumber);
+                nextSuffixNumber[declaration.Name] = suffixNumber + 1;
+                expectedNames.Add($"{declaration.Name}_{suffixNumber}");
+            }
+
+            DeduplicateNamesTransformation transformation = new();
+            for (int run = 0; run < RunCount; run++)
+            {
+                TranslatedLibrary result = transformation.Transform(library);
+                Assert.Equal(expectedNames, result.Select(d => d.Name));
+            }
+        }
+
+        private static string GetTypeNameForFunction(VisitorContext context, TranslatedDeclaration declaration)
+        {
+            int index = int.Parse(declaration.Name.Substring("Function".Length));
+
+            // Vary how long each name takes so the parallel analysis finishes out of order
+            Thread.Sleep(index % 3);
+            return $"Group{index * 3 % 7}";
+        }
+
+        [Fact]
+        public void MoveLooseDeclarationsIntoTypesMatchesSerial()
+        {
+            StringBuilder cppCode = new();
+            for (int i = 0; i < DeclarationCount; i++)
+            {
+                cppCode.AppendLine($"void Function{i}();");
+
+                // An existing record receives the declarations for its name, even when it's declared after some of them
+                if (i == DeclarationCount / 2)
+                { cppCode.AppendLine("struct Group3 { int x; };"); }
+            }
+
+            TranslatedLibrary library = CreateLibrary(cppCode.ToString());
+
+            // Group the functions in transform order, groups are synthesized in the order they're first encountered
+            List<(string TypeName, List<string> Functions)> expectedGroups = new();
+            foreach (TranslatedFunction function in library.OfType<TranslatedFunction>())
+            {
+                string typeName = GetTypeNameForFunction(default, function);
+                List<string>? functions = expectedGroups.FirstOrDefault(g => g.TypeName == typeName).Functions;
+
+                if (functions is null)
+                {
+                    functions = new List<string>();
+                    expectedGroups.Add((typeName, functions));
+                }
+
+                functions.Add(function.Name);
+            }
+
+            MoveLooseDeclarationsIntoTypesTransformation transformation = new(GetTypeNameForFunction);
+            for (int run = 0; run < RunCount; run++)
+            {
+                TranslatedLibrary result = transformation.Transform(library);
+                Assert.Empty(result.OfType<TranslatedFunction>());
+
+                TranslatedRecord existingRecord = result.FindDeclaration<TranslatedRecord>("Group3");
+                Assert.Equal(expectedGroups.Single(g => g.TypeName == "Group3").Functions, existingRecord.Members.OfType<TranslatedFunction>().Select(f => f.Name));
+
+                List<SynthesizedLooseDeclarationsTypeDeclaration> synthesizedTypes = result.OfType<SynthesizedLooseDeclarationsTypeDeclaration>().ToList();
+                Assert.Equal(expectedGroups.Where(g => g.TypeName != "Group3").Select(g => g.TypeName), synthesizedTypes.Select(t => t.Name));
+
+                foreach (SynthesizedLooseDeclarationsTypeDeclaration synthesizedType in synthesizedTypes)
+                { Assert.Equal(expectedGroups.Single(g => g.TypeName == synthesizedType.Name).Functions, synthesizedType.Members.Select(m => m.Name)); }
+            }
+        }
+
+        [Fact]
+        public void MoveLooseDeclarationsIntoTypesRenameWarning()
+        {
+            // Loose declarations are placed in a type named after their file by default, so this function collides with its containing type
+            TranslatedLibrary library = CreateLibrary("void A();");
+            library = new MoveLooseDeclarationsIntoTypesTransformation().Transform(library);
+
+            TranslatedFunction function = library.FindDeclaration<TranslatedFunction>("A__");
+            Assert.Contains(library.GetDiagnostics(function), d => d.Severity == Severity.Warning && d.Message.Contains("automatically renamed"));
+        }
+
+        [Fact]
+        public void MoveLooseDeclarationsIntoTypesRenameWarningIsLogged()
+        {
+            TranslatedLibrary library = CreateLibrary("void A();");
+            library = library with { DiagnosticLog = TranslationDiagnosticLog.Empty };
+            library = new MoveLooseDeclarationsIntoTypesTransformation().Transform(library);
+
+            TranslatedFunction function = library.FindDeclaration<TranslatedFunction>("A__");
+            Assert.DoesNotContain(function.Diagnostics, d => d.Message.Contains("automatically renamed"));
+            Assert.Contains(library.GetDiagnostics(function), d => d.Severity == Severity.Warning && d.Message.Contains("automatically renamed"));
+        }
+
+        [Fact]
+        public void WrapNonBlittableTypesWhereNecessaryMatchesSerial()
+        {
+            StringBuilder cppCode = new();
+            for (int i = 0; i < DeclarationCount; i++)
+            { cppCode.AppendLine(i % 2 == 0 ? $"void Function{i}(bool b);" : $"void Function{i}(char16_t c);"); }
+
+            TranslatedLibrary library = CreateLibrary(cppCode.ToString());
+            library = new CSharpTypeReductionTransformation().Transform(library);
+
+            WrapNonBlittableTypesWhereNecessaryTransformation transformation = new() { WrapAllNonBlittableTypes = true };
+            for (int run = 0; run < RunCount; run++)
+            {
+                TranslatedLibrary result = transformation.Transform(library);
+
+                // Serially, exactly one of each native declaration is added and every parameter refers to it
+                NativeBooleanDeclaration nativeBoolean = Assert.Single(result.OfType<NativeBooleanDeclaration>());
+                NativeCharDeclaration nativeChar = Assert.Single(result.OfType<NativeCharDeclaration>());
+
+                foreach (TranslatedFunction function in result.OfType<TranslatedFunction>())
+                {
+                    TranslatedParameter parameter = Assert.Single(function.Parameters);
+                    TranslatedTypeReference reference = Assert.IsAssignableFrom<TranslatedTypeReference>(parameter.Type);
+                    TranslatedDeclaration? expected = parameter.Name == "b" ? nativeBoolean : nativeChar;
+                    Assert.ReferenceEqual(expected, reference.TryResolve(result));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,41 @@
+﻿using Biohazrd.Tests.Common;
+using Xunit;
+
+namespace Biohazrd.CSharp.Tests
+{
+    public sealed class ConstantArrayTests : BiohazrdTestBase
+    {
+        private string Generate(string cppCode)
+        {
+            TranslatedLibrary library = CreateLibrary(cppCode);
+            library = new CSharpTypeReductionTransformation().Transform(library);
+            library = new MoveLooseDeclarationsIntoTypesTransformation().Transform(library);
+
+            InMemoryOutput output = GenerateInMemory(session => CSharpLibraryGenerator.Generate(new CSharpGenerationOptions() { DumpClangInfo = false }, session, library, LibraryTranslationMode.OneFile));
+            return output.GetFile("TranslatedLibrary.cs");
+        }
+
+        [Fact]
+        public void SpanAccessors()
+        {
+            string code = Generate("struct Matrix { float Values[16]; };");
+            Assert.Contains("public Span<float> AsSpan()", code);
+            Assert.Contains("public ReadOnlySpan<float> AsReadOnlySpan()", code);
+            Assert.Contains("MemoryMarshal.CreateSpan(", code);
+            Assert.Contains("public void CopyTo(Span<float> destination)", code);
+            Assert.Contains("public bool SequenceEqual(ReadOnlySpan<float> other)", code);
+            Assert.Contains("public Span<float>.Enumerator GetEnumerator()", code);
+            Assert.DoesNotContain("fixed (", code);
+            Assert.DoesNotContain("ConstantArrayOfPointersEnumerator", code);
+        }
+
+        [Fact]
+        public void ArrayOfPointers()
+        {
+            string code = Generate("struct Pointers { int* Values[4]; };");
+            Assert.DoesNotContain("AsSpan", code);
+            Assert.Contains("public unsafe ref struct ConstantArrayOfPointersEnumerator<T>", code);
+            Assert.Contains("public ConstantArrayOfPointersEnumerator<int> GetEnumerator()", code);
+        }
+    }
+}
@@ -0,0 +1,60 @@
+﻿using Biohazrd.Tests.Common;
+using Biohazrd.Transformation;
+using Xunit;
+
+namespace Biohazrd.CSharp.Tests
+{
+    public sealed class DevirtualizationTests : BiohazrdTestBase
+    {
+        /// <summary>Marks final methods as devirtualized the same way <c>LinkImportsTransformation</c> would if they were resolved.</summary>
+        private sealed class DevirtualizeFinalMethodsTransformation : TransformationBase
+        {
+            protected override TransformationResult TransformFunction(TransformationContext context, TranslatedFunction declaration)
+                => declaration with { IsDevirtualized = declaration.IsFinal };
+        }
+
+        private string Generate(string cppCode)
+        {
+            TranslatedLibrary library = CreateLibrary(cppCode);
+            library = new DevirtualizeFinalMethodsTransformation().Transform(library);
+            library = new CSharpTypeReductionTransformation().Transform(library);
+            library = new MoveLooseDeclarationsIntoTypesTransformation().Transform(library);
+
+            InMemoryOutput output = GenerateInMemory(session => CSharpLibraryGenerator.Generate(new CSharpGenerationOptions() { DumpClangInfo = false }, session, library, LibraryTranslationMode.OneFile));
+            return output.GetFile("TranslatedLibrary.cs");
+        }
+
+        [Fact]
+        public void FinalMethodIsCalledDirectly()
+        {
+            string code = Generate(@"
+class Test
+{
+public:
+    virtual int VirtualMethod();
+    virtual int FinalMethod() final;
+};
+"
+            );
+
+            Assert.Contains("static extern int FinalMethod_PInvoke(", code);
+            Assert.DoesNotContain("VirtualMethod_PInvoke", code);
+        }
+
+        [Fact]
+        public void FinalClassMethodIsCalledDirectly()
+        {
+            string code = Generate(@"
+class Test final
+{
+public:
+    virtual int VirtualMethod();
+};
+"
+            );
+
+            Assert.Contains("static extern int VirtualMethod_PInvoke(", code);
+            Assert.Contains("return VirtualMethod_PInvoke(", code);
+        }
+    }
+}
@@ -0,0 +1,158 @@
+﻿using Biohazrd.Tests.Common;
+using System.Collections.Generic;
+using System.Text;
+using System.Text.RegularExpressions;
+using Xunit;
+
+namespace Biohazrd.CSharp.Tests
+{
+    public sealed class DisableRuntimeMarshallingTests : BiohazrdTestBase
+    {
+        private const string Source = @"
+struct MyStruct
+{
+    bool BoolField;
+    char16_t CharField;
+};
+
+bool GetBool(bool a, char16_t b);
+char16_t GetChar(bool* a);
+";
+
+        private TranslatedLibrary CreateTransformedLibrary(bool wrapAllNonBlittableTypes)
+        {
+            TranslatedLibrary library = CreateLibrary(Source);
+            library = new CSharpTypeReductionTransformation().Transform(library);
+            library = new MoveLooseDeclarationsIntoTypesTransformation().Transform(library);
+            library = new WrapNonBlittableTypesWhereNecessaryTransformation() { WrapAllNonBlittableTypes = wrapAllNonBlittableTypes }.Transform(library);
+            return library;
+        }
+
+        private string Generate(TranslatedLibrary library, CSharpGenerationOptions options, string fileName)
+            => GenerateInMemory(session => CSharpLibraryGenerator.Generate(options, session, library, LibraryTranslationMode.OneFile)).GetFile(fileName);
+
+        [Fact]
+        public void DefaultOnlyWrapsFunctionPointers()
+        {
+            TranslatedLibrary library = CreateTransformedLibrary(wrapAllNonBlittableTypes: false);
+            TranslatedFunction function = library.EnumerateRecursively().FindDeclaration<TranslatedFunction>("GetBool");
+            Assert.True(function.ReturnType.IsCSharpType(CSharpBuiltinType.Bool));
+            Assert.DoesNotContain(library.Declarations, d => d is NativeBooleanDeclaration);
+        }
+
+        [Fact]
+        public void WrapAllNonBlittableTypes()
+        {
+            TranslatedLibrary library = CreateTransformedLibrary(wrapAllNonBlittableTypes: true);
+
+            TranslatedFunction getBool = library.EnumerateRecursively().FindDeclaration<TranslatedFunction>("GetBool");
+            Assert.IsType<TranslatedTypeReference>(getBool.ReturnType);
+            Assert.IsType<TranslatedTypeReference>(getBool.Parameters[0].Type);
+            Assert.IsType<TranslatedTypeReference>(getBool.Parameters[1].Type);
+
+            // Pointers are never touched by the marshaler so they're left alone
+            TranslatedFunction getChar = library.EnumerateRecursively().FindDeclaration<TranslatedFunction>("GetChar");
+            PointerTypeReference pointer = Assert.IsType<PointerTypeReference>(getChar.Parameters[0].Type);
+            Assert.True(pointer.Inner.IsCSharpType(CSharpBuiltinType.Bool));
+
+            TranslatedNormalField boolField = library.EnumerateRecursively().FindDeclaration<TranslatedNormalField>("BoolField");
+            Assert.IsType<TranslatedTypeReference>(boolField.Type);
+
+            Assert.Contains(library.Declarations, d => d is NativeBooleanDeclaration);
+            Assert.Contains(library.Declarations, d => d is NativeCharDeclaration);
+        }
+
+        /// <summary>Applies the <c>NET7_0_OR_GREATER</c> conditionals in the specified code as the C# compiler would for the specified target. Other conditionals are left as-is.</summary>
+        private static string Preprocess(string code, bool isNet7OrGreater)
+        {
+            StringBuilder result = new();
+            Stack<(bool WasActive, bool? Condition)> conditionals = new();
+            bool isActive = true;
+
+            foreach (string line in code.Replace("\r\n", "\n").Split('\n'))
+            {
+                string directive = line.Trim();
+                if (directive.StartsWith("#if "))
+                {
+                    bool? condition = directive.Substring(4).Trim() switch
+                    {
+                        "NET7_0_OR_GREATER" => isNet7OrGreater,
+                        "!NET7_0_OR_GREATER" => !isNet7OrGreater,
+                        _ => null
+                    };
+
+                    conditionals.Push((isActive, condition));
+
+                    if (condition is bool value)
+                    {
+                        isActive = isActive && value;
+                        continue;
+                    }
+                }
+                else if (directive == "#else" && conditionals.Peek().Condition is bool value)
+                {
+                    isActive = conditionals.Peek().WasActive && !value;
+                    continue;
+                }
+                else if (directive == "#endif")
+                {
+                    (bool wasActive, bool? condition) = conditionals.Pop();
+                    isActive = wasActive;
+
+                    if (condition is not null)
+                    { continue; }
+                }
+
+                if (isActive)
+                { result.Append(line).Append('\n'); }
+            }
+
+            Assert.Empty(conditionals);
+            return result.ToString();
+        }
+
+        private static string RemoveWhitespace(string code)
+            => Regex.Replace(code, @"\s", "");
+
+        [Fact]
+        public void MarshallingHintsOnlyEmittedBeforeNet7()
+        {
+            // Use the non-wrapped library so that we can observe the generator's marshaling hints
+            TranslatedLibrary library = CreateTransformedLibrary(wrapAllNonBlittableTypes: false);
+
+            string defaultCode = Generate(library, new CSharpGenerationOptions() { DumpClangInfo = false }, "TranslatedLibrary.cs");
+            Assert.Contains("MarshalAs(UnmanagedType.I1)", defaultCode);
+            Assert.Contains("CharSet = CharSet.Unicode", defaultCode);
+
+            string code = Generate(library, new CSharpGenerationOptions() { DumpClangInfo = false, DisableRuntimeMarshalling = true }, "TranslatedLibrary.cs");
+
+            // DisableRuntimeMarshalling is applied on .NET 7+, so the hints are unnecessary there
+            string net7Code = Preprocess(code, isNet7OrGreater: true);
+            Assert.DoesNotContain("MarshalAs", net7Code);
+            Assert.DoesNotContain("CharSet", net7Code);
+
+            // Older runtimes still run the marshaler, so they must see exactly the same declarations as they would without DisableRuntimeMarshalling
+            string preNet7Code = Preprocess(code, isNet7OrGreater: false);
+            Assert.Equal(RemoveWhitespace(defaultCode), RemoveWhitespace(preNet7Code));
+        }
+
+        [Fact]
+        public void AttributesEmitted()
+        {
+            TranslatedLibrary library = CreateTransformedLibrary(wrapAllNonBlittableTypes: true);
+            string code = Generate(library, new CSharpGenerationOptions() { DumpClangInfo = false, DisableRuntimeMarshalling = true }, "RuntimeMarshalling.cs");
+            Assert.Contains("[assembly: System.Runtime.CompilerServices.DisableRuntimeMarshalling]", code);
+
+            // SkipLocalsInit has its own option since the consuming project might already apply it
+            Assert.DoesNotContain("SkipLocalsInit", code);
+        }
+
+        [Fact]
+        public void SkipLocalsInitEmitted()
+        {
+            TranslatedLibrary library = CreateTransformedLibrary(wrapAllNonBlittableTypes: false);
+            string code = Generate(library, new CSharpGenerationOptions() { DumpClangInfo = false, SkipLocalsInit = true }, "SkipLocalsInit.cs");
+            Assert.Matches(@"#if NET5_0_OR_GREATER\s+\[module: System\.Runtime\.CompilerServices\.SkipLocalsInit\]\s+#endif", code);
+        }
+    }
+}
@@ -0,0 +1,78 @@
+﻿using Biohazrd.Tests.Common;
+using Xunit;
+
+namespace Biohazrd.CSharp.Tests
+{
+    public sealed class FunctionPointerImportTests : BiohazrdTestBase
+    {
+        private (string Code, string? Tables) Generate(TranslatedLibrary library, NativeFunctionImportMode mode)
+        {
+            library = new CSharpTypeReductionTransformation().Transform(library);
+            library = new MoveLooseDeclarationsIntoTypesTransformation().Transform(library);
+
+            CSharpGenerationOptions options = new() { DumpClangInfo = false, FunctionImportMode = mode };
+            InMemoryOutput output = GenerateInMemory(session => CSharpLibraryGenerator.Generate(options, session, library, LibraryTranslationMode.OneFile));
+            output.AssertCompiles();
+            return (output.GetFile("TranslatedLibrary.cs"), output.TryGetFile("NativeImportTables.cs"));
+        }
+
+        [Fact]
+        public void DllImportByDefault()
+        {
+            TranslatedLibrary library = CreateLibrary("void Function(int x);");
+            (string code, string? tables) = Generate(library, NativeFunctionImportMode.DllImport);
+            Assert.Contains("[DllImport(", code);
+            Assert.Null(tables);
+        }
+
+        [Theory]
+        [InlineData(NativeFunctionImportMode.EagerFunctionPointerTable)]
+        [InlineData(NativeFunctionImportMode.LazyFunctionPointerTable)]
+        public void FunctionPointerTable(NativeFunctionImportMode mode)
+        {
+            TranslatedLibrary library = CreateLibrary
+            (@"
+void Function(int x);
+bool Predicate(bool x);
+"
+            );
+            (string code, string? tables) = Generate(library, mode);
+
+            Assert.DoesNotContain("[DllImport(", code);
+            Assert.Contains("delegate* unmanaged[Cdecl]<int, void>", code);
+            Assert.Contains("delegate* unmanaged[Cdecl]<byte, byte>", code);
+            Assert.Contains(".Resolve(ref global::__NativeImports_TODO.Table.", code);
+
+            Assert.NotNull(tables);
+            Assert.Contains("internal static unsafe class __NativeImports_TODO", tables);
+            Assert.Contains("public void* Function_0;", tables);
+            Assert.Contains("public void* Predicate_1;", tables);
+            Assert.Equal(mode == NativeFunctionImportMode.EagerFunctionPointerTable, tables!.Contains("CreateTable()"));
+        }
+
+        [Theory]
+        [InlineData(NativeFunctionImportMode.DllImport)]
+        [InlineData(NativeFunctionImportMode.LazyFunctionPointerTable)]
+        public void StaticFieldsShareImportTable(NativeFunctionImportMode mode)
+        {
+            TranslatedLibrary library = CreateLibrary
+            (@"
+extern int GlobalA;
+extern float GlobalB;
+"
+            );
+            (string code, string? tables) = Generate(library, mode);
+
+            Assert.DoesNotContain("NativeLibrary.Load", code);
+            Assert.Contains("public static unsafe ref int GlobalA", code);
+            Assert.Contains("public static unsafe ref float GlobalB", code);
+            Assert.Contains("return ref *(int*)__address;", code);
+
+            // Both globals should use the same library handle
+            Assert.NotNull(tables);
+            Assert.Single(System.Text.RegularExpressions.Regex.Matches(tables!, "internal static unsafe class "));
+            Assert.Contains("public void* GlobalA_0;", tables);
+            Assert.Contains("public void* GlobalB_1;", tables);
+        }
+    }
+}
@@ -0,0 +1,142 @@
+﻿using Biohazrd.OutputGeneration;
+using Biohazrd.Utilities;
+using System;
+using System.Collections.Immutable;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+using System.Threading;
+using System.Threading.Tasks;
+using Xunit;
+
+namespace Biohazrd.CSharp.Tests
+{
+    public sealed class GenerationServerTests : IDisposable
+    {
+        private readonly string InputDirectory = Path.Combine(Path.GetTempPath(), $"{nameof(GenerationServerTests)}_{Guid.NewGuid():N}");
+        private readonly string OutputDirectory;
+        private readonly string HeaderPath;
+        private readonly string OutputPath;
+
+        public GenerationServerTests()
+        {
+            Directory.CreateDirectory(InputDirectory);
+            OutputDirectory = Path.Combine(InputDirectory, "Output");
+            HeaderPath = Path.Combine(InputDirectory, "Test.h");
+            OutputPath = Path.Combine(OutputDirectory, "Declarations.txt");
+            File.WriteAllText(HeaderPath, "struct A { int x; };\n");
+        }
+
+        private GenerationServer CreateServer(string pipeName = "")
+        {
+            TranslatedLibraryBuilder builder = new();
+            builder.AddFile(HeaderPath);
+
+            return new GenerationServer
+            (
+                pipeName,
+                builder,
+                (library, cancellationToken) => library,
+                (library, session, cancellationToken) =>
+                {
+                    StreamWriter writer = session.Open<StreamWriter>("Declarations.txt");
+                    foreach (TranslatedDeclaration declaration in library)
+                    { writer.WriteLine(declaration.Name); }
+
+                    return ImmutableArray<TranslationDiagnostic>.Empty;
+                },
+                () => new OutputSession() { BaseOutputDirectory = OutputDirectory }
+            );
+        }
+
+        private static void WaitUntil(Func<bool> condition)
+        {
+            Stopwatch stopwatch = Stopwatch.StartNew();
+            while (!condition())
+            {
+                if (stopwatch.Elapsed > TimeSpan.FromSeconds(10))
+                { throw new TimeoutException("Timed out waiting for the generation server."); }
+
+                Thread.Sleep(50);
+            }
+        }
+
+        [Fact]
+        public void ChangeDetection()
+        {
+            using GenerationServer server = CreateServer();
+            server.RegenerateOnChange = false;
+
+            GenerationServerResult result = server.Regenerate();
+            Assert.False(result.WasUpToDate);
+            Assert.Equal(1, result.ChangedFileCount);
+            Assert.Equal(new[] { "A" }, File.ReadAllLines(OutputPath));
+
+            Assert.True(server.Regenerate().WasUpToDate);
+
+            // Touching a file without changing its contents is not a change
+            File.WriteAllText(HeaderPath, "struct A { int x; };\n");
+            Thread.Sleep(500);
+            Assert.True(server.Regenerate().WasUpToDate);
+
+            // Actually changing it is
+            File.WriteAllText(HeaderPath, "struct A { int x; };\nstruct B { int y; };\n");
+            WaitUntil(() => !(result = server.Regenerate()).WasUpToDate);
+            Assert.Equal(1, result.ChangedFileCount);
+            Assert.Equal(new[] { "A", "B" }, File.ReadAllLines(OutputPath));
+
+            // Forced regenerations always regenerate, but unchanged output is left alone
+            result = server.Regenerate(force: true);
+            Assert.False(result.WasUpToDate);
+            Assert.Equal(0, result.ChangedFileCount);
+            Assert.Equal(1, result.UnchangedFileCount);
+        }
+
+        [Fact]
+        public async Task Protocol()
+        {
+            string pipeName = $"{nameof(GenerationServerTests)}_{Guid.NewGuid():N}";
+            using GenerationServer server = CreateServer(pipeName);
+            server.RegenerateOnChange = true;
+            server.ChangeDebounceDelay = TimeSpan.FromMilliseconds(50);
+
+            Task serverTask = server.RunAsync();
+
+            static string[] Split(string response)
+                => response.Split(' ');
+
+            string[] response = Split(await GenerationServer.SendRequestAsync(pipeName));
+            Assert.Equal(6, response.Length);
+            Assert.Equal("ok", response[0]);
+            Assert.Equal("1", response[1]); // Changed files
+            Assert.Equal("0", response[2]); // Unchanged files
+            Assert.Equal("0", response[3]); // Errors
+
+            Assert.Equal("up-to-date", await GenerationServer.SendRequestAsync(pipeName));
+            Assert.StartsWith("error ", await GenerationServer.SendRequestAsync(pipeName, "bogus"));
+
+            // Changes are picked up by a background regeneration, and its result is reported by the next request
+            File.WriteAllText(HeaderPath, "struct A { int x; };\nstruct B { int y; };\n");
+            WaitUntil(() => File.Exists(OutputPath) && File.ReadAllLines(OutputPath).Contains("B"));
+
+            response = Split(await GenerationServer.SendRequestAsync(pipeName));
+            Assert.Equal("ok", response[0]);
+            Assert.Equal("1", response[1]);
+            Assert.Equal("up-to-date", await GenerationServer.SendRequestAsync(pipeName));
+
+            response = Split(await GenerationServer.SendRequestAsync(pipeName, "regenerate-force"));
+            Assert.Equal("ok", response[0]);
+            Assert.Equal("0", response[1]);
+            Assert.Equal("1", response[2]);
+
+            Assert.Equal("ok", await GenerationServer.SendRequestAsync(pipeName, "shutdown"));
+            await serverTask;
+        }
+
+        public void Dispose()
+        {
+            if (Directory.Exists(InputDirectory))
+            { Directory.Delete(InputDirectory, recursive: true); }
+        }
+    }
+}
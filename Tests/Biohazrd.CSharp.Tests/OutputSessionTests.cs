@@ -0,0 +1,131 @@
+﻿using Biohazrd.OutputGeneration;
+using System;
+using System.IO;
+using System.IO.Compression;
+using System.Linq;
+using Xunit;
+
+namespace Biohazrd.CSharp.Tests
+{
+    public sealed class OutputSessionTests : IDisposable
+    {
+        private readonly string OutputDirectory = Path.Combine(Path.GetTempPath(), $"{nameof(OutputSessionTests)}_{Guid.NewGuid():N}");
+
+        private OutputSession Generate(string fileContents, bool skipUnchangedFiles = true)
+        {
+            using OutputSession session = new()
+            {
+                BaseOutputDirectory = OutputDirectory,
+                SkipUnchangedFiles = skipUnchangedFiles
+            };
+
+            session.Open<CSharpCodeWriter>("Unchanging.cs").WriteLine("class Unchanging { }");
+            session.Open<CSharpCodeWriter>("Changing.cs").WriteLine(fileContents);
+            return session;
+        }
+
+        [Fact]
+        public void UnchangedFilesAreNotRewritten()
+        {
+            OutputSession session = Generate("class Changing { }");
+            Assert.Equal(2, session.ChangedFileCount);
+            Assert.Equal(0, session.UnchangedFileCount);
+
+            string unchangingPath = Path.Combine(OutputDirectory, "Unchanging.cs");
+            DateTime originalWriteTime = new DateTime(2000, 1, 1, 0, 0, 0, DateTimeKind.Utc);
+            File.SetLastWriteTimeUtc(unchangingPath, originalWriteTime);
+
+            session = Generate("class Changing { int x; }");
+            Assert.Equal(1, session.ChangedFileCount);
+            Assert.Equal(1, session.UnchangedFileCount);
+            Assert.Equal(originalWriteTime, File.GetLastWriteTimeUtc(unchangingPath));
+            Assert.Contains("int x;", File.ReadAllText(Path.Combine(OutputDirectory, "Changing.cs")));
+
+            string[] filesWritten = File.ReadAllLines(Path.Combine(OutputDirectory, "FilesWritten.txt"));
+            Assert.Equal(new[] { "Changing.cs", "Unchanging.cs" }, filesWritten);
+        }
+
+        [Fact]
+        public void FilesAreAlwaysRewrittenByDefault()
+        {
+            Generate("class Changing { }", skipUnchangedFiles: false);
+            OutputSession session = Generate("class Changing { }", skipUnchangedFiles: false);
+            Assert.Equal(0, session.ChangedFileCount);
+            Assert.Equal(0, session.UnchangedFileCount);
+        }
+
+        [Fact]
+        public void InMemorySink()
+        {
+            InMemoryOutputSink sink = new();
+            using (OutputSession session = new() { BaseOutputDirectory = OutputDirectory, Sink = sink })
+            {
+                session.Open<CSharpCodeWriter>("A.cs").WriteLine("class A { }");
+                session.Open<CSharpCodeWriter>(Path.Combine("Nested", "B.cs")).WriteLine("class B { }");
+            }
+
+            Assert.False(Directory.Exists(OutputDirectory));
+            Assert.Contains("class A { }", sink.GetFileText(Path.Combine(OutputDirectory, "A.cs")));
+            Assert.Contains("class B { }", sink.GetFileText(Path.Combine(OutputDirectory, "Nested", "B.cs")));
+            Assert.NotNull(sink.GetFileText(Path.Combine(OutputDirectory, "FilesWritten.txt")));
+
+            // A later session using the same sink should clean up files it didn't write and skip unchanged ones
+            using (OutputSession session = new() { BaseOutputDirectory = OutputDirectory, Sink = sink, SkipUnchangedFiles = true })
+            {
+                session.Open<CSharpCodeWriter>("A.cs").WriteLine("class A { }");
+                session.Dispose();
+                Assert.Equal(0, session.ChangedFileCount);
+                Assert.Equal(1, session.UnchangedFileCount);
+            }
+
+            Assert.Null(sink.GetFileText(Path.Combine(OutputDirectory, "Nested", "B.cs")));
+        }
+
+        [Fact]
+        public void ZipArchiveSink()
+        {
+            Directory.CreateDirectory(OutputDirectory);
+            string archivePath = Path.Combine(OutputDirectory, "Output.zip");
+            string virtualDirectory = Path.Combine(OutputDirectory, "Generated");
+
+            using (OutputSession session = new() { BaseOutputDirectory = virtualDirectory, Sink = new ZipArchiveOutputSink(archivePath, virtualDirectory) })
+            {
+                session.Open<CSharpCodeWriter>("A.cs").WriteLine("class A { }");
+                session.Open<CSharpCodeWriter>(Path.Combine("Nested", "B.cs")).WriteLine("class B { }");
+            }
+
+            Assert.False(Directory.Exists(virtualDirectory));
+
+            using ZipArchive archive = ZipFile.OpenRead(archivePath);
+            Assert.Equal(new[] { "A.cs", "FilesWritten.txt", "Nested/B.cs" }, archive.Entries.Select(e => e.FullName).OrderBy(n => n, StringComparer.Ordinal));
+        }
+
+        [Fact]
+        public void FileStreamsUseSink()
+        {
+            using (OutputSession session = new() { BaseOutputDirectory = OutputDirectory })
+            {
+                using FileStream stream = session.Open<FileStream>(Path.Combine("Nested", "Raw.bin"));
+                stream.WriteByte(42);
+            }
+
+            Assert.Equal(new byte[] { 42 }, File.ReadAllBytes(Path.Combine(OutputDirectory, "Nested", "Raw.bin")));
+
+            // Raw file streams can't be provided by sinks which aren't backed by the file system
+            InMemoryOutputSink sink = new();
+            using (OutputSession session = new() { BaseOutputDirectory = OutputDirectory, Sink = sink })
+            {
+                Assert.Throws<NotSupportedException>(() => session.Open<FileStream>("Raw.bin"));
+                Assert.DoesNotContain("Raw.bin", session.FilesWritten.Select(f => Path.GetFileName(f)));
+            }
+
+            Assert.Null(sink.GetFileText(Path.Combine(OutputDirectory, "Raw.bin")));
+        }
+
+        public void Dispose()
+        {
+            if (Directory.Exists(OutputDirectory))
+            { Directory.Delete(OutputDirectory, recursive: true); }
+        }
+    }
+}
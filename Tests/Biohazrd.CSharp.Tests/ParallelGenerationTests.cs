@@ -0,0 +1,86 @@
+﻿using Biohazrd.CSharp.Infrastructure;
+using Biohazrd.Tests.Common;
+using System;
+using System.Collections.Immutable;
+using System.Linq;
+using System.Text;
+using Xunit;
+
+namespace Biohazrd.CSharp.Tests
+{
+    public sealed class ParallelGenerationTests : BiohazrdTestBase
+    {
+        private const int TypeCount = 64;
+
+        private TranslatedLibrary CreateTransformedLibrary()
+        {
+            // Every type references other types so that generators resolve type references against the library concurrently
+            StringBuilder cppCode = new();
+            for (int i = 0; i < TypeCount; i++)
+            { cppCode.AppendLine($"struct Type{i};"); }
+
+            for (int i = 0; i < TypeCount; i++)
+            {
+                cppCode.AppendLine($"struct Type{i} {{ Type{(i + 1) % TypeCount}* Next; Type{(i * 7) % TypeCount}* Other; int Value; void Method(Type{(i * 3) % TypeCount}* other); }};");
+                cppCode.AppendLine($"void Function{i}(Type{i}* a, Type{(i * 5) % TypeCount}* b);");
+            }
+
+            TranslatedLibrary library = CreateLibrary(cppCode.ToString());
+            library = new CSharpTypeReductionTransformation().Transform(library);
+            library = new MoveLooseDeclarationsIntoTypesTransformation().Transform(library);
+            return library;
+        }
+
+        private (InMemoryOutput Output, ImmutableArray<TranslationDiagnostic> Diagnostics) Generate(TranslatedLibrary library, LibraryTranslationMode mode, bool parallel)
+        {
+            CSharpGenerationOptions options = new() { DumpClangInfo = false, ParallelGeneration = parallel };
+            ImmutableArray<TranslationDiagnostic> diagnostics = default;
+            InMemoryOutput output = GenerateInMemory(session => diagnostics = CSharpLibraryGenerator.Generate(options, session, library, mode));
+            return (output, diagnostics);
+        }
+
+        [Theory]
+        [InlineData(LibraryTranslationMode.OneFilePerType)]
+        [InlineData(LibraryTranslationMode.OneFilePerInputFile)]
+        public void ParallelOutputMatchesSerial(LibraryTranslationMode mode)
+        {
+            // Parallel generation runs first so that it starts with cold lookup caches
+            (InMemoryOutput parallel, ImmutableArray<TranslationDiagnostic> parallelDiagnostics) = Generate(CreateTransformedLibrary(), mode, parallel: true);
+            (InMemoryOutput serial, ImmutableArray<TranslationDiagnostic> serialDiagnostics) = Generate(CreateTransformedLibrary(), mode, parallel: false);
+
+            Assert.Equal(serial.FileNames, parallel.FileNames);
+            Assert.True(serial.FileNames.Count() > 1);
+
+            foreach (string fileName in serial.FileNames)
+            { Assert.Equal(serial.GetFile(fileName), parallel.GetFile(fileName)); }
+
+            Assert.Equal(serialDiagnostics.Select(d => d.ToString()), parallelDiagnostics.Select(d => d.ToString()));
+        }
+
+        private sealed record ThrowingDeclaration : TranslatedDeclaration, ICustomCSharpTranslatedDeclaration
+        {
+            public ThrowingDeclaration(TranslatedFile file, string name)
+                : base(file)
+                => Name = name;
+
+            void ICustomCSharpTranslatedDeclaration.GenerateOutput(ICSharpOutputGenerator outputGenerator, VisitorContext context, CSharpCodeWriter writer)
+                => throw new InvalidOperationException(Name);
+        }
+
+        [Theory]
+        [InlineData(true)]
+        [InlineData(false)]
+        public void FirstFailureIsThrown(bool parallel)
+        {
+            TranslatedLibrary library = CreateTransformedLibrary();
+            TranslatedFile file = library.Files.Single();
+            library = library with
+            {
+                Declarations = library.Declarations.AddRange(Enumerable.Range(0, 8).Select(i => new ThrowingDeclaration(file, $"Throwing{i}")))
+            };
+
+            InvalidOperationException exception = Assert.Throws<InvalidOperationException>(() => Generate(library, LibraryTranslationMode.OneFilePerType, parallel));
+            Assert.Equal("Throwing0", exception.Message);
+        }
+    }
+}
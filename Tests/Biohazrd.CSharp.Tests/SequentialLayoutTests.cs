@@ -0,0 +1,149 @@
+﻿using Biohazrd.Tests.Common;
+using Xunit;
+
+namespace Biohazrd.CSharp.Tests
+{
+    public sealed class SequentialLayoutTests : BiohazrdTestBase
+    {
+        private (string Code, string? SelfCheck) Generate(string cppCode, bool useSequentialLayout = true)
+        {
+            TranslatedLibrary library = CreateLibrary(cppCode);
+            library = new CSharpTypeReductionTransformation().Transform(library);
+            library = new MoveLooseDeclarationsIntoTypesTransformation().Transform(library);
+
+            CSharpGenerationOptions options = new() { DumpClangInfo = false, UseSequentialLayoutWhenPossible = useSequentialLayout };
+            InMemoryOutput output = GenerateInMemory(session => CSharpLibraryGenerator.Generate(options, session, library, LibraryTranslationMode.OneFile));
+            output.AssertCompiles();
+            return (output.GetFile("TranslatedLibrary.cs"), output.TryGetFile("SequentialLayoutSelfCheck.cs"));
+        }
+
+        [Fact]
+        public void DisabledByDefault()
+        {
+            (string code, string? selfCheck) = Generate("struct Vec2 { float X; float Y; };", useSequentialLayout: false);
+            Assert.Contains("[StructLayout(LayoutKind.Explicit, Size = 8)]", code);
+            Assert.Null(selfCheck);
+        }
+
+        [Fact]
+        public void NaturallyAlignedStruct()
+        {
+            (string code, string? selfCheck) = Generate("struct Vec3 { float X; float Y; float Z; };");
+            Assert.Contains("[StructLayout(LayoutKind.Sequential)]", code);
+            Assert.DoesNotContain("FieldOffset", code);
+            Assert.Contains("__VerifySequentialLayout()", code);
+            Assert.NotNull(selfCheck);
+            Assert.Contains("Vec3.__VerifySequentialLayout();", selfCheck);
+        }
+
+        [Fact]
+        public void PaddedStruct()
+        {
+            (string code, _) = Generate("struct Padded { char A; int B; short C; };");
+            Assert.Contains("[StructLayout(LayoutKind.Sequential)]", code);
+        }
+
+        [Fact]
+        public void PackedStruct()
+        {
+            (string code, _) = Generate
+            (@"
+#pragma pack(push, 1)
+struct Packed { char A; int B; };
+#pragma pack(pop)
+"
+            );
+            Assert.Contains("[StructLayout(LayoutKind.Sequential, Pack = 1)]", code);
+        }
+
+        [Fact]
+        public void NestedSequentialStruct()
+        {
+            (string code, string? selfCheck) = Generate
+            (@"
+struct Vec2 { float X; float Y; };
+struct Rect { Vec2 Min; Vec2 Max; };
+"
+            );
+            Assert.DoesNotContain("LayoutKind.Explicit", code);
+            Assert.NotNull(selfCheck);
+            Assert.Contains("Rect.__VerifySequentialLayout();", selfCheck);
+        }
+
+        [Fact]
+        public void SelfCheckUsesFullyQualifiedAccessibleNames()
+        {
+            (string code, string? selfCheck) = Generate
+            (@"
+namespace Geometry
+{
+    struct Vec2 { float X; float Y; };
+}
+
+struct Outer
+{
+    int A;
+private:
+    struct Inner { float X; float Y; };
+    Inner I;
+};
+"
+            );
+            Assert.NotNull(selfCheck);
+            Assert.Contains("global::Geometry.Vec2.__VerifySequentialLayout();", selfCheck);
+            Assert.Contains("global::Outer.__VerifySequentialLayout();", selfCheck);
+
+            // Private nested records can't be named from the library-wide check, so they're verified by their containing record
+            Assert.Contains("private unsafe partial struct Inner", code);
+            Assert.DoesNotContain("Inner.__VerifySequentialLayout();", selfCheck);
+            Assert.Contains("Inner.__VerifySequentialLayout();", code);
+        }
+
+        [Fact]
+        public void NestedRecordInExplicitRecordIsVerified()
+        {
+            (string code, string? selfCheck) = Generate
+            (@"
+union Outer
+{
+    int A;
+private:
+    struct Inner { float X; float Y; };
+    Inner I;
+};
+"
+            );
+            Assert.Contains("[StructLayout(LayoutKind.Explicit, Size = 8)]", code);
+            Assert.Contains("[StructLayout(LayoutKind.Sequential)]", code);
+
+            // The union has no layout of its own to verify, but it still needs a self-check so that its nested record's self-check is reachable
+            Assert.NotNull(selfCheck);
+            Assert.Contains("global::Outer.__VerifySequentialLayout();", selfCheck);
+            Assert.Contains("Inner.__VerifySequentialLayout();", code);
+        }
+
+        [Fact]
+        public void OverAlignedStructIsExplicit()
+        {
+            (string code, string? selfCheck) = Generate("struct alignas(16) Aligned { float X; };");
+            Assert.Contains("[StructLayout(LayoutKind.Explicit, Size = 16)]", code);
+            Assert.Null(selfCheck);
+        }
+
+        [Fact]
+        public void UnionIsExplicit()
+        {
+            (string code, _) = Generate("union Union { int A; float B; };");
+            Assert.Contains("LayoutKind.Explicit", code);
+            Assert.DoesNotContain("LayoutKind.Sequential", code);
+        }
+
+        [Fact]
+        public void BitFieldIsExplicit()
+        {
+            (string code, _) = Generate("struct BitFields { int A : 3; int B : 5; };");
+            Assert.Contains("LayoutKind.Explicit", code);
+            Assert.DoesNotContain("LayoutKind.Sequential", code);
+        }
+    }
+}
@@ -0,0 +1,73 @@
+﻿using Biohazrd.CSharp.Metadata;
+using Biohazrd.Tests.Common;
+using System.Linq;
+using Xunit;
+
+namespace Biohazrd.CSharp.Tests
+{
+    public sealed class SuppressGCTransitionTests : BiohazrdTestBase
+    {
+        private TranslatedLibrary CreateTransformedLibrary()
+        {
+            TranslatedLibrary library = CreateLibrary
+            (@"
+int GetValue();
+void WaitForValue();
+void Enumerate(void (*callback)(int));
+int Unmarked();
+int GetClock();
+bool IsSynced();
+void mutex_lock();
+void HTTPWait();
+"
+            );
+
+            library = new CSharpTypeReductionTransformation().Transform(library);
+            library = new MoveLooseDeclarationsIntoTypesTransformation().Transform(library);
+            library = new AddSuppressGCTransitionTransformation((context, function) => function.Name != "Unmarked").Transform(library);
+            return library;
+        }
+
+        [Fact]
+        public void MetadataApplied()
+        {
+            TranslatedLibrary library = CreateTransformedLibrary();
+            Assert.True(library.EnumerateRecursively().FindDeclaration<TranslatedFunction>("GetValue").Metadata.Has<SuppressGCTransitionFunction>());
+            Assert.False(library.EnumerateRecursively().FindDeclaration<TranslatedFunction>("Unmarked").Metadata.Has<SuppressGCTransitionFunction>());
+        }
+
+        [Fact]
+        public void VerifierWarnsAboutUnsafeFunctions()
+        {
+            TranslatedLibrary library = new CSharpTranslationVerifier().Transform(CreateTransformedLibrary());
+            Assert.DoesNotContain(library.EnumerateRecursively().FindDeclaration<TranslatedFunction>("GetValue").Diagnostics, d => d.Message.Contains("SuppressGCTransition"));
+            Assert.Contains(library.EnumerateRecursively().FindDeclaration<TranslatedFunction>("WaitForValue").Diagnostics, d => d.Severity == Severity.Warning && d.Message.Contains("block"));
+            Assert.Contains(library.EnumerateRecursively().FindDeclaration<TranslatedFunction>("Enumerate").Diagnostics, d => d.Severity == Severity.Warning && d.Message.Contains("callback"));
+        }
+
+        [Theory]
+        [InlineData("WaitForValue", true)]
+        [InlineData("mutex_lock", true)]
+        [InlineData("HTTPWait", true)]
+        [InlineData("GetClock", false)]
+        [InlineData("IsSynced", false)]
+        public void BlockingHeuristicMatchesWholeWords(string functionName, bool expectWarning)
+        {
+            TranslatedLibrary library = new CSharpTranslationVerifier().Transform(CreateTransformedLibrary());
+            TranslatedFunction function = library.EnumerateRecursively().FindDeclaration<TranslatedFunction>(functionName);
+            Assert.Equal(expectWarning, function.Diagnostics.Any(d => d.Severity == Severity.Warning && d.Message.Contains("block")));
+        }
+
+        [Theory]
+        [InlineData(NativeFunctionImportMode.DllImport, "[SuppressGCTransition]")]
+        [InlineData(NativeFunctionImportMode.LazyFunctionPointerTable, "delegate* unmanaged[Cdecl, SuppressGCTransition]<int>")]
+        public void GeneratorHonorsMetadata(NativeFunctionImportMode mode, string expected)
+        {
+            TranslatedLibrary library = CreateTransformedLibrary();
+
+            CSharpGenerationOptions options = new() { DumpClangInfo = false, FunctionImportMode = mode };
+            InMemoryOutput output = GenerateInMemory(session => CSharpLibraryGenerator.Generate(options, session, library, LibraryTranslationMode.OneFile));
+            Assert.Contains(expected, output.GetFile("TranslatedLibrary.cs"));
+        }
+    }
+}
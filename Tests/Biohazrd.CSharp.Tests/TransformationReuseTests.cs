@@ -0,0 +1,74 @@
+﻿using Biohazrd.Tests.Common;
+using Biohazrd.Transformation;
+using Biohazrd.Transformation.Common;
+using System;
+using System.Threading;
+using Xunit;
+
+namespace Biohazrd.CSharp.Tests
+{
+    public sealed class TransformationReuseTests : BiohazrdTestBase
+    {
+        private sealed class CancelOnFirstReport : IProgress<TranslationProgress>
+        {
+            private readonly CancellationTokenSource CancellationTokenSource;
+
+            public CancelOnFirstReport(CancellationTokenSource cancellationTokenSource)
+                => CancellationTokenSource = cancellationTokenSource;
+
+            public void Report(TranslationProgress value)
+                => CancellationTokenSource.Cancel();
+        }
+
+        private const string CppCode = @"
+struct A { bool x; char y; int z[4]; };
+void LooseFunction(bool b);
+void LooseFunction(bool b, char c);
+";
+
+        private static void AssertReusableAfterCancellation(RawTransformationBase transformation, TranslatedLibrary library)
+        {
+            // Cancel after the first top-level declaration so PreTransformLibrary has run but PostTransformLibrary has not
+            using CancellationTokenSource cancellationTokenSource = new();
+            Assert.ThrowsAny<OperationCanceledException>(() => transformation.Transform(library, cancellationTokenSource.Token, new CancelOnFirstReport(cancellationTokenSource)));
+
+            // The instance should be usable again without tripping over state left behind by the cancelled run
+            TranslatedLibrary result = transformation.Transform(library);
+            Assert.NotNull(result);
+        }
+
+        [Fact]
+        public void MoveLooseDeclarationsIntoTypes()
+        {
+            TranslatedLibrary library = CreateLibrary(CppCode);
+            MoveLooseDeclarationsIntoTypesTransformation transformation = new();
+            AssertReusableAfterCancellation(transformation, library);
+        }
+
+        [Fact]
+        public void WrapNonBlittableTypesWhereNecessary()
+        {
+            TranslatedLibrary library = CreateLibrary(CppCode);
+            library = new CSharpTypeReductionTransformation().Transform(library);
+            WrapNonBlittableTypesWhereNecessaryTransformation transformation = new() { WrapAllNonBlittableTypes = true };
+            AssertReusableAfterCancellation(transformation, library);
+        }
+
+        [Fact]
+        public void DeduplicateNames()
+        {
+            TranslatedLibrary library = CreateLibrary(CppCode);
+            DeduplicateNamesTransformation transformation = new();
+            AssertReusableAfterCancellation(transformation, library);
+        }
+
+        [Fact]
+        public void CSharpTypeReduction()
+        {
+            TranslatedLibrary library = CreateLibrary(CppCode);
+            CSharpTypeReductionTransformation transformation = new();
+            AssertReusableAfterCancellation(transformation, library);
+            Assert.Equal(1, transformation.ConstantArrayTypesCreated);
+        }
+    }
+}
@@ -1,4 +1,7 @@
-﻿using System.Linq;
+﻿using Biohazrd.OutputGeneration;
+using System;
+using System.IO;
+using System.Linq;
 using Xunit;
 
 namespace Biohazrd.Tests.Common
@@ -30,5 +33,16 @@ namespace Biohazrd.Tests.Common
             Assert.Empty(library.ParsingDiagnostics.Where(d => d.IsError));
             return library;
         }
+
+        /// <summary>Runs <paramref name="generate"/> against an output session which keeps its files in memory.</summary>
+        protected InMemoryOutput GenerateInMemory(Action<OutputSession> generate)
+        {
+            InMemoryOutputSink sink = new();
+            string outputDirectory = Path.Combine(Path.GetTempPath(), $"{GetType().Name}_{Guid.NewGuid():N}");
+            using (OutputSession session = new() { BaseOutputDirectory = outputDirectory, Sink = sink })
+            { generate(session); }
+
+            return new InMemoryOutput(sink, outputDirectory);
+        }
     }
 }
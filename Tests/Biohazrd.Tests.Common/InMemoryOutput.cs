@@ -0,0 +1,90 @@
+﻿using Biohazrd.OutputGeneration;
+using Microsoft.CodeAnalysis;
+using Microsoft.CodeAnalysis.CSharp;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Reflection;
+using Xunit;
+
+namespace Biohazrd.Tests.Common
+{
+    /// <summary>The output of a generation run which was kept in memory by <see cref="BiohazrdTestBase.GenerateInMemory(Action{OutputSession})"/>.</summary>
+    public sealed class InMemoryOutput
+    {
+        private readonly InMemoryOutputSink Sink;
+        private readonly string OutputDirectory;
+
+        internal InMemoryOutput(InMemoryOutputSink sink, string outputDirectory)
+        {
+            Sink = sink;
+            OutputDirectory = outputDirectory;
+        }
+
+        /// <summary>The names of all of the files which were generated, relative to the output directory.</summary>
+        public IEnumerable<string> FileNames
+            => Sink.Files.Keys.Select(filePath => Path.GetRelativePath(OutputDirectory, filePath)).OrderBy(fileName => fileName, StringComparer.Ordinal);
+
+        /// <summary>Gets the contents of the specified file, or null if it was not generated.</summary>
+        public string? TryGetFile(string fileName)
+            => Sink.GetFileText(Path.Combine(OutputDirectory, fileName));
+
+        /// <summary>Gets the contents of the specified file, asserting that it was generated.</summary>
+        public string GetFile(string fileName)
+        {
+            string? contents = TryGetFile(fileName);
+            Assert.True(contents is not null, $"'{fileName}' was not generated.");
+            return contents!;
+        }
+
+        /// <summary>Compiles all of the generated C# files together and asserts that there are no errors.</summary>
+        /// <remarks>The code is compiled against the runtime the tests are running on with no preprocessor symbols defined.</remarks>
+        public void AssertCompiles()
+        {
+            CSharpParseOptions parseOptions = new(LanguageVersion.CSharp9);
+            List<SyntaxTree> syntaxTrees = new();
+            foreach (string fileName in FileNames)
+            {
+                if (Path.GetExtension(fileName) == ".cs")
+                { syntaxTrees.Add(CSharpSyntaxTree.ParseText(GetFile(fileName), parseOptions, fileName)); }
+            }
+
+            Assert.NotEmpty(syntaxTrees);
+
+            CSharpCompilation compilation = CSharpCompilation.Create
+            (
+                "GeneratedOutput",
+                syntaxTrees,
+                GetRuntimeReferences(),
+                new CSharpCompilationOptions(OutputKind.DynamicallyLinkedLibrary, allowUnsafe: true)
+            );
+
+            Diagnostic[] errors = compilation.GetDiagnostics().Where(d => d.Severity == DiagnosticSeverity.Error).ToArray();
+            Assert.True(errors.Length == 0, $"The generated code failed to compile:\n{String.Join('\n', errors.Select(e => e.ToString()))}");
+        }
+
+        private static List<MetadataReference>? RuntimeReferences;
+        private static List<MetadataReference> GetRuntimeReferences()
+        {
+            if (RuntimeReferences is not null)
+            { return RuntimeReferences; }
+
+            List<MetadataReference> references = new();
+            string trustedPlatformAssemblies = (string)AppContext.GetData("TRUSTED_PLATFORM_ASSEMBLIES")!;
+            foreach (string assemblyPath in trustedPlatformAssemblies.Split(Path.PathSeparator, StringSplitOptions.RemoveEmptyEntries))
+            {
+                // Skip any native libraries in the list
+                try
+                { AssemblyName.GetAssemblyName(assemblyPath); }
+                catch (BadImageFormatException)
+                { continue; }
+
+                references.Add(MetadataReference.CreateFromFile(assemblyPath));
+            }
+
+            RuntimeReferences = references;
+            return references;
+        }
+    }
+}
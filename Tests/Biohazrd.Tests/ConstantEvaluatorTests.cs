@@ -3,7 +3,9 @@ using Biohazrd.Tests.Common;
 using System;
 using System.Collections.Generic;
 using System.Collections.Immutable;
+using System.IO;
 using System.Linq;
+using System.Threading.Tasks;
 using Xunit;
 
 namespace Biohazrd.Tests
@@ -294,5 +296,230 @@ namespace Biohazrd.Tests
             AssertMacro(results[0], "TEST_1", 111);
             AssertMacro(results[2], "TEST_3", 333);
         }
+
+        [Fact]
+        public void EvaluateBatch_LooseDiagnosticsReportedOnce()
+        {
+            TranslatedLibraryBuilder builder = CreateLibraryBuilder
+            (@"
+#define TEST 3226
+int x = ;
+"
+            );
+            TranslatedLibraryConstantEvaluator evaluator = builder.CreateConstantEvaluator();
+
+            List<string> expressions = Enumerable.Range(0, 5).Select(i => $"TEST + {i}").ToList();
+            ImmutableArray<ConstantEvaluationResult> results = evaluator.EvaluateBatch(expressions, out ImmutableArray<TranslationDiagnostic> batchDiagnostics);
+            Assert.Equal(expressions.Count, results.Length);
+
+            // The error from the header belongs to the batch rather than to each evaluation
+            Assert.Single(batchDiagnostics, d => d.IsError);
+
+            for (int i = 0; i < expressions.Count; i++)
+            {
+                Assert.Empty(results[i].Diagnostics);
+                IntegerConstant value = Assert.IsType<IntegerConstant>(results[i].Value);
+                Assert.Equal(3226UL + (ulong)i, value.Value);
+            }
+        }
+
+        [Fact]
+        public void EvaluateBatch_LooseDiagnosticsInBatchResult()
+        {
+            TranslatedLibraryBuilder builder = CreateLibraryBuilder
+            (@"
+#define TEST 3226
+int x = ;
+"
+            );
+
+            using (TranslatedLibraryConstantEvaluator evaluator = builder.CreateConstantEvaluator())
+            {
+                ConstantEvaluationBatchResult results = evaluator.EvaluateBatch(new[] { "TEST", "TEST + 1" });
+                Assert.Equal(2, results.Length);
+                Assert.Single(results.BatchDiagnostics, d => d.IsError);
+
+                // Single evaluations have no batch to report the diagnostics on, so they're attached to the result
+                ConstantEvaluationResult result = evaluator.Evaluate("TEST");
+                Assert.Equal(3226UL, Assert.IsType<IntegerConstant>(result.Value).Value);
+                Assert.Single(result.Diagnostics, d => d.IsError);
+            }
+
+            using (TranslatedLibraryConstantEvaluatorPool pool = builder.CreateConstantEvaluatorPool(degreeOfParallelism: 2))
+            {
+                ConstantEvaluationBatchResult results = pool.EvaluateBatch(new[] { "TEST", "TEST + 1", "TEST + 2" });
+                Assert.Equal(3, results.Length);
+                Assert.Single(results.BatchDiagnostics, d => d.IsError);
+            }
+        }
+
+        [Fact]
+        public void EvaluateBatch_Pool()
+        {
+            TranslatedLibraryBuilder builder = CreateLibraryBuilder("#define TEST 3226");
+            using TranslatedLibraryConstantEvaluatorPool pool = builder.CreateConstantEvaluatorPool(degreeOfParallelism: 3);
+            pool.MinimumShardSize = 1;
+
+            List<string> expressions = Enumerable.Range(0, 10).Select(i => $"TEST + {i}").ToList();
+            expressions[4] = "TEST +";
+            ImmutableArray<ConstantEvaluationResult> results = pool.EvaluateBatch(expressions);
+            Assert.Equal(expressions.Count, results.Length);
+
+            for (int i = 0; i < expressions.Count; i++)
+            {
+                Assert.Equal(expressions[i], results[i].Expression);
+
+                if (i == 4)
+                {
+                    Assert.Contains(results[i].Diagnostics, d => d.IsError);
+                    Assert.Null(results[i].Value);
+                    continue;
+                }
+
+                Assert.Empty(results[i].Diagnostics);
+                IntegerConstant value = Assert.IsType<IntegerConstant>(results[i].Value);
+                Assert.Equal(3226UL + (ulong)i, value.Value);
+            }
+        }
+
+        [Fact]
+        public void PrecompiledHeader()
+        {
+            string precompiledHeaderPath = Path.Combine(Path.GetTempPath(), $"Biohazrd.{Guid.NewGuid()}.pch");
+            try
+            {
+                TranslatedLibraryBuilder builder = CreateLibraryBuilder
+                (@"
+#define TEST 3226
+struct MyStruct { int x; };
+"
+                );
+                builder.PrecompiledHeaderPath = precompiledHeaderPath;
+                TranslatedLibrary library = builder.Create();
+                Assert.True(File.Exists(precompiledHeaderPath));
+
+                using TranslatedLibraryConstantEvaluator evaluator = builder.CreateConstantEvaluator();
+                Assert.True(evaluator.IsUsingPrecompiledHeader);
+
+                ImmutableArray<ConstantEvaluationResult> results = evaluator.EvaluateBatch(new[] { "TEST", "sizeof(MyStruct)" });
+                Assert.Empty(results[0].Diagnostics);
+                Assert.Equal(3226UL, Assert.IsType<IntegerConstant>(results[0].Value).Value);
+                Assert.Empty(results[1].Diagnostics);
+                Assert.Equal(4UL, Assert.IsType<IntegerConstant>(results[1].Value).Value);
+            }
+            finally
+            {
+                if (File.Exists(precompiledHeaderPath))
+                { File.Delete(precompiledHeaderPath); }
+            }
+        }
+
+        [Fact]
+        public void EvaluationCache()
+        {
+            string cachePath = Path.Combine(Path.GetTempPath(), $"Biohazrd.{Guid.NewGuid()}.cache");
+            try
+            {
+                ImmutableArray<ConstantEvaluationResult> Evaluate()
+                {
+                    TranslatedLibraryBuilder builder = CreateLibraryBuilder("#define TEST 3226");
+                    builder.ConstantEvaluationCachePath = cachePath;
+                    using TranslatedLibraryConstantEvaluator evaluator = builder.CreateConstantEvaluator();
+                    return evaluator.EvaluateBatch(new[] { "TEST", "TEST +", "1.5f", "\"Hello\"" });
+                }
+
+                ImmutableArray<ConstantEvaluationResult> coldResults = Evaluate();
+                Assert.True(File.Exists(cachePath));
+                ImmutableArray<ConstantEvaluationResult> warmResults = Evaluate();
+
+                Assert.Equal(coldResults.Length, warmResults.Length);
+                for (int i = 0; i < coldResults.Length; i++)
+                {
+                    Assert.Equal(coldResults[i].Expression, warmResults[i].Expression);
+                    Assert.Equal(coldResults[i].Value, warmResults[i].Value);
+                    Assert.Equal(coldResults[i].Diagnostics.Select(d => (d.Severity, d.Message)), warmResults[i].Diagnostics.Select(d => (d.Severity, d.Message)));
+                    Assert.Equal(coldResults[i].Diagnostics.Select(d => d.Location.ToString(true)), warmResults[i].Diagnostics.Select(d => d.Location.ToString(true)));
+                }
+
+                Assert.Equal(3226UL, Assert.IsType<IntegerConstant>(warmResults[0].Value).Value);
+                Assert.Contains(warmResults[1].Diagnostics, d => d.IsError);
+            }
+            finally
+            {
+                if (File.Exists(cachePath))
+                { File.Delete(cachePath); }
+            }
+        }
+
+        [Fact]
+        public void EvaluationCache_IncludedHeaderChanged()
+        {
+            string directory = Path.Combine(Path.GetTempPath(), $"Biohazrd.{Guid.NewGuid()}");
+            string headerPath = Path.Combine(directory, "Included.h");
+            string cachePath = Path.Combine(directory, "Evaluation.cache");
+            Directory.CreateDirectory(directory);
+            try
+            {
+                ulong Evaluate()
+                {
+                    // The header is only reached via #include, so it isn't part of the cache key
+                    TranslatedLibraryBuilder builder = CreateLibraryBuilder($"#include \"{headerPath}\"");
+                    builder.ConstantEvaluationCachePath = cachePath;
+                    using TranslatedLibraryConstantEvaluator evaluator = builder.CreateConstantEvaluator();
+                    ImmutableArray<ConstantEvaluationResult> results = evaluator.EvaluateBatch(new[] { "TEST" });
+                    return Assert.IsType<IntegerConstant>(results[0].Value).Value;
+                }
+
+                File.WriteAllText(headerPath, "#define TEST 3226");
+                Assert.Equal(3226UL, Evaluate());
+                Assert.True(File.Exists(cachePath));
+
+                // Same size so the change would not be noticed by anything looking at the file's length
+                File.WriteAllText(headerPath, "#define TEST 4242");
+                Assert.Equal(4242UL, Evaluate());
+            }
+            finally
+            { Directory.Delete(directory, recursive: true); }
+        }
+
+        [Fact]
+        public void EvaluateBatch_Chunked()
+        {
+            TranslatedLibraryBuilder builder = CreateLibraryBuilder("#define TEST 3226");
+            using TranslatedLibraryConstantEvaluator evaluator = builder.CreateConstantEvaluator();
+            evaluator.MaximumChunkSize = 3;
+
+            List<string> expressions = Enumerable.Range(0, 10).Select(i => $"TEST + {i}").ToList();
+            expressions[5] = "TEST +";
+            ImmutableArray<ConstantEvaluationResult> results = evaluator.EvaluateBatch(expressions);
+            Assert.Equal(expressions.Count, results.Length);
+
+            for (int i = 0; i < expressions.Count; i++)
+            {
+                Assert.Equal(expressions[i], results[i].Expression);
+
+                if (i == 5)
+                {
+                    Assert.Contains(results[i].Diagnostics, d => d.IsError);
+                    continue;
+                }
+
+                Assert.Empty(results[i].Diagnostics);
+                Assert.Equal(3226UL + (ulong)i, Assert.IsType<IntegerConstant>(results[i].Value).Value);
+            }
+        }
+
+        [Fact]
+        public async Task EvaluateBatchAsync()
+        {
+            TranslatedLibraryBuilder builder = CreateLibraryBuilder("#define TEST 3226");
+            TranslatedLibrary library = builder.Create();
+            using TranslatedLibraryConstantEvaluator evaluator = builder.CreateConstantEvaluator();
+
+            Task<ConstantEvaluationBatchResult> evaluation = evaluator.EvaluateBatchAsync(library.Macros);
+            ConstantEvaluationResult result = Assert.Single(await evaluation);
+            Assert.Equal("TEST", result.Expression);
+            Assert.Equal(3226UL, Assert.IsType<IntegerConstant>(result.Value).Value);
+        }
     }
 }
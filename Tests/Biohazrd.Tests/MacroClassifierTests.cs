@@ -0,0 +1,132 @@
+﻿using Biohazrd.Expressions;
+using Biohazrd.Tests.Common;
+using System.Collections.Generic;
+using System.Collections.Immutable;
+using System.Linq;
+using Xunit;
+
+namespace Biohazrd.Tests
+{
+    public sealed class MacroClassifierTests : BiohazrdTestBase
+    {
+        private MacroClassification Classify(string macroDefinition, out ConstantValue? literalValue)
+        {
+            TranslatedLibrary library = CreateLibrary($"#define {macroDefinition}");
+            TranslatedMacro macro = Assert.Single(library.Macros);
+            return MacroClassifier.Classify(macro, out literalValue);
+        }
+
+        private MacroClassification Classify(string macroDefinition)
+            => Classify(macroDefinition, out _);
+
+        [Fact]
+        public void ReplacementText()
+        {
+            TranslatedLibrary library = CreateLibrary("#define TEST(x, y) ((x) + \\\n (y)) // Comment");
+            TranslatedMacro macro = Assert.Single(library.Macros);
+            Assert.Equal("((x) +   (y)) // Comment", macro.ReplacementText);
+        }
+
+        [Fact]
+        public void Empty()
+        {
+            Assert.Equal(MacroClassification.Empty, Classify("TEST"));
+            Assert.Equal(MacroClassification.Empty, Classify("TEST /* Comment */"));
+        }
+
+        [Fact]
+        public void NotConstant()
+        {
+            Assert.Equal(MacroClassification.NotConstant, Classify("TEST __stdcall"));
+            Assert.Equal(MacroClassification.NotConstant, Classify("TEST __declspec(dllimport)"));
+            Assert.Equal(MacroClassification.NotConstant, Classify("TEST unsigned int"));
+            Assert.Equal(MacroClassification.NotConstant, Classify("TEST(x) ((x) + 1)"));
+            Assert.Equal(MacroClassification.NotConstant, Classify("TEST() do { } while (0)"));
+            Assert.Equal(MacroClassification.NotConstant, Classify("TEST struct hdr"));
+            Assert.Equal(MacroClassification.NotConstant, Classify("TEST volatile int"));
+            Assert.Equal(MacroClassification.NotConstant, Classify("TEST (sizeof(int)) + (struct hdr *)0"));
+        }
+
+        [Fact]
+        public void LikelyConstant()
+        {
+            Assert.Equal(MacroClassification.LikelyConstant, Classify("TEST (1 << 4)"));
+            Assert.Equal(MacroClassification.LikelyConstant, Classify("TEST 10L"));
+            Assert.Equal(MacroClassification.LikelyConstant, Classify("TEST 'a'"));
+            Assert.Equal(MacroClassification.LikelyConstant, Classify("TEST L\"Hello\""));
+        }
+
+        [Fact]
+        public void LikelyConstant_ElaboratedTypeOperand()
+        {
+            Assert.Equal(MacroClassification.LikelyConstant, Classify("TEST sizeof(struct hdr)"));
+            Assert.Equal(MacroClassification.LikelyConstant, Classify("TEST (sizeof(union u) * 2)"));
+            Assert.Equal(MacroClassification.LikelyConstant, Classify("TEST alignof(enum e)"));
+            Assert.Equal(MacroClassification.LikelyConstant, Classify("TEST sizeof(volatile int)"));
+            Assert.Equal(MacroClassification.LikelyConstant, Classify("TEST offsetof(struct s, f)"));
+            Assert.Equal(MacroClassification.LikelyConstant, Classify("TEST sizeof(((struct hdr *)0)->field)"));
+        }
+
+        [Theory]
+        [InlineData("3226", 32, true, 3226UL)]
+        [InlineData("(-3226)", 32, true, unchecked((ulong)-3226L))]
+        [InlineData("0xFFFFFFFF", 32, false, 0xFFFFFFFFUL)]
+        [InlineData("4294967295", 64, true, 4294967295UL)]
+        [InlineData("0x10u", 32, false, 16UL)]
+        [InlineData("1ull", 64, false, 1UL)]
+        [InlineData("010", 32, true, 8UL)]
+        public void TriviallyLiteral_Integer(string value, int sizeBits, bool isSigned, ulong expectedValue)
+        {
+            Assert.Equal(MacroClassification.TriviallyLiteral, Classify($"TEST {value}", out ConstantValue? literalValue));
+            IntegerConstant integer = Assert.IsType<IntegerConstant>(literalValue);
+            Assert.Equal(sizeBits, integer.SizeBits);
+            Assert.Equal(isSigned, integer.IsSigned);
+            Assert.Equal(expectedValue, integer.Value);
+        }
+
+        [Fact]
+        public void TriviallyLiteral_FloatingPoint()
+        {
+            Assert.Equal(MacroClassification.TriviallyLiteral, Classify("TEST 1.5f", out ConstantValue? floatValue));
+            Assert.Equal(1.5f, Assert.IsType<FloatConstant>(floatValue).Value);
+
+            Assert.Equal(MacroClassification.TriviallyLiteral, Classify("TEST -2.5e3", out ConstantValue? doubleValue));
+            Assert.Equal(-2500.0, Assert.IsType<DoubleConstant>(doubleValue).Value);
+        }
+
+        [Fact]
+        public void TriviallyLiteral_String()
+        {
+            Assert.Equal(MacroClassification.TriviallyLiteral, Classify("TEST \"Hello\"", out ConstantValue? literalValue));
+            Assert.Equal("Hello", Assert.IsType<StringConstant>(literalValue).Value);
+        }
+
+        [Fact]
+        public void EvaluateConstants_MatchesClang()
+        {
+            TranslatedLibraryBuilder builder = CreateLibraryBuilder
+            (@"
+#define GUARD
+#define CALLBACK __stdcall
+#define A 3226
+#define B (A + 1)
+#define C 0xFFFFFFFF
+#define D 1.5f
+"
+            );
+            TranslatedLibrary library = builder.Create();
+            using TranslatedLibraryConstantEvaluator evaluator = builder.CreateConstantEvaluator();
+
+            List<TranslatedMacro> macros = library.Macros.Where(m => m.File != TranslatedFile.Synthesized).ToList();
+            ImmutableArray<(TranslatedMacro Macro, ConstantEvaluationResult Result)> results = MacroClassifier.EvaluateConstants(evaluator, macros);
+            Assert.Equal(new[] { "A", "B", "C", "D" }, results.Select(r => r.Macro.Name));
+
+            ImmutableArray<ConstantEvaluationResult> clangResults = evaluator.EvaluateBatch(results.Select(r => r.Macro));
+            for (int i = 0; i < results.Length; i++)
+            {
+                Assert.Equal(clangResults[i].Expression, results[i].Result.Expression);
+                Assert.Equal(clangResults[i].Value, results[i].Result.Value);
+            }
+        }
+    }
+}
@@ -0,0 +1,98 @@
+﻿using Biohazrd.Tests.Common;
+using Biohazrd.Transformation.Common;
+using Xunit;
+
+namespace Biohazrd.Transformation.Tests
+{
+    public sealed class DiagnosticLogTests : BiohazrdTestBase
+    {
+        private sealed class WarnOnRecordsTransformation : TransformationBase
+        {
+            protected override TransformationResult TransformRecord(TransformationContext context, TranslatedRecord declaration)
+                => context.AddDiagnostic(declaration, Severity.Warning, "Test warning");
+        }
+
+        [Fact]
+        public void DiagnosticsAreAddedToDeclarationsWithoutLog()
+        {
+            TranslatedLibrary library = CreateLibrary("struct A { int x; };");
+            TranslatedRecord original = library.FindDeclaration<TranslatedRecord>("A");
+
+            library = new WarnOnRecordsTransformation().Transform(library);
+            TranslatedRecord transformed = library.FindDeclaration<TranslatedRecord>("A");
+
+            Assert.NotReferenceEqual(original, transformed);
+            Assert.Contains(transformed.Diagnostics, d => d.Message == "Test warning");
+            Assert.Contains(library.GetDiagnostics(transformed), d => d.Message == "Test warning");
+        }
+
+        [Fact]
+        public void DiagnosticsAreLoggedWithLog()
+        {
+            TranslatedLibrary library = CreateLibrary("struct A { int x; };");
+            library = library with { DiagnosticLog = TranslationDiagnosticLog.Empty };
+            TranslatedRecord original = library.FindDeclaration<TranslatedRecord>("A");
+
+            TranslatedLibrary transformedLibrary = new WarnOnRecordsTransformation().Transform(library);
+            TranslatedRecord transformed = transformedLibrary.FindDeclaration<TranslatedRecord>("A");
+
+            // The declaration tree should not need to be rebuilt
+            Assert.ReferenceEqual(library.Declarations, transformedLibrary.Declarations);
+            Assert.ReferenceEqual(original, transformed);
+            Assert.DoesNotContain(transformed.Diagnostics, d => d.Message == "Test warning");
+            Assert.Contains(transformedLibrary.GetDiagnostics(transformed), d => d.Message == "Test warning");
+        }
+
+        [Fact]
+        public void OriginalLibraryIsNotModified()
+        {
+            TranslatedLibrary library = CreateLibrary("struct A { int x; };");
+            library = library with { DiagnosticLog = TranslationDiagnosticLog.Empty };
+            TranslatedRecord original = library.FindDeclaration<TranslatedRecord>("A");
+
+            new WarnOnRecordsTransformation().Transform(library);
+            Assert.Empty(library.GetDiagnostics(original));
+        }
+
+        [Fact]
+        public void BranchesDoNotShareDiagnostics()
+        {
+            TranslatedLibrary library = CreateLibrary("struct A { int x; };");
+            library = library with { DiagnosticLog = TranslationDiagnosticLog.Empty };
+            TranslatedRecord original = library.FindDeclaration<TranslatedRecord>("A");
+
+            // Running the same pass on the same library twice (IE: after discarding the first result) must not duplicate diagnostics
+            TranslatedLibrary branch1 = new WarnOnRecordsTransformation().Transform(library);
+            TranslatedLibrary branch2 = new WarnOnRecordsTransformation().Transform(library);
+            Assert.Single(branch1.GetDiagnostics(original));
+            Assert.Single(branch2.GetDiagnostics(original));
+
+            // Further transforming one branch must not affect the other
+            TranslatedLibrary branch1Again = new WarnOnRecordsTransformation().Transform(branch1);
+            Assert.Equal(2, branch1Again.GetDiagnostics(original).Length);
+            Assert.Single(branch1.GetDiagnostics(original));
+            Assert.Single(branch2.GetDiagnostics(original));
+        }
+
+        private sealed class ErrorOnRecordsTransformation : TransformationBase
+        {
+            protected override TransformationResult TransformRecord(TransformationContext context, TranslatedRecord declaration)
+                => context.AddDiagnostic(declaration, Severity.Error, "Test error");
+        }
+
+        [Fact]
+        public void BrokenDeclarationsKeepLoggedDiagnostics()
+        {
+            TranslatedLibrary library = CreateLibrary("struct A { int x; };");
+            library = library with { DiagnosticLog = TranslationDiagnosticLog.Empty };
+            library = new ErrorOnRecordsTransformation().Transform(library);
+
+            BrokenDeclarationExtractor brokenDeclarations = new();
+            library = brokenDeclarations.Transform(library);
+
+            Assert.DoesNotContain(library, d => d.Name == "A");
+            TranslatedDeclaration broken = Assert.Single(brokenDeclarations.BrokenDeclarations);
+            Assert.Contains(brokenDeclarations.GetDiagnostics(broken), d => d.Message == "Test error");
+        }
+    }
+}
@@ -476,5 +476,73 @@ public:
             TranslatedFunction virtualMethod = library.FindDeclaration<TranslatedRecord>("Test").FindDeclaration<TranslatedFunction>("VirtualMethod");
             Assert.Contains(virtualMethod.Diagnostics, d => d.IsError && d.Message.Contains("Could not resolve"));
         }
+
+        private const string FinalMethodsCode = @"
+class Test
+{
+public:
+    virtual void VirtualMethod();
+    virtual void FinalMethod() final;
+};
+
+class FinalTest final
+{
+public:
+    virtual void VirtualMethod();
+};
+";
+
+        [Fact]
+        public void FinalMethodsAreParsed()
+        {
+            TranslatedLibrary library = CreateLibrary(FinalMethodsCode, "x86_64-pc-win32");
+
+            TranslatedRecord test = library.FindDeclaration<TranslatedRecord>("Test");
+            Assert.False(test.IsFinal);
+            Assert.False(test.FindDeclaration<TranslatedFunction>("VirtualMethod").IsFinal);
+            Assert.True(test.FindDeclaration<TranslatedFunction>("FinalMethod").IsFinal);
+
+            TranslatedRecord finalTest = library.FindDeclaration<TranslatedRecord>("FinalTest");
+            Assert.True(finalTest.IsFinal);
+            Assert.True(finalTest.FindDeclaration<TranslatedFunction>("VirtualMethod").IsFinal);
+        }
+
+        [Fact]
+        public void FinalMethodsAreDevirtualized()
+        {
+            TranslatedLibrary library = CreateLibrary(FinalMethodsCode, "x86_64-pc-win32");
+            TranslatedRecord test = library.FindDeclaration<TranslatedRecord>("Test");
+            TranslatedRecord finalTest = library.FindDeclaration<TranslatedRecord>("FinalTest");
+
+            LinkImportsTransformation transformation = new();
+            CreateImportLib
+            (
+                transformation,
+                nameof(FinalMethodsAreDevirtualized),
+                test.FindDeclaration<TranslatedFunction>("VirtualMethod").MangledName,
+                test.FindDeclaration<TranslatedFunction>("FinalMethod").MangledName,
+                finalTest.FindDeclaration<TranslatedFunction>("VirtualMethod").MangledName
+            );
+            library = transformation.Transform(library);
+            test = library.FindDeclaration<TranslatedRecord>("Test");
+            finalTest = library.FindDeclaration<TranslatedRecord>("FinalTest");
+
+            Assert.False(test.FindDeclaration<TranslatedFunction>("VirtualMethod").IsDevirtualized);
+            Assert.True(test.FindDeclaration<TranslatedFunction>("FinalMethod").IsDevirtualized);
+            Assert.True(finalTest.FindDeclaration<TranslatedFunction>("VirtualMethod").IsDevirtualized);
+        }
+
+        [Fact]
+        public void FinalMethodsAreNotDevirtualizedWhenMissing()
+        {
+            LinkImportsTransformation transformation = new();
+            CreateImportLib(transformation, nameof(FinalMethodsAreNotDevirtualizedWhenMissing), "UnrelatedFunction");
+            TranslatedLibrary library = CreateLibrary(FinalMethodsCode, "x86_64-pc-win32");
+            library = transformation.Transform(library);
+
+            TranslatedFunction finalMethod = library.FindDeclaration<TranslatedRecord>("Test").FindDeclaration<TranslatedFunction>("FinalMethod");
+            Assert.True(finalMethod.IsFinal);
+            Assert.False(finalMethod.IsDevirtualized);
+        }
     }
 }
@@ -0,0 +1,66 @@
+﻿using Biohazrd.Tests.Common;
+using System;
+using System.Collections.Generic;
+using System.Threading;
+using Xunit;
+
+namespace Biohazrd.Transformation.Tests
+{
+    public sealed class TransformationCancellationTests : BiohazrdTestBase
+    {
+        private sealed class ProgressRecorder : IProgress<TranslationProgress>
+        {
+            public List<TranslationProgress> Reports { get; } = new();
+
+            public void Report(TranslationProgress value)
+                => Reports.Add(value);
+        }
+
+        private sealed class IdentityTransformation : TransformationBase
+        { }
+
+        private sealed class CancelOnRecordTransformation : TransformationBase
+        {
+            private readonly CancellationTokenSource CancellationTokenSource;
+
+            public CancelOnRecordTransformation(CancellationTokenSource cancellationTokenSource)
+                => CancellationTokenSource = cancellationTokenSource;
+
+            protected override TransformationResult TransformRecord(TransformationContext context, TranslatedRecord declaration)
+            {
+                CancellationTokenSource.Cancel();
+                return declaration;
+            }
+        }
+
+        [Fact]
+        public void ProgressIsReportedPerTopLevelDeclaration()
+        {
+            TranslatedLibrary library = CreateLibrary("struct A { int x; }; struct B { int y; }; void C();");
+            ProgressRecorder progress = new();
+
+            new IdentityTransformation().Transform(library, progress: progress);
+
+            Assert.Equal(library.Declarations.Count, progress.Reports.Count);
+            for (int i = 0; i < progress.Reports.Count; i++)
+            {
+                Assert.Equal(i + 1, progress.Reports[i].Completed);
+                Assert.Equal(library.Declarations.Count, progress.Reports[i].Total);
+            }
+        }
+
+        [Fact]
+        public void CancellationStopsTransformation()
+        {
+            TranslatedLibrary library = CreateLibrary("struct A { int x; }; struct B { int y; };");
+            using CancellationTokenSource cancellationTokenSource = new();
+            CancelOnRecordTransformation transformation = new(cancellationTokenSource);
+
+            Assert.ThrowsAny<OperationCanceledException>(() => transformation.Transform(library, cancellationTokenSource.Token));
+
+            // The transformation should still be usable after being cancelled
+            library = transformation.Transform(library);
+            Assert.NotNull(library.FindDeclaration<TranslatedRecord>("B"));
+        }
+    }
+}
@@ -0,0 +1,78 @@
+﻿using Biohazrd.Tests.Common;
+using System;
+using System.Linq;
+using Xunit;
+
+namespace Biohazrd.Transformation.Tests
+{
+    public sealed class TranslatedLibraryEditTests : BiohazrdTestBase
+    {
+        [Fact]
+        public void NoEditsReturnsSameLibrary()
+        {
+            TranslatedLibrary library = CreateLibrary("struct A { int x; };");
+            TranslatedLibrary edited = library.Edit(edit => { });
+            Assert.ReferenceEqual(library, edited);
+        }
+
+        [Fact]
+        public void BatchedEdits()
+        {
+            TranslatedLibrary library = CreateLibrary
+            (@"
+struct A { int x; int y; };
+struct B { int z; };
+void C();
+"
+            );
+
+            TranslatedRecord a = library.FindDeclaration<TranslatedRecord>("A");
+            TranslatedNormalField x = a.FindDeclaration<TranslatedNormalField>("x");
+            TranslatedNormalField y = a.FindDeclaration<TranslatedNormalField>("y");
+            TranslatedRecord b = library.FindDeclaration<TranslatedRecord>("B");
+            TranslatedFunction c = library.FindDeclaration<TranslatedFunction>("C");
+            TranslatedDeclaration renamedC = c with { Name = "D" };
+
+            library = library.Edit(edit =>
+            {
+                edit.Remove(x);
+                edit.Replace(y, y with { Name = "y2" });
+                edit.AddDiagnostic(y.Id, Severity.Warning, "Test warning");
+                edit.AddDiagnostic(c, Severity.Warning, "Another test warning");
+                edit.Add(renamedC);
+            });
+
+            TranslatedRecord newA = library.FindDeclaration<TranslatedRecord>("A");
+            Assert.DoesNotContain(newA, m => m.Name == "x");
+            TranslatedNormalField newY = newA.FindDeclaration<TranslatedNormalField>("y2");
+            Assert.Contains(newY.Diagnostics, d => d.Message == "Test warning");
+
+            // Unrelated parts of the tree should not be rebuilt
+            Assert.ReferenceEqual(b, library.FindDeclaration<TranslatedRecord>("B"));
+
+            Assert.Contains(library.FindDeclaration<TranslatedFunction>("C").Diagnostics, d => d.Message == "Another test warning");
+            Assert.ReferenceEqual(renamedC, library.Declarations.Last());
+        }
+
+        [Fact]
+        public void MissingDeclarationThrows()
+        {
+            TranslatedLibrary library = CreateLibrary("struct A { int x; };");
+            DeclarationId missingId = DeclarationId.NewId();
+            Assert.Throws<InvalidOperationException>(() => library.Edit(edit => edit.Remove(missingId)));
+        }
+
+        [Fact]
+        public void ConflictingEditsThrow()
+        {
+            TranslatedLibrary library = CreateLibrary("struct A { int x; };");
+            TranslatedRecord a = library.FindDeclaration<TranslatedRecord>("A");
+
+            Assert.Throws<InvalidOperationException>(() => library.Edit(edit =>
+            {
+                edit.Remove(a);
+                edit.Replace(a, a with { Name = "B" });
+            }));
+        }
+    }
+}
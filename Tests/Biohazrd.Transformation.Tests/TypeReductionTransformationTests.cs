@@ -1,6 +1,7 @@
 ﻿using Biohazrd.CSharp;
 using Biohazrd.Tests.Common;
 using Biohazrd.Transformation.Common;
+using ClangSharp;
 using ClangSharp.Interop;
 using Xunit;
 
@@ -341,5 +342,49 @@ OtherTypedef TestFunction();
             TranslatedFunction function = library.FindDeclaration<TranslatedFunction>("TestFunction");
             Assert.Equal(CXTypeKind.CXType_Int, Assert.IsType<ClangTypeReference>(function.ReturnType).ClangType.Kind);
         }
+
+        [Fact]
+        public void EquivalentTypesShareInstances()
+        {
+            TranslatedLibrary library = CreateLibrary(@"void Test(int* a, int* b);");
+            library = new TypeReductionTransformation().Transform(library);
+
+            TranslatedFunction function = library.FindDeclaration<TranslatedFunction>("Test");
+            TypeReference a = function.FindDeclaration<TranslatedParameter>("a").Type;
+            TypeReference b = function.FindDeclaration<TranslatedParameter>("b").Type;
+            Assert.IsType<PointerTypeReference>(a);
+            Assert.ReferenceEqual(a, b);
+        }
+
+        [Fact]
+        public void EquivalentFunctionPointersAreEqual()
+        {
+            TranslatedLibrary library = CreateLibrary(@"void Test(void (*a)(int), void (*b)(int));");
+            library = new TypeReductionTransformation().Transform(library);
+
+            TranslatedFunction function = library.FindDeclaration<TranslatedFunction>("Test");
+            TypeReference a = AssertVoidIntFunctionPointerType(function.FindDeclaration<TranslatedParameter>("a").Type);
+            TypeReference b = AssertVoidIntFunctionPointerType(function.FindDeclaration<TranslatedParameter>("b").Type);
+            Assert.Equal(a, b);
+            Assert.Equal(a.GetHashCode(), b.GetHashCode());
+        }
+
+        [Fact]
+        public void ContextDependentReductionsAreNotShared()
+        {
+            TranslatedLibrary library = CreateLibrary
+            (@"
+void Test(int a[10]);
+struct MyStruct { int b[10]; };
+"
+            );
+            library = new TypeReductionTransformation().Transform(library);
+
+            TranslatedParameter parameter = library.FindDeclaration<TranslatedFunction>("Test").FindDeclaration<TranslatedParameter>("a");
+            Assert.IsType<PointerTypeReference>(parameter.Type);
+
+            TranslatedNormalField field = library.FindDeclaration<TranslatedRecord>("MyStruct").FindDeclaration<TranslatedNormalField>("b");
+            Assert.IsType<ConstantArrayType>(Assert.IsType<ClangTypeReference>(field.Type).ClangType);
+        }
     }
 }